@@ -0,0 +1,155 @@
+//
+//  Replay.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include <Dream/Graphics/GLCapture.h>
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+
+using namespace Dream::Graphics;
+
+namespace
+{
+	EGLDisplay open_display()
+	{
+		EGLDisplay display = EGL_NO_DISPLAY;
+
+#ifdef EGL_PLATFORM_SURFACELESS_MESA
+		// Prefer a display which doesn't need a window system, e.g. Mesa llvmpipe on a build machine:
+		auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+		if (get_platform_display)
+			display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+#endif
+
+		if (display == EGL_NO_DISPLAY)
+			display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+		return display;
+	}
+
+	// Create an off-screen core profile context, matching DREAM_OPENGL32:
+	bool make_headless_context(EGLint width, EGLint height)
+	{
+		EGLDisplay display = open_display();
+
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr))
+			return false;
+
+		const EGLint config_attributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_NONE
+		};
+
+		EGLConfig config;
+		EGLint count = 0;
+
+		if (!eglChooseConfig(display, config_attributes, &config, 1, &count) || count == 0)
+			return false;
+
+		const EGLint surface_attributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE};
+		EGLSurface surface = eglCreatePbufferSurface(display, config, surface_attributes);
+
+		if (surface == EGL_NO_SURFACE)
+			return false;
+
+		if (!eglBindAPI(EGL_OPENGL_API))
+			return false;
+
+		const EGLint context_attributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION_KHR, 3,
+			EGL_CONTEXT_MINOR_VERSION_KHR, 2,
+			EGL_CONTEXT_OPENGL_PROFILE_MASK_KHR, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT_KHR,
+			EGL_NONE
+		};
+
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+
+		if (context == EGL_NO_CONTEXT)
+			return false;
+
+		return eglMakeCurrent(display, surface, surface, context);
+	}
+
+	double percentile(const std::vector<double> & sorted, double fraction)
+	{
+		return sorted[std::min(sorted.size() - 1, (std::size_t)(fraction * sorted.size()))];
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc < 2) {
+		std::cerr << "Usage: " << argv[0] << " capture [iterations] [width height]" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	std::size_t iterations = argc > 2 ? std::atoi(argv[2]) : 10;
+	EGLint width = argc > 4 ? std::atoi(argv[3]) : 1280;
+	EGLint height = argc > 4 ? std::atoi(argv[4]) : 720;
+
+	std::ifstream input(argv[1], std::ios::binary);
+
+	if (!input) {
+		std::cerr << "Could not open " << argv[1] << "!" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	try {
+		GLReplay replay(input);
+
+		if (!make_headless_context(width, height)) {
+			std::cerr << "Could not create a headless context!" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "renderer: " << glGetString(GL_RENDERER) << std::endl;
+
+		// The first frame of a capture creates its resources, so it's reported separately:
+		std::vector<double> setup, frames;
+
+		for (std::size_t i = 0; i < iterations; i += 1) {
+			std::vector<double> durations = replay.replay();
+
+			if (durations.empty())
+				continue;
+
+			setup.push_back(durations.front());
+			frames.insert(frames.end(), durations.begin() + 1, durations.end());
+		}
+
+		if (setup.empty()) {
+			std::cerr << "Capture doesn't contain any frames!" << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "setup: " << std::accumulate(setup.begin(), setup.end(), 0.0) / setup.size() << "ms" << std::endl;
+
+		if (!frames.empty()) {
+			std::sort(frames.begin(), frames.end());
+
+			std::cout << "frames: " << frames.size()
+				<< " min: " << frames.front() << "ms"
+				<< " median: " << percentile(frames, 0.5) << "ms"
+				<< " p95: " << percentile(frames, 0.95) << "ms"
+				<< " average: " << std::accumulate(frames.begin(), frames.end(), 0.0) / frames.size() << "ms"
+				<< " max: " << frames.back() << "ms" << std::endl;
+		}
+	} catch (std::exception & error) {
+		std::cerr << "Replay failed: " << error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,6 @@
+
+compile_executable("dream-graphics-replay") do
+	def source_files(environment)
+		FileList[root, "**/*.cpp"]
+	end
+end
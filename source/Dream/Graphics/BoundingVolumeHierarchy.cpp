@@ -0,0 +1,473 @@
+//
+//  Graphics/BoundingVolumeHierarchy.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "BoundingVolumeHierarchy.h"
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+	#include <xmmintrin.h>
+	#define DREAM_FRUSTUM_SSE
+#endif
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		Frustum::Frustum(const Mat44 & view_projection)
+		{
+			const float * m = view_projection.data();
+
+			// Row i of a column major matrix is (m[i], m[4+i], m[8+i], m[12+i]). Each plane is the last row plus or minus one of the others:
+			for (std::size_t i = 0; i < 6; i += 1) {
+				std::size_t row = i / 2;
+				float sign = (i % 2) ? -1 : 1;
+
+				float x = m[3] + sign * m[row], y = m[7] + sign * m[4 + row], z = m[11] + sign * m[8 + row], w = m[15] + sign * m[12 + row];
+				float length = std::sqrt(x * x + y * y + z * z);
+
+				if (length > 0) {
+					x /= length; y /= length; z /= length; w /= length;
+				}
+
+				_x[i] = x; _y[i] = y; _z[i] = z; _w[i] = w;
+			}
+
+			for (std::size_t i = 6; i < 8; i += 1) {
+				_x[i] = 0; _y[i] = 0; _z[i] = 0; _w[i] = 1;
+			}
+		}
+
+		Frustum Frustum::for_viewport(Ptr<Renderer::IViewport> viewport)
+		{
+			Mat44 view_projection;
+
+			TransformHierarchy::multiply(view_projection, viewport->projection_matrix(), viewport->view_matrix());
+
+			return Frustum(view_projection);
+		}
+
+		Frustum::Classification Frustum::classify(const AlignedBox<3> & box) const
+		{
+			float center[3], extent[3];
+
+			for (std::size_t i = 0; i < 3; i += 1) {
+				center[i] = (box.min()[i] + box.max()[i]) * 0.5f;
+				extent[i] = (box.max()[i] - box.min()[i]) * 0.5f;
+			}
+
+			// For each plane, the signed distance of the center, and the projected radius of the box:
+#ifdef DREAM_FRUSTUM_SSE
+			__m128 cx = _mm_set1_ps(center[0]), cy = _mm_set1_ps(center[1]), cz = _mm_set1_ps(center[2]);
+			__m128 ex = _mm_set1_ps(extent[0]), ey = _mm_set1_ps(extent[1]), ez = _mm_set1_ps(extent[2]);
+			__m128 sign_mask = _mm_set1_ps(-0.0f);
+
+			int outside = 0, intersects = 0;
+
+			for (std::size_t i = 0; i < 8; i += 4) {
+				__m128 x = _mm_loadu_ps(_x + i), y = _mm_loadu_ps(_y + i), z = _mm_loadu_ps(_z + i), w = _mm_loadu_ps(_w + i);
+
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, cx), _mm_mul_ps(y, cy)), _mm_add_ps(_mm_mul_ps(z, cz), w));
+				__m128 radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_andnot_ps(sign_mask, x), ex), _mm_mul_ps(_mm_andnot_ps(sign_mask, y), ey)), _mm_mul_ps(_mm_andnot_ps(sign_mask, z), ez));
+
+				outside |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+				intersects |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(distance, radius), _mm_setzero_ps()));
+			}
+
+			if (outside)
+				return OUTSIDE;
+			else if (intersects)
+				return INTERSECTS;
+			else
+				return INSIDE;
+#else
+			Classification result = INSIDE;
+
+			for (std::size_t i = 0; i < 6; i += 1) {
+				float distance = _x[i] * center[0] + _y[i] * center[1] + _z[i] * center[2] + _w[i];
+				float radius = std::abs(_x[i]) * extent[0] + std::abs(_y[i]) * extent[1] + std::abs(_z[i]) * extent[2];
+
+				if (distance + radius < 0)
+					return OUTSIDE;
+				else if (distance - radius < 0)
+					result = INTERSECTS;
+			}
+
+			return result;
+#endif
+		}
+
+// MARK: -
+
+		namespace
+		{
+			AlignedBox<3> combine(const AlignedBox<3> & a, const AlignedBox<3> & b)
+			{
+				AlignedBox<3> result = a;
+
+				for (std::size_t i = 0; i < 3; i += 1) {
+					result.min()[i] = std::min(a.min()[i], b.min()[i]);
+					result.max()[i] = std::max(a.max()[i], b.max()[i]);
+				}
+
+				return result;
+			}
+
+			float surface_area(const AlignedBox<3> & box)
+			{
+				float x = box.max()[0] - box.min()[0], y = box.max()[1] - box.min()[1], z = box.max()[2] - box.min()[2];
+
+				return 2 * (x * y + y * z + z * x);
+			}
+
+			bool contains(const AlignedBox<3> & outer, const AlignedBox<3> & inner)
+			{
+				for (std::size_t i = 0; i < 3; i += 1) {
+					if (inner.min()[i] < outer.min()[i] || inner.max()[i] > outer.max()[i])
+						return false;
+				}
+
+				return true;
+			}
+		}
+
+		const BoundingVolumeHierarchy::ProxyT BoundingVolumeHierarchy::NONE;
+
+		BoundingVolumeHierarchy::BoundingVolumeHierarchy(float margin) : _margin(margin)
+		{
+		}
+
+		BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+		{
+		}
+
+		BoundingVolumeHierarchy::ProxyT BoundingVolumeHierarchy::allocate()
+		{
+			ProxyT index;
+
+			if (_free != NONE) {
+				index = _free;
+				_free = _entries[index].parent;
+			} else {
+				index = (ProxyT)_entries.size();
+				_entries.push_back(Entry());
+			}
+
+			Entry & entry = _entries[index];
+			entry.node = nullptr;
+			entry.parent = NONE;
+			entry.children[0] = entry.children[1] = NONE;
+			entry.height = 0;
+
+			return index;
+		}
+
+		void BoundingVolumeHierarchy::release(ProxyT index)
+		{
+			_entries[index].parent = _free;
+			_entries[index].height = -1;
+			_free = index;
+		}
+
+		BoundingVolumeHierarchy::ProxyT BoundingVolumeHierarchy::insert(INode * node, const AlignedBox<3> & box)
+		{
+			ProxyT leaf = allocate();
+			Entry & entry = _entries[leaf];
+
+			entry.node = node;
+			entry.box = box;
+
+			for (std::size_t i = 0; i < 3; i += 1) {
+				entry.box.min()[i] -= _margin;
+				entry.box.max()[i] += _margin;
+			}
+
+			insert_leaf(leaf);
+			_count += 1;
+
+			return leaf;
+		}
+
+		void BoundingVolumeHierarchy::remove(ProxyT proxy)
+		{
+			DREAM_ASSERT(_entries[proxy].is_leaf());
+
+			remove_leaf(proxy);
+			release(proxy);
+			_count -= 1;
+		}
+
+		bool BoundingVolumeHierarchy::refit(ProxyT proxy, const AlignedBox<3> & box)
+		{
+			DREAM_ASSERT(_entries[proxy].is_leaf());
+
+			if (contains(_entries[proxy].box, box))
+				return false;
+
+			remove_leaf(proxy);
+
+			Entry & entry = _entries[proxy];
+			entry.box = box;
+
+			for (std::size_t i = 0; i < 3; i += 1) {
+				entry.box.min()[i] -= _margin;
+				entry.box.max()[i] += _margin;
+			}
+
+			insert_leaf(proxy);
+
+			return true;
+		}
+
+		void BoundingVolumeHierarchy::insert_leaf(ProxyT leaf)
+		{
+			if (_root == NONE) {
+				_root = leaf;
+				_entries[leaf].parent = NONE;
+
+				return;
+			}
+
+			const AlignedBox<3> box = _entries[leaf].box;
+
+			// Descend to the sibling which minimises the increase in surface area:
+			ProxyT index = _root;
+			while (!_entries[index].is_leaf()) {
+				const Entry & entry = _entries[index];
+
+				float area = surface_area(entry.box);
+				float combined_area = surface_area(combine(entry.box, box));
+
+				// The cost of making a new parent for this entry and the leaf:
+				float cost = 2 * combined_area;
+
+				// The minimum cost of pushing the leaf further down the tree:
+				float inheritance_cost = 2 * (combined_area - area);
+
+				float child_costs[2];
+				for (std::size_t i = 0; i < 2; i += 1) {
+					const Entry & child = _entries[entry.children[i]];
+
+					if (child.is_leaf())
+						child_costs[i] = surface_area(combine(box, child.box)) + inheritance_cost;
+					else
+						child_costs[i] = surface_area(combine(box, child.box)) - surface_area(child.box) + inheritance_cost;
+				}
+
+				if (cost < child_costs[0] && cost < child_costs[1])
+					break;
+
+				index = entry.children[child_costs[0] < child_costs[1] ? 0 : 1];
+			}
+
+			ProxyT sibling = index;
+			ProxyT old_parent = _entries[sibling].parent;
+			ProxyT new_parent = allocate();
+
+			Entry & parent = _entries[new_parent];
+			parent.parent = old_parent;
+			parent.box = combine(box, _entries[sibling].box);
+			parent.height = _entries[sibling].height + 1;
+			parent.children[0] = sibling;
+			parent.children[1] = leaf;
+
+			if (old_parent != NONE) {
+				Entry & grandparent = _entries[old_parent];
+
+				if (grandparent.children[0] == sibling)
+					grandparent.children[0] = new_parent;
+				else
+					grandparent.children[1] = new_parent;
+			} else {
+				_root = new_parent;
+			}
+
+			_entries[sibling].parent = new_parent;
+			_entries[leaf].parent = new_parent;
+
+			fix_upwards(old_parent);
+		}
+
+		void BoundingVolumeHierarchy::remove_leaf(ProxyT leaf)
+		{
+			if (leaf == _root) {
+				_root = NONE;
+
+				return;
+			}
+
+			ProxyT parent = _entries[leaf].parent;
+			ProxyT grandparent = _entries[parent].parent;
+			ProxyT sibling = _entries[parent].children[0] == leaf ? _entries[parent].children[1] : _entries[parent].children[0];
+
+			// Replace the parent with the sibling:
+			if (grandparent != NONE) {
+				Entry & entry = _entries[grandparent];
+
+				if (entry.children[0] == parent)
+					entry.children[0] = sibling;
+				else
+					entry.children[1] = sibling;
+
+				_entries[sibling].parent = grandparent;
+				release(parent);
+
+				fix_upwards(grandparent);
+			} else {
+				_root = sibling;
+				_entries[sibling].parent = NONE;
+
+				release(parent);
+			}
+		}
+
+		void BoundingVolumeHierarchy::fix_upwards(ProxyT index)
+		{
+			while (index != NONE) {
+				index = balance(index);
+
+				Entry & entry = _entries[index];
+				const Entry & left = _entries[entry.children[0]];
+				const Entry & right = _entries[entry.children[1]];
+
+				entry.height = 1 + std::max(left.height, right.height);
+				entry.box = combine(left.box, right.box);
+
+				index = entry.parent;
+			}
+		}
+
+		BoundingVolumeHierarchy::ProxyT BoundingVolumeHierarchy::balance(ProxyT a)
+		{
+			if (_entries[a].is_leaf() || _entries[a].height < 2)
+				return a;
+
+			ProxyT b = _entries[a].children[0], c = _entries[a].children[1];
+			std::int32_t difference = _entries[c].height - _entries[b].height;
+
+			if (difference >= -1 && difference <= 1)
+				return a;
+
+			// Promote the taller child, making a its child, and give a the shorter of the grandchildren:
+			ProxyT up = difference > 1 ? c : b;
+			ProxyT other = difference > 1 ? b : c;
+
+			ProxyT f = _entries[up].children[0], g = _entries[up].children[1];
+
+			_entries[up].children[0] = a;
+			_entries[up].parent = _entries[a].parent;
+			_entries[a].parent = up;
+
+			if (_entries[up].parent != NONE) {
+				Entry & parent = _entries[_entries[up].parent];
+
+				if (parent.children[0] == a)
+					parent.children[0] = up;
+				else
+					parent.children[1] = up;
+			} else {
+				_root = up;
+			}
+
+			// The taller grandchild stays with the promoted entry:
+			ProxyT keep = _entries[f].height > _entries[g].height ? f : g;
+			ProxyT give = keep == f ? g : f;
+
+			_entries[up].children[1] = keep;
+			_entries[a].children[0] = other;
+			_entries[a].children[1] = give;
+			_entries[give].parent = a;
+
+			Entry & lower = _entries[a];
+			lower.box = combine(_entries[other].box, _entries[give].box);
+			lower.height = 1 + std::max(_entries[other].height, _entries[give].height);
+
+			Entry & upper = _entries[up];
+			upper.box = combine(lower.box, _entries[keep].box);
+			upper.height = 1 + std::max(lower.height, _entries[keep].height);
+
+			return up;
+		}
+
+		template <typename FilterT, typename CallbackT>
+		void BoundingVolumeHierarchy::visit(const Frustum & frustum, FilterT filter, CallbackT callback) const
+		{
+			if (_root == NONE)
+				return;
+
+			_stack.clear();
+			_stack.push_back(_root);
+
+			while (!_stack.empty()) {
+				ProxyT index = _stack.back();
+				_stack.pop_back();
+
+				const Entry & entry = _entries[index];
+				Frustum::Classification classification = frustum.classify(entry.box);
+
+				if (classification == Frustum::OUTSIDE || !filter(entry.box))
+					continue;
+
+				if (entry.is_leaf()) {
+					callback(entry.node);
+				} else if (classification == Frustum::INSIDE) {
+					// Everything below is within the frustum, so only the filter needs to be applied:
+					std::size_t base = _stack.size();
+					_stack.push_back(entry.children[1]);
+					_stack.push_back(entry.children[0]);
+
+					while (_stack.size() > base) {
+						const Entry & inside = _entries[_stack.back()];
+						_stack.pop_back();
+
+						if (!filter(inside.box))
+							continue;
+
+						if (inside.is_leaf()) {
+							callback(inside.node);
+						} else {
+							_stack.push_back(inside.children[1]);
+							_stack.push_back(inside.children[0]);
+						}
+					}
+				} else {
+					_stack.push_back(entry.children[1]);
+					_stack.push_back(entry.children[0]);
+				}
+			}
+		}
+
+		void BoundingVolumeHierarchy::query(const Frustum & frustum, std::vector<INode *> & visible) const
+		{
+			visit(frustum, [](const AlignedBox<3> &) {return true;}, [&](INode * node) {
+				visible.push_back(node);
+			});
+		}
+
+		void BoundingVolumeHierarchy::query(const Frustum & frustum, const OcclusionBuffer & occlusion_buffer, std::vector<INode *> & visible) const
+		{
+			visit(frustum, [&](const AlignedBox<3> & box) {return occlusion_buffer.is_visible(box);}, [&](INode * node) {
+				visible.push_back(node);
+			});
+		}
+
+		void BoundingVolumeHierarchy::traverse(IRenderer * renderer, const Frustum & frustum) const
+		{
+			visit(frustum, [](const AlignedBox<3> &) {return true;}, [&](INode * node) {
+				node->accept(renderer);
+			});
+		}
+
+		void BoundingVolumeHierarchy::clear()
+		{
+			_entries.clear();
+			_root = NONE;
+			_free = NONE;
+			_count = 0;
+		}
+	}
+}
@@ -0,0 +1,135 @@
+//
+//  Graphics/BoundingVolumeHierarchy.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_BOUNDINGVOLUMEHIERARCHY_H
+#define _DREAM_CLIENT_GRAPHICS_BOUNDINGVOLUMEHIERARCHY_H
+
+#include "Renderer.h"
+#include "OcclusionBuffer.h"
+
+#include <Euclid/Geometry/AlignedBox.h>
+#include <Euclid/Numerics/Matrix.h>
+
+#include <cstdint>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		using Euclid::Geometry::AlignedBox;
+		using Euclid::Numerics::Vec3;
+		using Euclid::Numerics::Mat44;
+
+		/// The six clip planes of a view frustum, stored so that a box can be tested against four planes at a time.
+		class Frustum {
+		protected:
+			// Plane components, one array per component, padded to 8 planes with planes which contain everything:
+			float _x[8], _y[8], _z[8], _w[8];
+
+		public:
+			enum Classification {
+				OUTSIDE = 0,
+				INTERSECTS = 1,
+				INSIDE = 2,
+			};
+
+			/// Extract the planes from a column major projection * view matrix.
+			Frustum(const Mat44 & view_projection);
+
+			/// The frustum of the viewport's projection and view matrices.
+			static Frustum for_viewport(Ptr<Renderer::IViewport> viewport);
+
+			Classification classify(const AlignedBox<3> & box) const;
+		};
+
+		/**
+		 A dynamic bounding volume hierarchy of scene nodes, used to find the nodes which are visible in a frustum without testing every node.
+
+		 Leaves store a box which is enlarged by a margin, so nodes which move a small amount don't need to be reinserted, see `refit`. Insertion chooses the sibling which increases the surface area the least, and the tree is rebalanced by rotations as it is modified, so the height stays logarithmic without rebuilding.
+		 */
+		class BoundingVolumeHierarchy : public Object {
+		public:
+			typedef std::uint32_t ProxyT;
+			static const ProxyT NONE = ~(ProxyT)0;
+
+		protected:
+			struct Entry {
+				AlignedBox<3> box;
+				INode * node;
+
+				// The parent, or the next free entry if this entry is not in use:
+				ProxyT parent;
+				ProxyT children[2];
+
+				// Leaves have height 0, and free entries -1:
+				std::int32_t height;
+
+				bool is_leaf() const { return children[0] == NONE; }
+			};
+
+			std::vector<Entry> _entries;
+			ProxyT _root = NONE;
+			ProxyT _free = NONE;
+			std::size_t _count = 0;
+
+			float _margin;
+
+			// Reused between queries:
+			mutable std::vector<ProxyT> _stack;
+
+			ProxyT allocate();
+			void release(ProxyT proxy);
+
+			void insert_leaf(ProxyT leaf);
+			void remove_leaf(ProxyT leaf);
+
+			// Perform a rotation at the given entry if it is unbalanced, returning the root of the rotated subtree:
+			ProxyT balance(ProxyT index);
+
+			// Walk from the given entry to the root, refitting boxes and rebalancing:
+			void fix_upwards(ProxyT index);
+
+			// Visit the leaves within the frustum. Subtrees are skipped if their box is rejected by the filter:
+			template <typename FilterT, typename CallbackT>
+			void visit(const Frustum & frustum, FilterT filter, CallbackT callback) const;
+
+		public:
+			/// Leaf boxes are enlarged by the given margin on every side.
+			BoundingVolumeHierarchy(float margin = 0.1);
+			virtual ~BoundingVolumeHierarchy();
+
+			/// Add a node with the given bounds.
+			ProxyT insert(INode * node, const AlignedBox<3> & box);
+
+			void remove(ProxyT proxy);
+
+			/// Update the bounds of a node which has moved. Returns true if the node was reinserted, or false if it is still within its enlarged box.
+			bool refit(ProxyT proxy, const AlignedBox<3> & box);
+
+			INode * node(ProxyT proxy) const { return _entries[proxy].node; }
+
+			/// The enlarged box of the given node.
+			const AlignedBox<3> & box(ProxyT proxy) const { return _entries[proxy].box; }
+
+			/// Append all nodes whose boxes intersect the frustum.
+			void query(const Frustum & frustum, std::vector<INode *> & visible) const;
+
+			/// Append all nodes whose boxes intersect the frustum and are not hidden in the occlusion buffer, which must already be rasterised.
+			void query(const Frustum & frustum, const OcclusionBuffer & occlusion_buffer, std::vector<INode *> & visible) const;
+
+			/// Pass all nodes whose boxes intersect the frustum to the renderer. Subtrees outside the frustum are skipped entirely.
+			void traverse(IRenderer * renderer, const Frustum & frustum) const;
+
+			std::size_t size() const { return _count; }
+
+			/// The height of the tree, where a single leaf has height 0.
+			std::size_t height() const { return _root == NONE ? 0 : _entries[_root].height; }
+
+			void clear();
+		};
+	}
+}
+
+#endif
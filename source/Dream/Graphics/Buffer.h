@@ -10,6 +10,7 @@
 #define _DREAM_CLIENT_GRAPHICS_BUFFER_H
 
 #include "Graphics.h"
+#include "FrameStats.h"
 
 #ifdef DREAM_OPENGLES2
 #define glMapBuffer glMapBufferOES
@@ -61,7 +62,7 @@ namespace Dream
 
 				glBindBuffer(TARGET, _handle);
 
-				check_graphics_error();
+				DREAM_CHECK_GRAPHICS_ERROR();
 			}
 
 			void unbind() {
@@ -69,7 +70,7 @@ namespace Dream
 
 				glBindBuffer(TARGET, 0);
 
-				check_graphics_error();
+				DREAM_CHECK_GRAPHICS_ERROR();
 			}
 
 			/// The data size in bytes.
@@ -88,6 +89,10 @@ namespace Dream
 				glDeleteBuffers(1, &_handle);
 			}
 
+			GLuint handle() const {
+				return _handle;
+			}
+
 			GLenum usage() const {
 				return _usage;
 			}
@@ -139,9 +144,11 @@ namespace Dream
 				}
 
 				void set_data(const ElementT * data, std::size_t size) {
-					_buffer_handle->_size = size;
+					_buffer_handle->_size = byte_offset(size);
 
 					glBufferData(TARGET, byte_offset(size), data, _buffer_handle->usage());
+
+					FrameStats::count(FrameStats::BUFFER_BYTES, byte_offset(size));
 				}
 
 				template <typename ArrayT>
@@ -151,14 +158,21 @@ namespace Dream
 
 				void set_partial_data(const void * data, std::size_t offset, std::size_t size) {
 					glBufferSubData(TARGET, byte_offset(offset), byte_offset(size), data);
+
+					FrameStats::count(FrameStats::BUFFER_BYTES, byte_offset(size));
 				}
 
+				// Mapped buffers are counted as if they were entirely uploaded:
 				ElementT * map(GLenum access = GL_WRITE_ONLY) {
+					FrameStats::count(FrameStats::BUFFER_BYTES, _buffer_handle->size());
+
 					return (ElementT *)glMapBuffer(TARGET, access);
 				}
 
 				ElementT * map(std::size_t offset, std::size_t size, GLenum access = GL_WRITE_ONLY) {
-					DREAM_ASSERT(offset + size < _buffer_handle->size());
+					DREAM_ASSERT((std::size_t)byte_offset(offset + size) <= _buffer_handle->size());
+
+					FrameStats::count(FrameStats::BUFFER_BYTES, byte_offset(size));
 
 					return (ElementT *)glMapBufferRange(TARGET, byte_offset(offset), byte_offset(size), access);
 				}
@@ -168,7 +182,7 @@ namespace Dream
 				}
 
 				BufferedArray<ElementT> array(GLenum access = GL_WRITE_ONLY) {
-					return BufferedArray<ElementT>((ElementT *)map(access), _buffer_handle->size());
+					return BufferedArray<ElementT>((ElementT *)map(access), size());
 				}
 
 				BufferedArray<ElementT> array(std::size_t offset, std::size_t size, GLenum acccess = GL_WRITE_ONLY) {
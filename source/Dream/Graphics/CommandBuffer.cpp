@@ -0,0 +1,174 @@
+//
+//  Graphics/CommandBuffer.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "CommandBuffer.h"
+
+#include <cstring>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		static thread_local CommandBuffer * _current_command_buffer = nullptr;
+
+		CommandBuffer * CommandBuffer::current()
+		{
+			return _current_command_buffer;
+		}
+
+		CommandBuffer::Recording::Recording(CommandBuffer * command_buffer) : _previous(_current_command_buffer)
+		{
+			_current_command_buffer = command_buffer;
+		}
+
+		CommandBuffer::Recording::~Recording()
+		{
+			_current_command_buffer = _previous;
+		}
+
+// MARK: -
+
+		CommandBuffer::CommandBuffer()
+		{
+		}
+
+		CommandBuffer::~CommandBuffer()
+		{
+		}
+
+		void CommandBuffer::bind(Ptr<Program> program)
+		{
+			if (program.get() == _program)
+				return;
+
+			_program = program.get();
+
+			Command command;
+			command.opcode = Opcode::BIND_PROGRAM;
+			command.program = _program;
+
+			_commands.push_back(command);
+		}
+
+		void CommandBuffer::bind(VertexArray * vertex_array)
+		{
+			Command command;
+			command.opcode = Opcode::BIND_VERTEX_ARRAY;
+			command.vertex_array = vertex_array;
+
+			_commands.push_back(command);
+		}
+
+		void CommandBuffer::bind(GLuint unit, Ptr<Texture> texture)
+		{
+			Command command;
+			command.opcode = Opcode::BIND_TEXTURE;
+			command.texture = {texture.get(), unit};
+
+			_commands.push_back(command);
+		}
+
+		void CommandBuffer::set_uniform(const UniformName & name, GLenum type, GLsizei count, const void * data, std::size_t size)
+		{
+			DREAM_ASSERT(_program != nullptr);
+
+			Command command;
+			command.opcode = Opcode::SET_UNIFORM;
+			command.uniform = {name.identifier(), type, count, (std::uint32_t)_arena.size(), (std::uint32_t)size};
+
+			_arena.insert(_arena.end(), (const ByteT *)data, (const ByteT *)data + size);
+			_commands.push_back(command);
+		}
+
+		void CommandBuffer::draw_arrays(GLenum mode, GLint first, GLsizei count)
+		{
+			Command command;
+			command.opcode = Opcode::DRAW_ARRAYS;
+			command.arrays = {mode, first, count};
+
+			_commands.push_back(command);
+		}
+
+		void CommandBuffer::draw_elements(GLenum mode, GLsizei count, GLenum type, std::size_t offset)
+		{
+			Command command;
+			command.opcode = Opcode::DRAW_ELEMENTS;
+			command.elements = {mode, type, count, offset};
+
+			_commands.push_back(command);
+		}
+
+		void CommandBuffer::replay(Ptr<TextureManager> texture_manager) const
+		{
+			Program * program = nullptr;
+			VertexArray * vertex_array = nullptr;
+
+			for (auto & command : _commands) {
+				switch (command.opcode) {
+					case Opcode::BIND_PROGRAM:
+						program = command.program;
+						program->enable();
+						break;
+
+					case Opcode::BIND_VERTEX_ARRAY:
+						if (command.vertex_array != vertex_array) {
+							vertex_array = command.vertex_array;
+							vertex_array->bind();
+						}
+						break;
+
+					case Opcode::BIND_TEXTURE:
+						if (texture_manager) {
+							texture_manager->bind(command.texture.unit, command.texture.texture);
+						} else {
+							glActiveTexture(GL_TEXTURE0 + command.texture.unit);
+							glBindTexture(command.texture.texture->target(), command.texture.texture->handle());
+
+							FrameStats::count(FrameStats::TEXTURE_BINDS);
+						}
+						break;
+
+					case Opcode::SET_UNIFORM: {
+						const UniformArguments & uniform = command.uniform;
+						const ByteT * data = _arena.data() + uniform.offset;
+
+						// The program's shadow copy still skips redundant uploads:
+						GLint location = program->update_uniform(UniformName::for_identifier(uniform.name), data, uniform.size);
+
+						if (location != -1)
+							upload_uniform(location, uniform.type, uniform.count, data);
+
+						break;
+					}
+
+					case Opcode::DRAW_ARRAYS:
+						glDrawArrays(command.arrays.mode, command.arrays.first, command.arrays.count);
+						FrameStats::count_draw(command.arrays.mode, command.arrays.count);
+						break;
+
+					case Opcode::DRAW_ELEMENTS:
+						glDrawElements(command.elements.mode, command.elements.count, command.elements.type, (const GLvoid *)command.elements.offset);
+						FrameStats::count_draw(command.elements.mode, command.elements.count);
+						break;
+				}
+			}
+
+			if (vertex_array)
+				vertex_array->unbind();
+
+			if (program)
+				program->disable();
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void CommandBuffer::clear()
+		{
+			_commands.clear();
+			_arena.clear();
+			_program = nullptr;
+		}
+	}
+}
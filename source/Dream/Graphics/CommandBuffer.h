@@ -0,0 +1,137 @@
+//
+//  Graphics/CommandBuffer.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_COMMANDBUFFER_H
+#define _DREAM_CLIENT_GRAPHICS_COMMANDBUFFER_H
+
+#include "ShaderManager.h"
+#include "TextureManager.h"
+#include "VertexArray.h"
+
+#include <cstdint>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 A list of draw commands which can be recorded on any thread and replayed later on the thread which owns the context.
+
+		 Commands are small fixed size records. Uniform values are copied into an arena owned by the buffer, so the caller doesn't need to keep them alive. Programs, textures and vertex arrays are not retained: they must remain valid until the buffer has been replayed.
+
+		 A buffer must only be recorded by one thread at a time. Clearing a buffer keeps its storage, so reusing it every frame doesn't allocate.
+		 */
+		class CommandBuffer : public Object {
+		public:
+			enum class Opcode : std::uint8_t {
+				BIND_PROGRAM, BIND_VERTEX_ARRAY, BIND_TEXTURE, SET_UNIFORM, DRAW_ARRAYS, DRAW_ELEMENTS
+			};
+
+		protected:
+			struct TextureArguments {
+				Texture * texture;
+				GLuint unit;
+			};
+
+			struct UniformArguments {
+				UniformName::IdentifierT name;
+				GLenum type;
+				GLsizei count;
+
+				// The value in the arena:
+				std::uint32_t offset, size;
+			};
+
+			struct ArraysArguments {
+				GLenum mode;
+				GLint first;
+				GLsizei count;
+			};
+
+			struct ElementsArguments {
+				GLenum mode;
+				GLenum type;
+				GLsizei count;
+				std::size_t offset;
+			};
+
+			struct Command {
+				Opcode opcode;
+
+				union {
+					Program * program;
+					VertexArray * vertex_array;
+					TextureArguments texture;
+					UniformArguments uniform;
+					ArraysArguments arrays;
+					ElementsArguments elements;
+				};
+			};
+
+			std::vector<Command> _commands;
+			std::vector<ByteT> _arena;
+
+			// The last recorded program, to skip redundant binds:
+			Program * _program = nullptr;
+
+			void set_uniform(const UniformName & name, GLenum type, GLsizei count, const void * data, std::size_t size);
+
+		public:
+			CommandBuffer();
+			virtual ~CommandBuffer();
+
+			void bind(Ptr<Program> program);
+			void bind(VertexArray * vertex_array);
+			void bind(GLuint unit, Ptr<Texture> texture);
+
+			/// Uniforms apply to the most recently bound program.
+			void set_uniform(const UniformName & name, const GLfloat & value) { set_uniform(name, GL_FLOAT, 1, &value, sizeof(value)); }
+			void set_uniform(const UniformName & name, const GLint & value) { set_uniform(name, GL_INT, 1, &value, sizeof(value)); }
+
+			template <dimension E>
+			void set_uniform(const UniformName & name, const Vector<E, GLfloat> & vector) {
+				static const GLenum TYPES[] = {GL_FLOAT, GL_FLOAT_VEC2, GL_FLOAT_VEC3, GL_FLOAT_VEC4};
+				static_assert(E >= 1 && E <= 4, "Uniform vectors have between 1 and 4 elements!");
+
+				set_uniform(name, TYPES[E - 1], 1, vector.data(), sizeof(GLfloat) * E);
+			}
+
+			template <dimension N>
+			void set_uniform(const UniformName & name, const Matrix<N, N, GLfloat> & matrix) {
+				static const GLenum TYPES[] = {GL_FLOAT_MAT2, GL_FLOAT_MAT3, GL_FLOAT_MAT4};
+				static_assert(N >= 2 && N <= 4, "Uniform matrices are between 2x2 and 4x4!");
+
+				set_uniform(name, TYPES[N - 2], 1, matrix.data(), sizeof(GLfloat) * N * N);
+			}
+
+			void draw_arrays(GLenum mode, GLint first, GLsizei count);
+			void draw_elements(GLenum mode, GLsizei count, GLenum type, std::size_t offset = 0);
+
+			/// Issue all commands on the current thread, which must own the context. If a texture manager is given, it is used to bind textures, so its state remains consistent.
+			void replay(Ptr<TextureManager> texture_manager = nullptr) const;
+
+			/// Discard all commands, keeping the storage for reuse.
+			void clear();
+
+			std::size_t size() const { return _commands.size(); }
+			std::size_t arena_size() const { return _arena.size(); }
+
+			/// The buffer which the current thread is recording into, e.g. during IRenderer::traverse_parallel, or NULL.
+			static CommandBuffer * current();
+
+			/// Make the buffer current for the lifetime of this object.
+			class Recording : private NonCopyable {
+			protected:
+				CommandBuffer * _previous;
+
+			public:
+				Recording(CommandBuffer * command_buffer);
+				~Recording();
+			};
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,176 @@
+//
+//  Graphics/FeedbackParticleRenderer.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "FeedbackParticleRenderer.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		// The geometry shader only emits particles which are still alive, which compacts the captured buffer.
+		static const char * DEFAULT_UPDATE_SHADER =
+			"@shader\n"
+			"#version 150\n"
+			"@vertex\n"
+			"in vec3 position;\n"
+			"in vec3 velocity;\n"
+			"in vec4 color;\n"
+			"in vec2 lifetime;\n"
+			"uniform float delta_time;\n"
+			"uniform vec3 force;\n"
+			"out vec3 vertex_position;\n"
+			"out vec3 vertex_velocity;\n"
+			"out vec4 vertex_color;\n"
+			"out vec2 vertex_lifetime;\n"
+			"void main() {\n"
+			"	vertex_position = position + (velocity * delta_time) + (force * delta_time * delta_time * 0.5);\n"
+			"	vertex_velocity = velocity + (force * delta_time);\n"
+			"	vertex_color = color;\n"
+			"	vertex_lifetime = vec2(lifetime.x, lifetime.y + delta_time);\n"
+			"}\n"
+			"@geometry\n"
+			"layout(points) in;\n"
+			"layout(points, max_vertices = 1) out;\n"
+			"in vec3 vertex_position[];\n"
+			"in vec3 vertex_velocity[];\n"
+			"in vec4 vertex_color[];\n"
+			"in vec2 vertex_lifetime[];\n"
+			"out vec3 feedback_position;\n"
+			"out vec3 feedback_velocity;\n"
+			"out vec4 feedback_color;\n"
+			"out vec2 feedback_lifetime;\n"
+			"void main() {\n"
+			"	if (vertex_lifetime[0].y < vertex_lifetime[0].x) {\n"
+			"		feedback_position = vertex_position[0];\n"
+			"		feedback_velocity = vertex_velocity[0];\n"
+			"		feedback_color = vertex_color[0];\n"
+			"		feedback_lifetime = vertex_lifetime[0];\n"
+			"		EmitVertex();\n"
+			"		EndPrimitive();\n"
+			"	}\n"
+			"}\n";
+
+		FeedbackParticleRenderer::FeedbackParticleRenderer(std::size_t capacity) : _capacity(capacity), _schedule(capacity), _spawn_buffer(GL_STREAM_DRAW) {
+			for (auto & state : _states) {
+				{
+					auto binding = state.buffer.binding();
+					binding.resize(_capacity);
+				}
+
+				associate_attributes(state.vertex_array, state.buffer);
+
+				state.feedback.bind();
+				state.feedback.attach(0, state.buffer);
+				state.feedback.unbind();
+			}
+
+			associate_attributes(_spawn_array, _spawn_buffer);
+
+			logger()->log(LOG_DEBUG, LogBuffer() << "Allocating " << (_capacity * sizeof(Particle) * 2) << " bytes to feedback particle renderer for " << _capacity << " particles.");
+		}
+
+		FeedbackParticleRenderer::~FeedbackParticleRenderer() {
+		}
+
+		void FeedbackParticleRenderer::associate_attributes(VertexArray & vertex_array, VertexBuffer<Particle> & buffer) {
+			auto binding = vertex_array.binding();
+
+			auto attributes = binding.attach(buffer);
+			attributes[POSITION] = &Particle::position;
+			attributes[VELOCITY] = &Particle::velocity;
+			attributes[COLOR] = &Particle::color;
+			attributes[LIFETIME] = &Particle::lifetime;
+		}
+
+		void FeedbackParticleRenderer::prepare(Ptr<Program> program) {
+			program->set_attribute_location("position", POSITION);
+			program->set_attribute_location("velocity", VELOCITY);
+			program->set_attribute_location("color", COLOR);
+			program->set_attribute_location("lifetime", LIFETIME);
+
+			// The varyings are interleaved, so they must be in the same order as the members of Particle:
+			program->set_feedback_varyings({"feedback_position", "feedback_velocity", "feedback_color", "feedback_lifetime"}, GL_INTERLEAVED_ATTRIBS);
+		}
+
+		Ref<Program> FeedbackParticleRenderer::load_program(Ptr<ShaderManager> shader_manager, Ptr<ShaderFactory> shader_factory, const ShaderParser::DefinesMapT * defines) {
+			Ref<Program> program = new Program;
+
+			prepare(program);
+			shader_factory->attach(shader_manager, program, defines);
+
+			if (!program->link())
+				throw ShaderError("Could not link particle update program!");
+
+			return program;
+		}
+
+		Ref<Program> FeedbackParticleRenderer::load_program(Ptr<ShaderManager> shader_manager) {
+			Ref<ShaderFactory> shader_factory = new ShaderFactory(StaticBuffer::for_cstring(DEFAULT_UPDATE_SHADER));
+
+			return load_program(shader_manager, shader_factory);
+		}
+
+		void FeedbackParticleRenderer::update(RealT dt, const Vec3 & force) {
+			DREAM_ASSERT(_update_program);
+
+			// If there is nothing to simulate, bail out quickly.
+			if (!_schedule.pending())
+				return;
+
+			Schedule::Pass pass = _schedule.pass();
+
+			State & source = _states[pass.source];
+			State & destination = _states[pass.destination];
+
+			auto program_binding = _update_program->binding();
+			program_binding.set_uniform("force", force);
+
+			// We only want the captured output, so nothing is rasterized:
+			glEnable(GL_RASTERIZER_DISCARD);
+
+			destination.feedback.bind();
+			destination.feedback.begin(GL_POINTS);
+
+			if (pass.simulate) {
+				program_binding.set_uniform("delta_time", (GLfloat)dt);
+
+				auto binding = source.vertex_array.binding();
+				binding.draw_transform_feedback(GL_POINTS, source.feedback.handle());
+			}
+
+			if (pass.spawn_count) {
+				// Newly emitted particles are appended to the same capture without being integrated:
+				program_binding.set_uniform("delta_time", (GLfloat)0);
+
+				{
+					auto binding = _spawn_buffer.binding();
+					binding.set_data(_schedule.spawn());
+				}
+
+				auto binding = _spawn_array.binding();
+				binding.draw_arrays(GL_POINTS, 0, (GLsizei)pass.spawn_count);
+			}
+
+			destination.feedback.end();
+			destination.feedback.unbind();
+
+			glDisable(GL_RASTERIZER_DISCARD);
+
+			_schedule.complete();
+		}
+
+		void FeedbackParticleRenderer::draw(GLenum mode) {
+			if (!_schedule.captured())
+				return;
+
+			State & state = _states[_schedule.current()];
+
+			auto binding = state.vertex_array.binding();
+			binding.draw_transform_feedback(mode, state.feedback.handle());
+		}
+#endif
+	}
+}
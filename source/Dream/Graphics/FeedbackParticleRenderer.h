@@ -0,0 +1,165 @@
+//
+//  Graphics/FeedbackParticleRenderer.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_FEEDBACKPARTICLERENDERER_H
+#define _DREAM_CLIENT_GRAPHICS_FEEDBACKPARTICLERENDERER_H
+
+#include "Graphics.h"
+#include "VertexArray.h"
+#include "TransformFeedback.h"
+#include "ShaderFactory.h"
+
+#include <Euclid/Numerics/Vector.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		using namespace Euclid::Numerics::Constants;
+		using Euclid::Numerics::Vec2;
+		using Euclid::Numerics::Vec3;
+		using Euclid::Numerics::Vec4;
+
+		/**
+		 An alternative to ParticleRenderer which keeps the entire simulation on the GPU. Particle state is ping-ponged between two buffers using transform feedback: the update program integrates each particle in the vertex shader, and a geometry shader only emits particles which are still alive, so the destination buffer is compacted as it is written.
+
+		 New particles are appended from a small CPU-filled spawn buffer during the same transform feedback pass. Drawing uses the captured buffer directly with glDrawTransformFeedback, so nothing is uploaded per-particle per-frame and the live particle count never needs to be read back.
+
+		 This only requires OpenGL 3.2 (GLSL 1.50) and ARB_transform_feedback2, which are both available with Mesa llvmpipe.
+		 */
+		class FeedbackParticleRenderer : public Object {
+		public:
+			struct Particle {
+				Vec3 position;
+				Vec3 velocity;
+				Vec4 color;
+
+				// The total life and current age of the particle, in seconds:
+				Vec2 lifetime;
+			};
+
+			enum Attributes {
+				POSITION = 0,
+				VELOCITY = 1,
+				COLOR = 2,
+				LIFETIME = 3
+			};
+
+			/// Tracks which state buffer is current, whether it has been captured, and the particles waiting to be spawned. It doesn't use OpenGL, so it can be tested on its own.
+			class Schedule {
+			public:
+				/// The work done by one transform feedback pass.
+				struct Pass {
+					std::size_t source, destination;
+
+					// Whether the source state holds live particles which should be integrated:
+					bool simulate;
+
+					std::size_t spawn_count;
+				};
+
+			protected:
+				std::size_t _capacity;
+				std::size_t _current = 0;
+				bool _captured = false;
+
+				std::vector<Particle> _spawn;
+
+			public:
+				Schedule(std::size_t capacity) : _capacity(capacity) {}
+
+				/// Queue a particle for the next pass. Returns false and drops the particle if the capacity is already queued, as it couldn't be captured anyway.
+				bool emit(const Particle & particle) {
+					if (_spawn.size() >= _capacity)
+						return false;
+
+					_spawn.push_back(particle);
+
+					return true;
+				}
+
+				const std::vector<Particle> & spawn() const { return _spawn; }
+
+				/// The state which holds the most recently captured particles.
+				std::size_t current() const { return _current; }
+
+				/// Whether the current state has been captured at least once and can be drawn.
+				bool captured() const { return _captured; }
+
+				/// Whether there is anything to simulate or spawn.
+				bool pending() const { return _captured || !_spawn.empty(); }
+
+				Pass pass() const {
+					return Pass{_current, _current ^ 1, _captured, _spawn.size()};
+				}
+
+				/// The destination of the pass becomes the current state, and the spawned particles are consumed.
+				void complete() {
+					_current ^= 1;
+					_captured = true;
+					_spawn.clear();
+				}
+			};
+
+		protected:
+			struct State {
+				VertexBuffer<Particle> buffer;
+				VertexArray vertex_array;
+				TransformFeedback feedback;
+
+				State() : buffer(GL_DYNAMIC_COPY) {}
+			};
+
+			std::size_t _capacity;
+
+			// The particle state is read from one buffer and captured into the other:
+			State _states[2];
+			Schedule _schedule;
+
+			VertexBuffer<Particle> _spawn_buffer;
+			VertexArray _spawn_array;
+
+			Ref<Program> _update_program;
+
+			static void associate_attributes(VertexArray & vertex_array, VertexBuffer<Particle> & buffer);
+
+		public:
+			/// The capacity is the maximum number of live particles. Particles which don't fit in the destination buffer are discarded by the transform feedback pass.
+			FeedbackParticleRenderer(std::size_t capacity);
+			virtual ~FeedbackParticleRenderer();
+
+			/// Bind the attribute locations and feedback varyings required by an update program. This must be done before the program is linked.
+			static void prepare(Ptr<Program> program);
+
+			/// Build an update program from the given factory.
+			static Ref<Program> load_program(Ptr<ShaderManager> shader_manager, Ptr<ShaderFactory> shader_factory, const ShaderParser::DefinesMapT * defines = nullptr);
+
+			/// Build the built-in update program, which implements the same integration as ParticleRenderer::Particle::update_time.
+			static Ref<Program> load_program(Ptr<ShaderManager> shader_manager);
+
+			void set_update_program(Ptr<Program> program) { _update_program = program; }
+			Ptr<Program> update_program() const { return _update_program; }
+
+			std::size_t capacity() const { return _capacity; }
+
+			/// Queue a particle to be appended during the next update. At most the capacity can be queued per update.
+			bool emit(const Particle & particle) { return _schedule.emit(particle); }
+
+			/// Integrate all live particles, remove dead ones and append any newly emitted particles.
+			void update(RealT dt, const Vec3 & force = ZERO);
+
+			void update_for_duration(TimeT last_time, TimeT current_time, TimeT dt) {
+				update(dt);
+			}
+
+			/// Draw the live particles from the captured state buffer. The draw program should use the same attribute locations, and typically expands each point into a quad.
+			void draw(GLenum mode = GL_POINTS);
+		};
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,150 @@
+//
+//  Graphics/FileWatcher.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "FileWatcher.h"
+
+#include <sys/stat.h>
+
+#if TARGET_OS_LINUX
+	#include <sys/inotify.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+#endif
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		static std::time_t modification_time(const StringT & path)
+		{
+			struct stat status;
+
+			if (stat(path.c_str(), &status) == 0)
+				return status.st_mtime;
+			else
+				return 0;
+		}
+
+		// The directory part of the path including the trailing separator, so that it can be joined with a file name:
+		static StringT directory_prefix(const StringT & path)
+		{
+			std::size_t separator = path.rfind('/');
+
+			if (separator == StringT::npos)
+				return "";
+			else
+				return path.substr(0, separator + 1);
+		}
+
+		FileWatcher::FileWatcher(ClockT::duration poll_interval, bool notifications) : _poll_interval(poll_interval), _last_poll(ClockT::now())
+		{
+#if TARGET_OS_LINUX
+			if (!notifications)
+				return;
+
+			_notify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+			if (_notify == -1)
+				logger()->log(LOG_WARN, LogBuffer() << "Could not initialize inotify, polling for file changes instead.");
+#endif
+		}
+
+		FileWatcher::~FileWatcher()
+		{
+#if TARGET_OS_LINUX
+			if (_notify != -1)
+				close(_notify);
+#endif
+		}
+
+		void FileWatcher::watch(const StringT & path)
+		{
+			if (_files.count(path))
+				return;
+
+			_files[path] = modification_time(path);
+
+#if TARGET_OS_LINUX
+			if (_notify != -1) {
+				StringT directory = directory_prefix(path);
+
+				// Adding the same directory again returns the existing watch descriptor:
+				int descriptor = inotify_add_watch(_notify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+				if (descriptor != -1)
+					_directories[descriptor] = directory;
+				else
+					logger()->log(LOG_WARN, LogBuffer() << "Could not watch directory " << directory << " for changes.");
+			}
+#endif
+		}
+
+		FileWatcher::PathsT FileWatcher::poll()
+		{
+			if (_notify != -1)
+				return poll_notifications();
+			else
+				return poll_modification_times();
+		}
+
+		FileWatcher::PathsT FileWatcher::poll_notifications()
+		{
+			PathsT changed;
+
+#if TARGET_OS_LINUX
+			// Large enough for many events, and aligned as required by inotify:
+			alignas(struct inotify_event) char buffer[4096];
+
+			while (true) {
+				ssize_t length = read(_notify, buffer, sizeof(buffer));
+
+				if (length <= 0)
+					break;
+
+				for (char * current = buffer; current < buffer + length;) {
+					struct inotify_event * event = (struct inotify_event *)current;
+
+					auto directory = _directories.find(event->wd);
+
+					if (directory != _directories.end() && event->len > 0) {
+						StringT path = directory->second + event->name;
+
+						// Other files in the same directory are ignored:
+						if (_files.count(path))
+							changed.insert(path);
+					}
+
+					current += sizeof(struct inotify_event) + event->len;
+				}
+			}
+#endif
+
+			return changed;
+		}
+
+		FileWatcher::PathsT FileWatcher::poll_modification_times()
+		{
+			PathsT changed;
+
+			ClockT::time_point now = ClockT::now();
+
+			if (now - _last_poll < _poll_interval)
+				return changed;
+
+			_last_poll = now;
+
+			for (auto & pair : _files) {
+				std::time_t current = modification_time(pair.first);
+
+				if (current != pair.second) {
+					pair.second = current;
+					changed.insert(pair.first);
+				}
+			}
+
+			return changed;
+		}
+	}
+}
@@ -0,0 +1,63 @@
+//
+//  Graphics/FileWatcher.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_FILEWATCHER_H
+#define _DREAM_CLIENT_GRAPHICS_FILEWATCHER_H
+
+#include <Dream/Framework.h>
+
+#include <map>
+#include <set>
+#include <chrono>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 Reports files which have changed on disk, e.g. to reload shaders while the application is running.
+
+		 On Linux, inotify is used to watch the directory containing each file, as many editors save by replacing the file rather than writing to it. Elsewhere, or if inotify is unavailable, modification times are polled.
+		 */
+		class FileWatcher : public Object, private NonCopyable {
+		public:
+			typedef std::set<StringT> PathsT;
+			typedef std::chrono::steady_clock ClockT;
+
+		protected:
+			// The last known modification time of each watched file, used when polling:
+			std::map<StringT, std::time_t> _files;
+
+			ClockT::duration _poll_interval;
+			ClockT::time_point _last_poll;
+
+			int _notify = -1;
+
+			// The directory, including a trailing separator, for each watch descriptor:
+			std::map<int, StringT> _directories;
+
+			PathsT poll_notifications();
+			PathsT poll_modification_times();
+
+		public:
+			/// The poll interval only applies when modification times are polled. If notifications are disabled, modification times are always polled.
+			FileWatcher(ClockT::duration poll_interval = std::chrono::milliseconds(500), bool notifications = true);
+			virtual ~FileWatcher();
+
+			/// Start watching the given file. Watching the same file again has no effect.
+			void watch(const StringT & path);
+
+			bool watching(const StringT & path) const { return _files.count(path) != 0; }
+
+			/// Whether changes are reported by the operating system rather than by polling.
+			bool notifications() const { return _notify != -1; }
+
+			/// Return all watched files which changed since the last call. This never blocks.
+			PathsT poll();
+		};
+	}
+}
+
+#endif
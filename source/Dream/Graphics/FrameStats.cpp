@@ -0,0 +1,194 @@
+//
+//  Graphics/FrameStats.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "FrameStats.h"
+
+#include <algorithm>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		FrameStats::CountersT FrameStats::_counters = {{}};
+
+		FrameStats::FrameStats(std::size_t window) : _window(std::max<std::size_t>(window, 1))
+		{
+			_history.reserve(_window);
+		}
+
+		FrameStats::~FrameStats()
+		{
+		}
+
+		void FrameStats::count_draw(GLenum mode, std::size_t vertex_count)
+		{
+			std::size_t primitives = 0;
+
+			switch (mode) {
+				case GL_POINTS:
+					primitives = vertex_count;
+					break;
+				case GL_LINES:
+					primitives = vertex_count / 2;
+					break;
+				case GL_LINE_STRIP:
+					primitives = vertex_count > 1 ? vertex_count - 1 : 0;
+					break;
+				case GL_LINE_LOOP:
+					primitives = vertex_count > 1 ? vertex_count : 0;
+					break;
+				case GL_TRIANGLES:
+					primitives = vertex_count / 3;
+					break;
+				case GL_TRIANGLE_STRIP:
+				case GL_TRIANGLE_FAN:
+					primitives = vertex_count > 2 ? vertex_count - 2 : 0;
+					break;
+			}
+
+			_counters[DRAW_CALLS] += 1;
+			_counters[PRIMITIVES] += primitives;
+		}
+
+		const char * FrameStats::name(Counter counter)
+		{
+			switch (counter) {
+				case DRAW_CALLS: return "draw_calls";
+				case PRIMITIVES: return "primitives";
+				case BUFFER_BYTES: return "buffer_bytes";
+				case TEXTURE_BYTES: return "texture_bytes";
+				case PROGRAM_BINDS: return "program_binds";
+				case VERTEX_ARRAY_BINDS: return "vertex_array_binds";
+				case TEXTURE_BINDS: return "texture_binds";
+				case ERROR_CHECKS: return "error_checks";
+				case UNIFORM_UPLOADS: return "uniform_uploads";
+				case UNIFORM_SKIPPED: return "uniform_skipped";
+				default: return "unknown";
+			}
+		}
+
+		void FrameStats::end_frame()
+		{
+			if (_history.size() < _window)
+				_history.push_back(_counters);
+			else
+				_history[_next] = _counters;
+
+			_next = (_next + 1) % _window;
+			_frame_count += 1;
+
+			_counters.fill(0);
+		}
+
+		const FrameStats::CountersT & FrameStats::last() const
+		{
+			static const CountersT EMPTY = {{}};
+
+			if (_history.empty())
+				return EMPTY;
+
+			return _history[(_next + _window - 1) % _window];
+		}
+
+		FrameStats::Summary FrameStats::summary(Counter counter) const
+		{
+			Summary summary;
+
+			if (_history.empty())
+				return summary;
+
+			std::vector<std::uint64_t> values;
+			values.reserve(_history.size());
+
+			for (auto & counters : _history)
+				values.push_back(counters[counter]);
+
+			std::sort(values.begin(), values.end());
+
+			summary.minimum = values.front();
+			summary.maximum = values.back();
+			summary.percentile_95 = values[(values.size() - 1) * 95 / 100];
+
+			double total = 0;
+			for (auto value : values)
+				total += value;
+
+			summary.average = total / values.size();
+
+			return summary;
+		}
+
+		FrameStats::Histogram FrameStats::histogram(Counter counter, std::size_t bin_count) const
+		{
+			Histogram histogram;
+			histogram.bins.resize(std::max<std::size_t>(bin_count, 1), 0);
+
+			std::uint64_t maximum = 0;
+			for (auto & counters : _history)
+				maximum = std::max(maximum, counters[counter]);
+
+			// The last bin includes the maximum:
+			histogram.bin_width = std::max<std::uint64_t>(maximum / histogram.bins.size() + 1, 1);
+
+			for (auto & counters : _history)
+				histogram.bins[counters[counter] / histogram.bin_width] += 1;
+
+			return histogram;
+		}
+
+		namespace
+		{
+			// Abbreviate large values, e.g. 12.3k or 4.5M:
+			void write_abbreviated(StringStreamT & output, std::uint64_t value)
+			{
+				if (value >= 1000000)
+					output << (value / 100000) / 10.0 << "M";
+				else if (value >= 1000)
+					output << (value / 100) / 10.0 << "k";
+				else
+					output << value;
+			}
+		}
+
+		StringT FrameStats::overlay() const
+		{
+			const CountersT & counters = last();
+			StringStreamT output;
+
+			output << "draws ";
+			write_abbreviated(output, counters[DRAW_CALLS]);
+			output << " prims ";
+			write_abbreviated(output, counters[PRIMITIVES]);
+			output << " upload ";
+			write_abbreviated(output, counters[BUFFER_BYTES] + counters[TEXTURE_BYTES]);
+			output << "B binds ";
+			output << counters[PROGRAM_BINDS] << "/" << counters[VERTEX_ARRAY_BINDS] << "/" << counters[TEXTURE_BINDS];
+			output << " uniforms ";
+			write_abbreviated(output, counters[UNIFORM_UPLOADS]);
+			output << "/";
+			write_abbreviated(output, counters[UNIFORM_SKIPPED]);
+			output << " errors " << counters[ERROR_CHECKS];
+
+			return output.str();
+		}
+
+		void FrameStats::write(std::ostream & output) const
+		{
+			const CountersT & counters = last();
+
+			output << "{\"frames\":" << _frame_count << ",\"counters\":{";
+
+			for (std::size_t i = 0; i < COUNTER_COUNT; i += 1) {
+				Summary summary = this->summary((Counter)i);
+
+				if (i) output << ",";
+
+				output << "\"" << name((Counter)i) << "\":{\"last\":" << counters[i] << ",\"minimum\":" << summary.minimum << ",\"average\":" << summary.average << ",\"percentile_95\":" << summary.percentile_95 << ",\"maximum\":" << summary.maximum << "}";
+			}
+
+			output << "}}\n";
+		}
+	}
+}
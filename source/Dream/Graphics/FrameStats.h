@@ -0,0 +1,107 @@
+//
+//  Graphics/FrameStats.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_FRAMESTATS_H
+#define _DREAM_CLIENT_GRAPHICS_FRAMESTATS_H
+
+#include "Graphics.h"
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 Counts the work done by the graphics wrappers in each frame, e.g. draw calls, binds and bytes uploaded, and keeps a history of recent frames:
+
+		 	// At the end of each frame:
+		 	frame_stats->end_frame();
+
+		 	text_renderer->render(frame_stats->overlay());
+
+		 The counters are shared by all wrappers and are not synchronised, so they should only be updated from the rendering thread.
+		 */
+		class FrameStats : public Object {
+		public:
+			enum Counter {
+				DRAW_CALLS,
+				PRIMITIVES,
+				BUFFER_BYTES,
+				TEXTURE_BYTES,
+				PROGRAM_BINDS,
+				VERTEX_ARRAY_BINDS,
+				TEXTURE_BINDS,
+				ERROR_CHECKS,
+				UNIFORM_UPLOADS,
+				// Uniform uploads which were skipped because the program already held the value:
+				UNIFORM_SKIPPED,
+				COUNTER_COUNT
+			};
+
+			typedef std::array<std::uint64_t, COUNTER_COUNT> CountersT;
+
+			struct Summary {
+				std::uint64_t minimum = 0, maximum = 0, percentile_95 = 0;
+				double average = 0;
+			};
+
+			struct Histogram {
+				std::uint64_t bin_width = 1;
+				std::vector<std::size_t> bins;
+			};
+
+		protected:
+			static CountersT _counters;
+
+			std::size_t _window;
+
+			// The counters of recent frames, used as a ring:
+			std::vector<CountersT> _history;
+			std::size_t _next = 0;
+			std::size_t _frame_count = 0;
+
+		public:
+			/// Keep the counters of the given number of recent frames.
+			FrameStats(std::size_t window = 120);
+			virtual ~FrameStats();
+
+			/// The counters of the frame in progress.
+			static const CountersT & counters() { return _counters; }
+
+			static void count(Counter counter, std::uint64_t amount = 1) { _counters[counter] += amount; }
+
+			/// Count a draw call, and the primitives it draws.
+			static void count_draw(GLenum mode, std::size_t vertex_count);
+
+			static const char * name(Counter counter);
+
+			/// Record the counters of the frame in progress and reset them.
+			void end_frame();
+
+			std::size_t frame_count() const { return _frame_count; }
+
+			/// The counters of the most recently completed frame.
+			const CountersT & last() const;
+
+			/// Statistics over the recent frames.
+			Summary summary(Counter counter) const;
+
+			/// The distribution of the counter over the recent frames, from zero to the maximum.
+			Histogram histogram(Counter counter, std::size_t bin_count = 16) const;
+
+			/// A compact, single line description of the last frame, suitable for an on-screen overlay.
+			StringT overlay() const;
+
+			/// Write the last frame and the statistics of each counter as JSON, for regression tracking.
+			void write(std::ostream & output) const;
+		};
+	}
+}
+
+#endif
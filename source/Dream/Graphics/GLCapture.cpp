@@ -0,0 +1,1297 @@
+//
+//  Graphics/GLCapture.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+// This file calls the system entry points directly:
+#define DREAM_GL_DISPATCH_IMPLEMENTATION
+
+#include "GLCapture.h"
+
+#ifndef DREAM_OPENGLES2
+
+#include <chrono>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+
+#ifndef APIENTRY
+	#define APIENTRY
+#endif
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		GLDispatch GLDispatch::system()
+		{
+			GLDispatch dispatch;
+
+#define DREAM_GL_DISPATCH_SYSTEM(name, function) dispatch.name = &function;
+			DREAM_GL_DISPATCH_ENTRIES(DREAM_GL_DISPATCH_SYSTEM)
+#undef DREAM_GL_DISPATCH_SYSTEM
+
+			return dispatch;
+		}
+
+		GLDispatch gl_dispatch = GLDispatch::system();
+
+// MARK: -
+
+		const char GLCapture::MAGIC[4] = {'D', 'G', 'L', 'C'};
+		const std::uint32_t GLCapture::VERSION = 1;
+
+		namespace
+		{
+			GLCapture * _current_capture = nullptr;
+		}
+
+		typedef GLCapture::Opcode Opcode;
+
+		// Each entry point records its arguments and then forwards the call. Values are written with fixed sizes, so that captures don't depend on the pointer size of the recording process.
+		struct GLRecorder {
+			static GLCapture & capture() {
+				return *_current_capture;
+			}
+
+			static void write_names(Opcode opcode, GLsizei n, const GLuint * names) {
+				auto & capture = GLRecorder::capture();
+
+				capture.write_opcode(opcode);
+				capture.write((std::int32_t)n);
+
+				for (GLsizei i = 0; i < n; i += 1)
+					capture.write((std::uint32_t)names[i]);
+			}
+
+			static void write_string(const GLchar * string) {
+				capture().write_data(string, std::strlen(string));
+			}
+
+			// Buffers:
+			static void APIENTRY gen_buffers(GLsizei n, GLuint * buffers) {
+				capture()._next.GenBuffers(n, buffers);
+				write_names(Opcode::GEN_BUFFERS, n, buffers);
+			}
+
+			static void APIENTRY delete_buffers(GLsizei n, const GLuint * buffers) {
+				auto & capture = GLRecorder::capture();
+
+				for (GLsizei i = 0; i < n; i += 1)
+					capture._buffer_sizes.erase(buffers[i]);
+
+				write_names(Opcode::DELETE_BUFFERS, n, buffers);
+				capture._next.DeleteBuffers(n, buffers);
+			}
+
+			static void APIENTRY bind_buffer(GLenum target, GLuint buffer) {
+				auto & capture = GLRecorder::capture();
+
+				capture._buffers[target] = buffer;
+
+				capture.write_opcode(Opcode::BIND_BUFFER);
+				capture.write((std::uint32_t)target);
+				capture.write((std::uint32_t)buffer);
+
+				capture._next.BindBuffer(target, buffer);
+			}
+
+			static void APIENTRY bind_buffer_base(GLenum target, GLuint index, GLuint buffer) {
+				auto & capture = GLRecorder::capture();
+
+				// This also binds the generic binding point:
+				capture._buffers[target] = buffer;
+
+				capture.write_opcode(Opcode::BIND_BUFFER_BASE);
+				capture.write((std::uint32_t)target);
+				capture.write((std::uint32_t)index);
+				capture.write((std::uint32_t)buffer);
+
+				capture._next.BindBufferBase(target, index, buffer);
+			}
+
+			static void APIENTRY bind_buffer_range(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size) {
+				auto & capture = GLRecorder::capture();
+
+				capture._buffers[target] = buffer;
+
+				capture.write_opcode(Opcode::BIND_BUFFER_RANGE);
+				capture.write((std::uint32_t)target);
+				capture.write((std::uint32_t)index);
+				capture.write((std::uint32_t)buffer);
+				capture.write((std::uint64_t)offset);
+				capture.write((std::uint64_t)size);
+
+				capture._next.BindBufferRange(target, index, buffer, offset, size);
+			}
+
+			static void APIENTRY buffer_data(GLenum target, GLsizeiptr size, const void * data, GLenum usage) {
+				auto & capture = GLRecorder::capture();
+
+				capture._buffer_sizes[capture._buffers[target]] = size;
+
+				capture.write_opcode(Opcode::BUFFER_DATA);
+				capture.write((std::uint32_t)target);
+				capture.write((std::uint32_t)usage);
+				capture.write((std::uint64_t)size);
+				capture.write_data(data, data ? size : 0);
+
+				capture._next.BufferData(target, size, data, usage);
+			}
+
+			static void write_buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void * data) {
+				auto & capture = GLRecorder::capture();
+
+				capture.write_opcode(Opcode::BUFFER_SUB_DATA);
+				capture.write((std::uint32_t)target);
+				capture.write((std::uint64_t)offset);
+				capture.write_data(data, size);
+			}
+
+			static void APIENTRY buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void * data) {
+				write_buffer_sub_data(target, offset, size, data);
+				capture()._next.BufferSubData(target, offset, size, data);
+			}
+
+			static void * APIENTRY map_buffer(GLenum target, GLenum access) {
+				auto & capture = GLRecorder::capture();
+
+				void * data = capture._next.MapBuffer(target, access);
+
+				if (data && access != GL_READ_ONLY)
+					capture._mappings[target] = {0, capture._buffer_sizes[capture._buffers[target]], data};
+
+				return data;
+			}
+
+			static void * APIENTRY map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+				auto & capture = GLRecorder::capture();
+
+				void * data = capture._next.MapBufferRange(target, offset, length, access);
+
+				if (data && (access & GL_MAP_WRITE_BIT))
+					capture._mappings[target] = {offset, length, data};
+
+				return data;
+			}
+
+			static GLboolean APIENTRY unmap_buffer(GLenum target) {
+				auto & capture = GLRecorder::capture();
+				auto mapping = capture._mappings.find(target);
+
+				// The mapped data is only valid until the buffer is unmapped:
+				if (mapping != capture._mappings.end()) {
+					write_buffer_sub_data(target, mapping->second.offset, mapping->second.length, mapping->second.data);
+					capture._mappings.erase(mapping);
+				}
+
+				return capture._next.UnmapBuffer(target);
+			}
+
+			// Vertex arrays:
+			static void APIENTRY gen_vertex_arrays(GLsizei n, GLuint * arrays) {
+				capture()._next.GenVertexArrays(n, arrays);
+				write_names(Opcode::GEN_VERTEX_ARRAYS, n, arrays);
+			}
+
+			static void APIENTRY delete_vertex_arrays(GLsizei n, const GLuint * arrays) {
+				write_names(Opcode::DELETE_VERTEX_ARRAYS, n, arrays);
+				capture()._next.DeleteVertexArrays(n, arrays);
+			}
+
+			static void APIENTRY bind_vertex_array(GLuint array) {
+				capture().write_opcode(Opcode::BIND_VERTEX_ARRAY);
+				capture().write((std::uint32_t)array);
+				capture()._next.BindVertexArray(array);
+			}
+
+			static void APIENTRY enable_vertex_attrib_array(GLuint index) {
+				capture().write_opcode(Opcode::ENABLE_VERTEX_ATTRIB_ARRAY);
+				capture().write((std::uint32_t)index);
+				capture()._next.EnableVertexAttribArray(index);
+			}
+
+			static void APIENTRY disable_vertex_attrib_array(GLuint index) {
+				capture().write_opcode(Opcode::DISABLE_VERTEX_ATTRIB_ARRAY);
+				capture().write((std::uint32_t)index);
+				capture()._next.DisableVertexAttribArray(index);
+			}
+
+			static void APIENTRY vertex_attrib_pointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void * pointer) {
+				auto & capture = GLRecorder::capture();
+
+				// The pointer is an offset into the bound array buffer:
+				capture.write_opcode(Opcode::VERTEX_ATTRIB_POINTER);
+				capture.write((std::uint32_t)index);
+				capture.write((std::int32_t)size);
+				capture.write((std::uint32_t)type);
+				capture.write((std::uint8_t)normalized);
+				capture.write((std::int32_t)stride);
+				capture.write((std::uint64_t)(std::uintptr_t)pointer);
+
+				capture._next.VertexAttribPointer(index, size, type, normalized, stride, pointer);
+			}
+
+			// Textures:
+			static void APIENTRY gen_textures(GLsizei n, GLuint * textures) {
+				capture()._next.GenTextures(n, textures);
+				write_names(Opcode::GEN_TEXTURES, n, textures);
+			}
+
+			static void APIENTRY delete_textures(GLsizei n, const GLuint * textures) {
+				write_names(Opcode::DELETE_TEXTURES, n, textures);
+				capture()._next.DeleteTextures(n, textures);
+			}
+
+			static void APIENTRY active_texture(GLenum texture) {
+				capture().write_opcode(Opcode::ACTIVE_TEXTURE);
+				capture().write((std::uint32_t)texture);
+				capture()._next.ActiveTexture(texture);
+			}
+
+			static void APIENTRY bind_texture(GLenum target, GLuint texture) {
+				capture().write_opcode(Opcode::BIND_TEXTURE);
+				capture().write((std::uint32_t)target);
+				capture().write((std::uint32_t)texture);
+				capture()._next.BindTexture(target, texture);
+			}
+
+			static void APIENTRY tex_parameter_i(GLenum target, GLenum name, GLint value) {
+				capture().write_opcode(Opcode::TEX_PARAMETER_I);
+				capture().write((std::uint32_t)target);
+				capture().write((std::uint32_t)name);
+				capture().write((std::int32_t)value);
+				capture()._next.TexParameteri(target, name, value);
+			}
+
+			static void APIENTRY tex_parameter_f(GLenum target, GLenum name, GLfloat value) {
+				capture().write_opcode(Opcode::TEX_PARAMETER_F);
+				capture().write((std::uint32_t)target);
+				capture().write((std::uint32_t)name);
+				capture().write((float)value);
+				capture()._next.TexParameterf(target, name, value);
+			}
+
+			static void APIENTRY pixel_store_i(GLenum name, GLint value) {
+				auto & capture = GLRecorder::capture();
+
+				// The alignment determines how much pixel data is read by each upload:
+				if (name == GL_UNPACK_ALIGNMENT)
+					capture._unpack_alignment = value;
+
+				capture.write_opcode(Opcode::PIXEL_STORE_I);
+				capture.write((std::uint32_t)name);
+				capture.write((std::int32_t)value);
+
+				capture._next.PixelStorei(name, value);
+			}
+
+			// The size of the client pixel data, with each row padded to the unpack alignment. Layers of 3D images are assumed to be tightly packed rows:
+			static std::size_t image_size(GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void * pixels) {
+				if (!pixels || width <= 0 || height <= 0 || depth <= 0)
+					return 0;
+
+				std::size_t row_size = width * pixel_size(format, type);
+				std::size_t alignment = capture()._unpack_alignment;
+				std::size_t stride = (row_size + alignment - 1) / alignment * alignment;
+
+				// The last row isn't padded:
+				return stride * (height * depth - 1) + row_size;
+			}
+
+			static void APIENTRY tex_image_1d(GLenum target, GLint level, GLint internal_format, GLsizei width, GLint border, GLenum format, GLenum type, const void * pixels) {
+				auto & capture = GLRecorder::capture();
+
+				capture.write_opcode(Opcode::TEX_IMAGE_1D);
+				capture.write((std::uint32_t)target);
+				capture.write((std::int32_t)level);
+				capture.write((std::int32_t)internal_format);
+				capture.write((std::int32_t)width);
+				capture.write((std::int32_t)border);
+				capture.write((std::uint32_t)format);
+				capture.write((std::uint32_t)type);
+				capture.write_data(pixels, image_size(width, 1, 1, format, type, pixels));
+
+				capture._next.TexImage1D(target, level, internal_format, width, border, format, type, pixels);
+			}
+
+			static void APIENTRY tex_image_3d(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void * pixels) {
+				auto & capture = GLRecorder::capture();
+
+				capture.write_opcode(Opcode::TEX_IMAGE_3D);
+				capture.write((std::uint32_t)target);
+				capture.write((std::int32_t)level);
+				capture.write((std::int32_t)internal_format);
+				capture.write((std::int32_t)width);
+				capture.write((std::int32_t)height);
+				capture.write((std::int32_t)depth);
+				capture.write((std::int32_t)border);
+				capture.write((std::uint32_t)format);
+				capture.write((std::uint32_t)type);
+				capture.write_data(pixels, image_size(width, height, depth, format, type, pixels));
+
+				capture._next.TexImage3D(target, level, internal_format, width, height, depth, border, format, type, pixels);
+			}
+
+			static void APIENTRY tex_image_2d(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type, const void * pixels) {
+				auto & capture = GLRecorder::capture();
+
+				std::size_t size = image_size(width, height, 1, format, type, pixels);
+
+				capture.write_opcode(Opcode::TEX_IMAGE_2D);
+				capture.write((std::uint32_t)target);
+				capture.write((std::int32_t)level);
+				capture.write((std::int32_t)internal_format);
+				capture.write((std::int32_t)width);
+				capture.write((std::int32_t)height);
+				capture.write((std::int32_t)border);
+				capture.write((std::uint32_t)format);
+				capture.write((std::uint32_t)type);
+				capture.write_data(pixels, size);
+
+				capture._next.TexImage2D(target, level, internal_format, width, height, border, format, type, pixels);
+			}
+
+			static void APIENTRY generate_mipmap(GLenum target) {
+				capture().write_opcode(Opcode::GENERATE_MIPMAP);
+				capture().write((std::uint32_t)target);
+				capture()._next.GenerateMipmap(target);
+			}
+
+			// Shaders and programs:
+			static GLuint APIENTRY create_shader(GLenum type) {
+				GLuint shader = capture()._next.CreateShader(type);
+
+				capture().write_opcode(Opcode::CREATE_SHADER);
+				capture().write((std::uint32_t)type);
+				capture().write((std::uint32_t)shader);
+
+				return shader;
+			}
+
+			static void APIENTRY delete_shader(GLuint shader) {
+				capture().write_opcode(Opcode::DELETE_SHADER);
+				capture().write((std::uint32_t)shader);
+				capture()._next.DeleteShader(shader);
+			}
+
+			static void APIENTRY shader_source(GLuint shader, GLsizei count, const GLchar * const * strings, const GLint * lengths) {
+				auto & capture = GLRecorder::capture();
+
+				// The strings are concatenated, which is how they are compiled:
+				StringT source;
+
+				for (GLsizei i = 0; i < count; i += 1) {
+					if (lengths && lengths[i] >= 0)
+						source.append(strings[i], lengths[i]);
+					else
+						source.append(strings[i]);
+				}
+
+				capture.write_opcode(Opcode::SHADER_SOURCE);
+				capture.write((std::uint32_t)shader);
+				capture.write_data(source.data(), source.size());
+
+				capture._next.ShaderSource(shader, count, strings, lengths);
+			}
+
+			static void APIENTRY compile_shader(GLuint shader) {
+				capture().write_opcode(Opcode::COMPILE_SHADER);
+				capture().write((std::uint32_t)shader);
+				capture()._next.CompileShader(shader);
+			}
+
+			static GLuint APIENTRY create_program() {
+				GLuint program = capture()._next.CreateProgram();
+
+				capture().write_opcode(Opcode::CREATE_PROGRAM);
+				capture().write((std::uint32_t)program);
+
+				return program;
+			}
+
+			static void APIENTRY delete_program(GLuint program) {
+				capture().write_opcode(Opcode::DELETE_PROGRAM);
+				capture().write((std::uint32_t)program);
+				capture()._next.DeleteProgram(program);
+			}
+
+			static void APIENTRY attach_shader(GLuint program, GLuint shader) {
+				capture().write_opcode(Opcode::ATTACH_SHADER);
+				capture().write((std::uint32_t)program);
+				capture().write((std::uint32_t)shader);
+				capture()._next.AttachShader(program, shader);
+			}
+
+			static void APIENTRY detach_shader(GLuint program, GLuint shader) {
+				capture().write_opcode(Opcode::DETACH_SHADER);
+				capture().write((std::uint32_t)program);
+				capture().write((std::uint32_t)shader);
+				capture()._next.DetachShader(program, shader);
+			}
+
+			static void APIENTRY bind_attrib_location(GLuint program, GLuint index, const GLchar * name) {
+				capture().write_opcode(Opcode::BIND_ATTRIB_LOCATION);
+				capture().write((std::uint32_t)program);
+				capture().write((std::uint32_t)index);
+				write_string(name);
+				capture()._next.BindAttribLocation(program, index, name);
+			}
+
+			static void APIENTRY bind_frag_data_location(GLuint program, GLuint color, const GLchar * name) {
+				capture().write_opcode(Opcode::BIND_FRAG_DATA_LOCATION);
+				capture().write((std::uint32_t)program);
+				capture().write((std::uint32_t)color);
+				write_string(name);
+				capture()._next.BindFragDataLocation(program, color, name);
+			}
+
+			static void APIENTRY link_program(GLuint program) {
+				capture().write_opcode(Opcode::LINK_PROGRAM);
+				capture().write((std::uint32_t)program);
+				capture()._next.LinkProgram(program);
+			}
+
+			static void APIENTRY use_program(GLuint program) {
+				capture().write_opcode(Opcode::USE_PROGRAM);
+				capture().write((std::uint32_t)program);
+				capture()._next.UseProgram(program);
+			}
+
+			static GLint APIENTRY get_uniform_location(GLuint program, const GLchar * name) {
+				GLint location = capture()._next.GetUniformLocation(program, name);
+
+				capture().write_opcode(Opcode::GET_UNIFORM_LOCATION);
+				capture().write((std::uint32_t)program);
+				write_string(name);
+				capture().write((std::int32_t)location);
+
+				return location;
+			}
+
+			static GLuint APIENTRY get_uniform_block_index(GLuint program, const GLchar * name) {
+				GLuint index = capture()._next.GetUniformBlockIndex(program, name);
+
+				capture().write_opcode(Opcode::GET_UNIFORM_BLOCK_INDEX);
+				capture().write((std::uint32_t)program);
+				write_string(name);
+				capture().write((std::uint32_t)index);
+
+				return index;
+			}
+
+			static void APIENTRY uniform_block_binding(GLuint program, GLuint index, GLuint binding) {
+				capture().write_opcode(Opcode::UNIFORM_BLOCK_BINDING);
+				capture().write((std::uint32_t)program);
+				capture().write((std::uint32_t)index);
+				capture().write((std::uint32_t)binding);
+				capture()._next.UniformBlockBinding(program, index, binding);
+			}
+
+			// Uniforms:
+			static void APIENTRY uniform_1i(GLint location, GLint value) {
+				capture().write_opcode(Opcode::UNIFORM_1I);
+				capture().write((std::int32_t)location);
+				capture().write((std::int32_t)value);
+				capture()._next.Uniform1i(location, value);
+			}
+
+			template <Opcode OPCODE, std::size_t COMPONENTS, typename ValueT, typename FunctionT, FunctionT GLDispatch::*NEXT>
+			static void APIENTRY uniform(GLint location, GLsizei count, const ValueT * values) {
+				auto & capture = GLRecorder::capture();
+
+				capture.write_opcode(OPCODE);
+				capture.write((std::int32_t)location);
+				capture.write((std::int32_t)count);
+				capture.write_data(values, sizeof(ValueT) * COMPONENTS * count);
+
+				(capture._next.*NEXT)(location, count, values);
+			}
+
+			template <Opcode OPCODE, std::size_t COMPONENTS, typename FunctionT, FunctionT GLDispatch::*NEXT>
+			static void APIENTRY uniform_matrix(GLint location, GLsizei count, GLboolean transpose, const GLfloat * values) {
+				auto & capture = GLRecorder::capture();
+
+				capture.write_opcode(OPCODE);
+				capture.write((std::int32_t)location);
+				capture.write((std::int32_t)count);
+				capture.write((std::uint8_t)transpose);
+				capture.write_data(values, sizeof(GLfloat) * COMPONENTS * count);
+
+				(capture._next.*NEXT)(location, count, transpose, values);
+			}
+
+			// State:
+			static void APIENTRY enable(GLenum capability) {
+				capture().write_opcode(Opcode::ENABLE);
+				capture().write((std::uint32_t)capability);
+				capture()._next.Enable(capability);
+			}
+
+			static void APIENTRY disable(GLenum capability) {
+				capture().write_opcode(Opcode::DISABLE);
+				capture().write((std::uint32_t)capability);
+				capture()._next.Disable(capability);
+			}
+
+			static void APIENTRY blend_func(GLenum source, GLenum destination) {
+				capture().write_opcode(Opcode::BLEND_FUNC);
+				capture().write((std::uint32_t)source);
+				capture().write((std::uint32_t)destination);
+				capture()._next.BlendFunc(source, destination);
+			}
+
+			static void APIENTRY depth_mask(GLboolean flag) {
+				capture().write_opcode(Opcode::DEPTH_MASK);
+				capture().write((std::uint8_t)flag);
+				capture()._next.DepthMask(flag);
+			}
+
+			static void APIENTRY color_mask(GLboolean red, GLboolean green, GLboolean blue, GLboolean alpha) {
+				capture().write_opcode(Opcode::COLOR_MASK);
+				capture().write((std::uint8_t)red);
+				capture().write((std::uint8_t)green);
+				capture().write((std::uint8_t)blue);
+				capture().write((std::uint8_t)alpha);
+				capture()._next.ColorMask(red, green, blue, alpha);
+			}
+
+			static void APIENTRY viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+				capture().write_opcode(Opcode::VIEWPORT);
+				capture().write((std::int32_t)x);
+				capture().write((std::int32_t)y);
+				capture().write((std::int32_t)width);
+				capture().write((std::int32_t)height);
+				capture()._next.Viewport(x, y, width, height);
+			}
+
+			static void APIENTRY clear_color(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+				capture().write_opcode(Opcode::CLEAR_COLOR);
+				capture().write((float)red);
+				capture().write((float)green);
+				capture().write((float)blue);
+				capture().write((float)alpha);
+				capture()._next.ClearColor(red, green, blue, alpha);
+			}
+
+			static void APIENTRY clear(GLbitfield mask) {
+				capture().write_opcode(Opcode::CLEAR);
+				capture().write((std::uint32_t)mask);
+				capture()._next.Clear(mask);
+			}
+
+			// Drawing:
+			static void APIENTRY draw_arrays(GLenum mode, GLint first, GLsizei count) {
+				capture().write_opcode(Opcode::DRAW_ARRAYS);
+				capture().write((std::uint32_t)mode);
+				capture().write((std::int32_t)first);
+				capture().write((std::int32_t)count);
+				capture()._next.DrawArrays(mode, first, count);
+			}
+
+			static void APIENTRY draw_elements(GLenum mode, GLsizei count, GLenum type, const void * indices) {
+				// The indices are an offset into the bound element array buffer:
+				capture().write_opcode(Opcode::DRAW_ELEMENTS);
+				capture().write((std::uint32_t)mode);
+				capture().write((std::int32_t)count);
+				capture().write((std::uint32_t)type);
+				capture().write((std::uint64_t)(std::uintptr_t)indices);
+				capture()._next.DrawElements(mode, count, type, indices);
+			}
+
+			static void install(GLDispatch & dispatch) {
+				dispatch.GenBuffers = &gen_buffers;
+				dispatch.DeleteBuffers = &delete_buffers;
+				dispatch.BindBuffer = &bind_buffer;
+				dispatch.BindBufferBase = &bind_buffer_base;
+				dispatch.BindBufferRange = &bind_buffer_range;
+				dispatch.BufferData = &buffer_data;
+				dispatch.BufferSubData = &buffer_sub_data;
+				dispatch.MapBuffer = &map_buffer;
+				dispatch.MapBufferRange = &map_buffer_range;
+				dispatch.UnmapBuffer = &unmap_buffer;
+
+				dispatch.GenVertexArrays = &gen_vertex_arrays;
+				dispatch.DeleteVertexArrays = &delete_vertex_arrays;
+				dispatch.BindVertexArray = &bind_vertex_array;
+				dispatch.EnableVertexAttribArray = &enable_vertex_attrib_array;
+				dispatch.DisableVertexAttribArray = &disable_vertex_attrib_array;
+				dispatch.VertexAttribPointer = &vertex_attrib_pointer;
+
+				dispatch.GenTextures = &gen_textures;
+				dispatch.DeleteTextures = &delete_textures;
+				dispatch.ActiveTexture = &active_texture;
+				dispatch.BindTexture = &bind_texture;
+				dispatch.TexParameteri = &tex_parameter_i;
+				dispatch.TexParameterf = &tex_parameter_f;
+				dispatch.PixelStorei = &pixel_store_i;
+				dispatch.TexImage1D = &tex_image_1d;
+				dispatch.TexImage2D = &tex_image_2d;
+				dispatch.TexImage3D = &tex_image_3d;
+				dispatch.GenerateMipmap = &generate_mipmap;
+
+				dispatch.CreateShader = &create_shader;
+				dispatch.DeleteShader = &delete_shader;
+				dispatch.ShaderSource = &shader_source;
+				dispatch.CompileShader = &compile_shader;
+				dispatch.CreateProgram = &create_program;
+				dispatch.DeleteProgram = &delete_program;
+				dispatch.AttachShader = &attach_shader;
+				dispatch.DetachShader = &detach_shader;
+				dispatch.BindAttribLocation = &bind_attrib_location;
+				dispatch.BindFragDataLocation = &bind_frag_data_location;
+				dispatch.LinkProgram = &link_program;
+				dispatch.UseProgram = &use_program;
+				dispatch.GetUniformLocation = &get_uniform_location;
+				dispatch.GetUniformBlockIndex = &get_uniform_block_index;
+				dispatch.UniformBlockBinding = &uniform_block_binding;
+
+#define DREAM_GL_RECORD_UNIFORM(name, opcode, components, type) \
+				dispatch.name = &uniform<Opcode::opcode, components, type, decltype(GLDispatch::name), &GLDispatch::name>;
+#define DREAM_GL_RECORD_UNIFORM_MATRIX(name, opcode, components) \
+				dispatch.name = &uniform_matrix<Opcode::opcode, components, decltype(GLDispatch::name), &GLDispatch::name>;
+
+				dispatch.Uniform1i = &uniform_1i;
+				DREAM_GL_RECORD_UNIFORM(Uniform1fv, UNIFORM_1FV, 1, GLfloat)
+				DREAM_GL_RECORD_UNIFORM(Uniform2fv, UNIFORM_2FV, 2, GLfloat)
+				DREAM_GL_RECORD_UNIFORM(Uniform3fv, UNIFORM_3FV, 3, GLfloat)
+				DREAM_GL_RECORD_UNIFORM(Uniform4fv, UNIFORM_4FV, 4, GLfloat)
+				DREAM_GL_RECORD_UNIFORM(Uniform1iv, UNIFORM_1IV, 1, GLint)
+				DREAM_GL_RECORD_UNIFORM(Uniform2iv, UNIFORM_2IV, 2, GLint)
+				DREAM_GL_RECORD_UNIFORM(Uniform3iv, UNIFORM_3IV, 3, GLint)
+				DREAM_GL_RECORD_UNIFORM(Uniform4iv, UNIFORM_4IV, 4, GLint)
+				DREAM_GL_RECORD_UNIFORM(Uniform1uiv, UNIFORM_1UIV, 1, GLuint)
+				DREAM_GL_RECORD_UNIFORM(Uniform2uiv, UNIFORM_2UIV, 2, GLuint)
+				DREAM_GL_RECORD_UNIFORM(Uniform3uiv, UNIFORM_3UIV, 3, GLuint)
+				DREAM_GL_RECORD_UNIFORM(Uniform4uiv, UNIFORM_4UIV, 4, GLuint)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix2fv, UNIFORM_MATRIX_2FV, 4)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix3fv, UNIFORM_MATRIX_3FV, 9)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix4fv, UNIFORM_MATRIX_4FV, 16)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix2x3fv, UNIFORM_MATRIX_2X3FV, 6)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix2x4fv, UNIFORM_MATRIX_2X4FV, 8)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix3x2fv, UNIFORM_MATRIX_3X2FV, 6)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix3x4fv, UNIFORM_MATRIX_3X4FV, 12)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix4x2fv, UNIFORM_MATRIX_4X2FV, 8)
+				DREAM_GL_RECORD_UNIFORM_MATRIX(UniformMatrix4x3fv, UNIFORM_MATRIX_4X3FV, 12)
+
+#undef DREAM_GL_RECORD_UNIFORM
+#undef DREAM_GL_RECORD_UNIFORM_MATRIX
+
+				dispatch.Enable = &enable;
+				dispatch.Disable = &disable;
+				dispatch.BlendFunc = &blend_func;
+				dispatch.DepthMask = &depth_mask;
+				dispatch.ColorMask = &color_mask;
+				dispatch.Viewport = &viewport;
+				dispatch.ClearColor = &clear_color;
+				dispatch.Clear = &clear;
+
+				dispatch.DrawArrays = &draw_arrays;
+				dispatch.DrawElements = &draw_elements;
+
+				// glFinish isn't recorded, so that the replay isn't stalled by the application's synchronisation.
+			}
+		};
+
+		GLCapture * GLCapture::current()
+		{
+			return _current_capture;
+		}
+
+		GLCapture::GLCapture(std::ostream & output) : _output(output), _next(gl_dispatch)
+		{
+			DREAM_ASSERT(_current_capture == nullptr);
+
+			_buffer.assign(MAGIC, MAGIC + sizeof(MAGIC));
+			write(VERSION);
+
+			_current_capture = this;
+			GLRecorder::install(gl_dispatch);
+		}
+
+		GLCapture::~GLCapture()
+		{
+			gl_dispatch = _next;
+			_current_capture = nullptr;
+
+			flush();
+		}
+
+		void GLCapture::write_data(const void * data, std::size_t size)
+		{
+			write((std::uint32_t)size);
+
+			const ByteT * bytes = (const ByteT *)data;
+			_buffer.insert(_buffer.end(), bytes, bytes + size);
+		}
+
+		void GLCapture::flush()
+		{
+			_output.write((const char *)_buffer.data(), _buffer.size());
+			_byte_count += _buffer.size();
+
+			_buffer.clear();
+		}
+
+		void GLCapture::frame()
+		{
+			write_opcode(Opcode::FRAME);
+			_frame_count += 1;
+
+			flush();
+		}
+
+// MARK: -
+
+		namespace
+		{
+			class Reader {
+			protected:
+				const std::vector<ByteT> & _data;
+				std::size_t _offset;
+
+				void check(std::size_t size) const {
+					if (_offset + size > _data.size())
+						throw std::runtime_error("Capture is truncated!");
+				}
+
+			public:
+				Reader(const std::vector<ByteT> & data, std::size_t offset) : _data(data), _offset(offset) {
+				}
+
+				bool finished() const { return _offset == _data.size(); }
+
+				template <typename ValueT>
+				ValueT read() {
+					check(sizeof(ValueT));
+
+					ValueT value;
+					std::memcpy(&value, _data.data() + _offset, sizeof(ValueT));
+					_offset += sizeof(ValueT);
+
+					return value;
+				}
+
+				// Returns a pointer to the payload, or null if it's empty:
+				const ByteT * read_data(std::size_t & size) {
+					size = read<std::uint32_t>();
+					check(size);
+
+					const ByteT * data = size ? _data.data() + _offset : nullptr;
+					_offset += size;
+
+					return data;
+				}
+
+				StringT read_string() {
+					std::size_t size;
+					const ByteT * data = read_data(size);
+
+					return StringT((const char *)data, size);
+				}
+			};
+
+			typedef std::unordered_map<GLuint, GLuint> NameMap;
+
+			// Names which weren't created during the capture are replayed as zero:
+			GLuint lookup(const NameMap & names, GLuint name)
+			{
+				auto iterator = names.find(name);
+
+				if (iterator != names.end())
+					return iterator->second;
+
+				return 0;
+			}
+		}
+
+		GLReplay::GLReplay(std::istream & input) : _data(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>())
+		{
+			_begin = sizeof(GLCapture::MAGIC) + sizeof(GLCapture::VERSION);
+
+			if (_data.size() < _begin || std::memcmp(_data.data(), GLCapture::MAGIC, sizeof(GLCapture::MAGIC)) != 0)
+				throw std::runtime_error("Input is not a graphics capture!");
+
+			Reader reader(_data, sizeof(GLCapture::MAGIC));
+
+			if (reader.read<std::uint32_t>() != GLCapture::VERSION)
+				throw std::runtime_error("Unsupported graphics capture version!");
+		}
+
+		std::vector<double> GLReplay::replay(const GLDispatch & dispatch) const
+		{
+			typedef std::chrono::steady_clock Clock;
+
+			std::vector<double> durations;
+			Reader reader(_data, _begin);
+
+			NameMap buffers, vertex_arrays, textures, shaders, programs;
+
+			// Locations and block indices by recorded program and recorded value:
+			std::map<std::pair<GLuint, GLint>, GLint> locations;
+			std::map<std::pair<GLuint, GLuint>, GLuint> block_indices;
+
+			// The recorded name of the program in use:
+			GLuint program = 0;
+
+			auto location = [&](GLint recorded) -> GLint {
+				auto iterator = locations.find({program, recorded});
+
+				if (iterator != locations.end())
+					return iterator->second;
+
+				return -1;
+			};
+
+			auto generate = [&](NameMap & names, decltype(GLDispatch::GenBuffers) function) {
+				GLsizei n = reader.read<std::int32_t>();
+				std::vector<GLuint> created(n);
+
+				function(n, created.data());
+
+				for (GLsizei i = 0; i < n; i += 1)
+					names[reader.read<std::uint32_t>()] = created[i];
+			};
+
+			auto remove = [&](NameMap & names, decltype(GLDispatch::DeleteBuffers) function) {
+				GLsizei n = reader.read<std::int32_t>();
+				std::vector<GLuint> deleted(n);
+
+				for (GLsizei i = 0; i < n; i += 1) {
+					GLuint name = reader.read<std::uint32_t>();
+
+					deleted[i] = lookup(names, name);
+					names.erase(name);
+				}
+
+				function(n, deleted.data());
+			};
+
+			std::size_t size;
+			const ByteT * data;
+
+			Clock::time_point begin = Clock::now();
+
+			while (!reader.finished()) {
+				Opcode opcode = (Opcode)reader.read<std::uint8_t>();
+
+				switch (opcode) {
+					case Opcode::FRAME: {
+						dispatch.Finish();
+
+						Clock::time_point end = Clock::now();
+						durations.push_back(std::chrono::duration<double, std::milli>(end - begin).count());
+						begin = end;
+
+						break;
+					}
+
+					case Opcode::GEN_BUFFERS:
+						generate(buffers, dispatch.GenBuffers);
+						break;
+
+					case Opcode::DELETE_BUFFERS:
+						remove(buffers, dispatch.DeleteBuffers);
+						break;
+
+					case Opcode::BIND_BUFFER: {
+						GLenum target = reader.read<std::uint32_t>();
+						dispatch.BindBuffer(target, lookup(buffers, reader.read<std::uint32_t>()));
+						break;
+					}
+
+					case Opcode::BIND_BUFFER_BASE: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLuint index = reader.read<std::uint32_t>();
+						dispatch.BindBufferBase(target, index, lookup(buffers, reader.read<std::uint32_t>()));
+						break;
+					}
+
+					case Opcode::BIND_BUFFER_RANGE: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLuint index = reader.read<std::uint32_t>();
+						GLuint buffer = lookup(buffers, reader.read<std::uint32_t>());
+						GLintptr offset = reader.read<std::uint64_t>();
+						GLsizeiptr range = reader.read<std::uint64_t>();
+						dispatch.BindBufferRange(target, index, buffer, offset, range);
+						break;
+					}
+
+					case Opcode::BUFFER_DATA: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLenum usage = reader.read<std::uint32_t>();
+						GLsizeiptr buffer_size = reader.read<std::uint64_t>();
+						data = reader.read_data(size);
+						dispatch.BufferData(target, buffer_size, data, usage);
+						break;
+					}
+
+					case Opcode::BUFFER_SUB_DATA: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLintptr offset = reader.read<std::uint64_t>();
+						data = reader.read_data(size);
+						dispatch.BufferSubData(target, offset, size, data);
+						break;
+					}
+
+					case Opcode::GEN_VERTEX_ARRAYS:
+						generate(vertex_arrays, dispatch.GenVertexArrays);
+						break;
+
+					case Opcode::DELETE_VERTEX_ARRAYS:
+						remove(vertex_arrays, dispatch.DeleteVertexArrays);
+						break;
+
+					case Opcode::BIND_VERTEX_ARRAY:
+						dispatch.BindVertexArray(lookup(vertex_arrays, reader.read<std::uint32_t>()));
+						break;
+
+					case Opcode::ENABLE_VERTEX_ATTRIB_ARRAY:
+						dispatch.EnableVertexAttribArray(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::DISABLE_VERTEX_ATTRIB_ARRAY:
+						dispatch.DisableVertexAttribArray(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::VERTEX_ATTRIB_POINTER: {
+						GLuint index = reader.read<std::uint32_t>();
+						GLint components = reader.read<std::int32_t>();
+						GLenum type = reader.read<std::uint32_t>();
+						GLboolean normalized = reader.read<std::uint8_t>();
+						GLsizei stride = reader.read<std::int32_t>();
+						std::uintptr_t offset = reader.read<std::uint64_t>();
+						dispatch.VertexAttribPointer(index, components, type, normalized, stride, (const void *)offset);
+						break;
+					}
+
+					case Opcode::GEN_TEXTURES:
+						generate(textures, dispatch.GenTextures);
+						break;
+
+					case Opcode::DELETE_TEXTURES:
+						remove(textures, dispatch.DeleteTextures);
+						break;
+
+					case Opcode::ACTIVE_TEXTURE:
+						dispatch.ActiveTexture(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::BIND_TEXTURE: {
+						GLenum target = reader.read<std::uint32_t>();
+						dispatch.BindTexture(target, lookup(textures, reader.read<std::uint32_t>()));
+						break;
+					}
+
+					case Opcode::TEX_PARAMETER_I: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLenum name = reader.read<std::uint32_t>();
+						dispatch.TexParameteri(target, name, reader.read<std::int32_t>());
+						break;
+					}
+
+					case Opcode::TEX_PARAMETER_F: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLenum name = reader.read<std::uint32_t>();
+						dispatch.TexParameterf(target, name, reader.read<float>());
+						break;
+					}
+
+					case Opcode::PIXEL_STORE_I: {
+						GLenum name = reader.read<std::uint32_t>();
+						dispatch.PixelStorei(name, reader.read<std::int32_t>());
+						break;
+					}
+
+					case Opcode::TEX_IMAGE_2D: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLint level = reader.read<std::int32_t>();
+						GLint internal_format = reader.read<std::int32_t>();
+						GLsizei width = reader.read<std::int32_t>();
+						GLsizei height = reader.read<std::int32_t>();
+						GLint border = reader.read<std::int32_t>();
+						GLenum format = reader.read<std::uint32_t>();
+						GLenum type = reader.read<std::uint32_t>();
+						data = reader.read_data(size);
+						dispatch.TexImage2D(target, level, internal_format, width, height, border, format, type, data);
+						break;
+					}
+
+					case Opcode::TEX_IMAGE_1D: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLint level = reader.read<std::int32_t>();
+						GLint internal_format = reader.read<std::int32_t>();
+						GLsizei width = reader.read<std::int32_t>();
+						GLint border = reader.read<std::int32_t>();
+						GLenum format = reader.read<std::uint32_t>();
+						GLenum type = reader.read<std::uint32_t>();
+						data = reader.read_data(size);
+						dispatch.TexImage1D(target, level, internal_format, width, border, format, type, data);
+						break;
+					}
+
+					case Opcode::TEX_IMAGE_3D: {
+						GLenum target = reader.read<std::uint32_t>();
+						GLint level = reader.read<std::int32_t>();
+						GLint internal_format = reader.read<std::int32_t>();
+						GLsizei width = reader.read<std::int32_t>();
+						GLsizei height = reader.read<std::int32_t>();
+						GLsizei depth = reader.read<std::int32_t>();
+						GLint border = reader.read<std::int32_t>();
+						GLenum format = reader.read<std::uint32_t>();
+						GLenum type = reader.read<std::uint32_t>();
+						data = reader.read_data(size);
+						dispatch.TexImage3D(target, level, internal_format, width, height, depth, border, format, type, data);
+						break;
+					}
+
+					case Opcode::GENERATE_MIPMAP:
+						dispatch.GenerateMipmap(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::CREATE_SHADER: {
+						GLenum type = reader.read<std::uint32_t>();
+						shaders[reader.read<std::uint32_t>()] = dispatch.CreateShader(type);
+						break;
+					}
+
+					case Opcode::DELETE_SHADER: {
+						GLuint shader = reader.read<std::uint32_t>();
+						dispatch.DeleteShader(lookup(shaders, shader));
+						shaders.erase(shader);
+						break;
+					}
+
+					case Opcode::SHADER_SOURCE: {
+						GLuint shader = lookup(shaders, reader.read<std::uint32_t>());
+						data = reader.read_data(size);
+
+						const GLchar * source = (const GLchar *)data;
+						GLint length = (GLint)size;
+						dispatch.ShaderSource(shader, 1, &source, &length);
+						break;
+					}
+
+					case Opcode::COMPILE_SHADER:
+						dispatch.CompileShader(lookup(shaders, reader.read<std::uint32_t>()));
+						break;
+
+					case Opcode::CREATE_PROGRAM:
+						programs[reader.read<std::uint32_t>()] = dispatch.CreateProgram();
+						break;
+
+					case Opcode::DELETE_PROGRAM: {
+						GLuint recorded = reader.read<std::uint32_t>();
+						dispatch.DeleteProgram(lookup(programs, recorded));
+						programs.erase(recorded);
+						break;
+					}
+
+					case Opcode::ATTACH_SHADER: {
+						GLuint target = lookup(programs, reader.read<std::uint32_t>());
+						dispatch.AttachShader(target, lookup(shaders, reader.read<std::uint32_t>()));
+						break;
+					}
+
+					case Opcode::DETACH_SHADER: {
+						GLuint target = lookup(programs, reader.read<std::uint32_t>());
+						dispatch.DetachShader(target, lookup(shaders, reader.read<std::uint32_t>()));
+						break;
+					}
+
+					case Opcode::BIND_ATTRIB_LOCATION: {
+						GLuint target = lookup(programs, reader.read<std::uint32_t>());
+						GLuint index = reader.read<std::uint32_t>();
+						dispatch.BindAttribLocation(target, index, reader.read_string().c_str());
+						break;
+					}
+
+					case Opcode::BIND_FRAG_DATA_LOCATION: {
+						GLuint target = lookup(programs, reader.read<std::uint32_t>());
+						GLuint color = reader.read<std::uint32_t>();
+						dispatch.BindFragDataLocation(target, color, reader.read_string().c_str());
+						break;
+					}
+
+					case Opcode::LINK_PROGRAM:
+						dispatch.LinkProgram(lookup(programs, reader.read<std::uint32_t>()));
+						break;
+
+					case Opcode::USE_PROGRAM:
+						program = reader.read<std::uint32_t>();
+						dispatch.UseProgram(lookup(programs, program));
+						break;
+
+					case Opcode::GET_UNIFORM_LOCATION: {
+						GLuint recorded = reader.read<std::uint32_t>();
+						StringT name = reader.read_string();
+						GLint recorded_location = reader.read<std::int32_t>();
+
+						locations[{recorded, recorded_location}] = dispatch.GetUniformLocation(lookup(programs, recorded), name.c_str());
+						break;
+					}
+
+					case Opcode::GET_UNIFORM_BLOCK_INDEX: {
+						GLuint recorded = reader.read<std::uint32_t>();
+						StringT name = reader.read_string();
+						GLuint recorded_index = reader.read<std::uint32_t>();
+
+						block_indices[{recorded, recorded_index}] = dispatch.GetUniformBlockIndex(lookup(programs, recorded), name.c_str());
+						break;
+					}
+
+					case Opcode::UNIFORM_BLOCK_BINDING: {
+						GLuint recorded = reader.read<std::uint32_t>();
+						GLuint recorded_index = reader.read<std::uint32_t>();
+						GLuint binding = reader.read<std::uint32_t>();
+
+						auto index = block_indices.find({recorded, recorded_index});
+						if (index != block_indices.end())
+							dispatch.UniformBlockBinding(lookup(programs, recorded), index->second, binding);
+
+						break;
+					}
+
+					case Opcode::UNIFORM_1I: {
+						GLint target = location(reader.read<std::int32_t>());
+						dispatch.Uniform1i(target, reader.read<std::int32_t>());
+						break;
+					}
+
+#define DREAM_GL_REPLAY_UNIFORM(opcode, name, type) \
+					case Opcode::opcode: { \
+						GLint target = location(reader.read<std::int32_t>()); \
+						GLsizei count = reader.read<std::int32_t>(); \
+						data = reader.read_data(size); \
+						dispatch.name(target, count, (const type *)data); \
+						break; \
+					}
+#define DREAM_GL_REPLAY_UNIFORM_MATRIX(opcode, name) \
+					case Opcode::opcode: { \
+						GLint target = location(reader.read<std::int32_t>()); \
+						GLsizei count = reader.read<std::int32_t>(); \
+						GLboolean transpose = reader.read<std::uint8_t>(); \
+						data = reader.read_data(size); \
+						dispatch.name(target, count, transpose, (const GLfloat *)data); \
+						break; \
+					}
+
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_1FV, Uniform1fv, GLfloat)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_2FV, Uniform2fv, GLfloat)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_3FV, Uniform3fv, GLfloat)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_4FV, Uniform4fv, GLfloat)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_1IV, Uniform1iv, GLint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_2IV, Uniform2iv, GLint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_3IV, Uniform3iv, GLint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_4IV, Uniform4iv, GLint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_1UIV, Uniform1uiv, GLuint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_2UIV, Uniform2uiv, GLuint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_3UIV, Uniform3uiv, GLuint)
+					DREAM_GL_REPLAY_UNIFORM(UNIFORM_4UIV, Uniform4uiv, GLuint)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_2FV, UniformMatrix2fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_3FV, UniformMatrix3fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_4FV, UniformMatrix4fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_2X3FV, UniformMatrix2x3fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_2X4FV, UniformMatrix2x4fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_3X2FV, UniformMatrix3x2fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_3X4FV, UniformMatrix3x4fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_4X2FV, UniformMatrix4x2fv)
+					DREAM_GL_REPLAY_UNIFORM_MATRIX(UNIFORM_MATRIX_4X3FV, UniformMatrix4x3fv)
+
+#undef DREAM_GL_REPLAY_UNIFORM
+#undef DREAM_GL_REPLAY_UNIFORM_MATRIX
+
+					case Opcode::ENABLE:
+						dispatch.Enable(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::DISABLE:
+						dispatch.Disable(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::BLEND_FUNC: {
+						GLenum source = reader.read<std::uint32_t>();
+						dispatch.BlendFunc(source, reader.read<std::uint32_t>());
+						break;
+					}
+
+					case Opcode::DEPTH_MASK:
+						dispatch.DepthMask(reader.read<std::uint8_t>());
+						break;
+
+					case Opcode::COLOR_MASK: {
+						GLboolean mask[4];
+						for (auto & value : mask)
+							value = reader.read<std::uint8_t>();
+
+						dispatch.ColorMask(mask[0], mask[1], mask[2], mask[3]);
+						break;
+					}
+
+					case Opcode::VIEWPORT: {
+						GLint rectangle[4];
+						for (auto & value : rectangle)
+							value = reader.read<std::int32_t>();
+
+						dispatch.Viewport(rectangle[0], rectangle[1], rectangle[2], rectangle[3]);
+						break;
+					}
+
+					case Opcode::CLEAR_COLOR: {
+						GLfloat color[4];
+						for (auto & value : color)
+							value = reader.read<float>();
+
+						dispatch.ClearColor(color[0], color[1], color[2], color[3]);
+						break;
+					}
+
+					case Opcode::CLEAR:
+						dispatch.Clear(reader.read<std::uint32_t>());
+						break;
+
+					case Opcode::DRAW_ARRAYS: {
+						GLenum mode = reader.read<std::uint32_t>();
+						GLint first = reader.read<std::int32_t>();
+						dispatch.DrawArrays(mode, first, reader.read<std::int32_t>());
+						break;
+					}
+
+					case Opcode::DRAW_ELEMENTS: {
+						GLenum mode = reader.read<std::uint32_t>();
+						GLsizei count = reader.read<std::int32_t>();
+						GLenum type = reader.read<std::uint32_t>();
+						std::uintptr_t offset = reader.read<std::uint64_t>();
+						dispatch.DrawElements(mode, count, type, (const void *)offset);
+						break;
+					}
+
+					default:
+						throw std::runtime_error("Invalid graphics capture opcode!");
+				}
+			}
+
+			// Delete anything the stream didn't, so that the replay can be repeated:
+			for (auto & name : buffers)
+				dispatch.DeleteBuffers(1, &name.second);
+
+			for (auto & name : vertex_arrays)
+				dispatch.DeleteVertexArrays(1, &name.second);
+
+			for (auto & name : textures)
+				dispatch.DeleteTextures(1, &name.second);
+
+			for (auto & name : programs)
+				dispatch.DeleteProgram(name.second);
+
+			for (auto & name : shaders)
+				dispatch.DeleteShader(name.second);
+
+			dispatch.Finish();
+
+			return durations;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,322 @@
+//
+//  Graphics/GLCapture.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_GLCAPTURE_H
+#define _DREAM_CLIENT_GRAPHICS_GLCAPTURE_H
+
+#include "Graphics.h"
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+
+#ifndef DREAM_OPENGLES2
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/// The entry points which can be captured, as (member, function) pairs.
+#define DREAM_GL_DISPATCH_ENTRIES(X) \
+		X(GenBuffers, glGenBuffers) \
+		X(DeleteBuffers, glDeleteBuffers) \
+		X(BindBuffer, glBindBuffer) \
+		X(BindBufferBase, glBindBufferBase) \
+		X(BindBufferRange, glBindBufferRange) \
+		X(BufferData, glBufferData) \
+		X(BufferSubData, glBufferSubData) \
+		X(MapBuffer, glMapBuffer) \
+		X(MapBufferRange, glMapBufferRange) \
+		X(UnmapBuffer, glUnmapBuffer) \
+		X(GenVertexArrays, glGenVertexArrays) \
+		X(DeleteVertexArrays, glDeleteVertexArrays) \
+		X(BindVertexArray, glBindVertexArray) \
+		X(EnableVertexAttribArray, glEnableVertexAttribArray) \
+		X(DisableVertexAttribArray, glDisableVertexAttribArray) \
+		X(VertexAttribPointer, glVertexAttribPointer) \
+		X(GenTextures, glGenTextures) \
+		X(DeleteTextures, glDeleteTextures) \
+		X(ActiveTexture, glActiveTexture) \
+		X(BindTexture, glBindTexture) \
+		X(TexParameteri, glTexParameteri) \
+		X(TexParameterf, glTexParameterf) \
+		X(PixelStorei, glPixelStorei) \
+		X(TexImage1D, glTexImage1D) \
+		X(TexImage2D, glTexImage2D) \
+		X(TexImage3D, glTexImage3D) \
+		X(GenerateMipmap, glGenerateMipmap) \
+		X(CreateShader, glCreateShader) \
+		X(DeleteShader, glDeleteShader) \
+		X(ShaderSource, glShaderSource) \
+		X(CompileShader, glCompileShader) \
+		X(CreateProgram, glCreateProgram) \
+		X(DeleteProgram, glDeleteProgram) \
+		X(AttachShader, glAttachShader) \
+		X(DetachShader, glDetachShader) \
+		X(BindAttribLocation, glBindAttribLocation) \
+		X(BindFragDataLocation, glBindFragDataLocation) \
+		X(LinkProgram, glLinkProgram) \
+		X(UseProgram, glUseProgram) \
+		X(GetUniformLocation, glGetUniformLocation) \
+		X(GetUniformBlockIndex, glGetUniformBlockIndex) \
+		X(UniformBlockBinding, glUniformBlockBinding) \
+		X(Uniform1i, glUniform1i) \
+		X(Uniform1fv, glUniform1fv) \
+		X(Uniform2fv, glUniform2fv) \
+		X(Uniform3fv, glUniform3fv) \
+		X(Uniform4fv, glUniform4fv) \
+		X(Uniform1iv, glUniform1iv) \
+		X(Uniform2iv, glUniform2iv) \
+		X(Uniform3iv, glUniform3iv) \
+		X(Uniform4iv, glUniform4iv) \
+		X(Uniform1uiv, glUniform1uiv) \
+		X(Uniform2uiv, glUniform2uiv) \
+		X(Uniform3uiv, glUniform3uiv) \
+		X(Uniform4uiv, glUniform4uiv) \
+		X(UniformMatrix2fv, glUniformMatrix2fv) \
+		X(UniformMatrix3fv, glUniformMatrix3fv) \
+		X(UniformMatrix4fv, glUniformMatrix4fv) \
+		X(UniformMatrix2x3fv, glUniformMatrix2x3fv) \
+		X(UniformMatrix2x4fv, glUniformMatrix2x4fv) \
+		X(UniformMatrix3x2fv, glUniformMatrix3x2fv) \
+		X(UniformMatrix3x4fv, glUniformMatrix3x4fv) \
+		X(UniformMatrix4x2fv, glUniformMatrix4x2fv) \
+		X(UniformMatrix4x3fv, glUniformMatrix4x3fv) \
+		X(Enable, glEnable) \
+		X(Disable, glDisable) \
+		X(BlendFunc, glBlendFunc) \
+		X(DepthMask, glDepthMask) \
+		X(ColorMask, glColorMask) \
+		X(Viewport, glViewport) \
+		X(ClearColor, glClearColor) \
+		X(Clear, glClear) \
+		X(DrawArrays, glDrawArrays) \
+		X(DrawElements, glDrawElements) \
+		X(Finish, glFinish)
+
+		/**
+		 A table of GL entry points. When the library is compiled with `DREAM_GL_CAPTURE` defined, calls to the entry points above go through `gl_dispatch`, so that they can be intercepted at run time. Otherwise, they are called directly and the table is only used for replay.
+		 */
+		struct GLDispatch {
+#define DREAM_GL_DISPATCH_MEMBER(name, function) decltype(&function) name;
+			DREAM_GL_DISPATCH_ENTRIES(DREAM_GL_DISPATCH_MEMBER)
+#undef DREAM_GL_DISPATCH_MEMBER
+
+			/// The entry points provided by the system.
+			static GLDispatch system();
+		};
+
+		extern GLDispatch gl_dispatch;
+
+		/**
+		 Records the GL call stream, including buffer and texture payloads, into a compact binary format which can be replayed by `GLReplay`:
+
+		 	std::ofstream output("scene.glcapture", std::ios::binary);
+		 	GLCapture capture(output);
+
+		 	// Load the scene, then render some frames, calling `capture.frame()` after each one.
+
+		 Only calls made through `gl_dispatch` are recorded, so the library must be compiled with `DREAM_GL_CAPTURE`. Object names, uniform locations and uniform block indices are recorded as they were returned, and remapped on replay, so the capture should begin before the resources it uses are created. Data written into mapped buffers is recorded when the buffer is unmapped; persistently mapped buffers are not supported.
+
+		 Programs loaded from binaries, e.g. by `ProgramBinaryCache`, are not recorded, so captures which use a program cache can't be replayed. Disable the cache while capturing. Framebuffers, queries, program pipelines, transform feedback and immutable buffer storage (e.g. `UniformRing` when buffer storage is available) are not recorded either.
+
+		 Only one capture can be active at a time, and calls must be made from the thread which owns the context.
+		 */
+		class GLCapture : private NonCopyable {
+		public:
+			enum class Opcode : std::uint8_t {
+				FRAME,
+				GEN_BUFFERS, DELETE_BUFFERS, BIND_BUFFER, BIND_BUFFER_BASE, BIND_BUFFER_RANGE, BUFFER_DATA, BUFFER_SUB_DATA,
+				GEN_VERTEX_ARRAYS, DELETE_VERTEX_ARRAYS, BIND_VERTEX_ARRAY, ENABLE_VERTEX_ATTRIB_ARRAY, DISABLE_VERTEX_ATTRIB_ARRAY, VERTEX_ATTRIB_POINTER,
+				GEN_TEXTURES, DELETE_TEXTURES, ACTIVE_TEXTURE, BIND_TEXTURE, TEX_PARAMETER_I, TEX_PARAMETER_F, PIXEL_STORE_I, TEX_IMAGE_2D, GENERATE_MIPMAP,
+				CREATE_SHADER, DELETE_SHADER, SHADER_SOURCE, COMPILE_SHADER,
+				CREATE_PROGRAM, DELETE_PROGRAM, ATTACH_SHADER, DETACH_SHADER, BIND_ATTRIB_LOCATION, BIND_FRAG_DATA_LOCATION, LINK_PROGRAM, USE_PROGRAM, GET_UNIFORM_LOCATION, GET_UNIFORM_BLOCK_INDEX, UNIFORM_BLOCK_BINDING,
+				UNIFORM_1I, UNIFORM_1FV, UNIFORM_2FV, UNIFORM_3FV, UNIFORM_4FV, UNIFORM_1IV, UNIFORM_2IV, UNIFORM_3IV, UNIFORM_4IV,
+				UNIFORM_MATRIX_2FV, UNIFORM_MATRIX_3FV, UNIFORM_MATRIX_4FV,
+				ENABLE, DISABLE, BLEND_FUNC, DEPTH_MASK, COLOR_MASK, VIEWPORT, CLEAR_COLOR, CLEAR,
+				DRAW_ARRAYS, DRAW_ELEMENTS,
+
+				// Added later, so that existing captures keep their opcodes:
+				TEX_IMAGE_1D, TEX_IMAGE_3D,
+				UNIFORM_1UIV, UNIFORM_2UIV, UNIFORM_3UIV, UNIFORM_4UIV,
+				UNIFORM_MATRIX_2X3FV, UNIFORM_MATRIX_2X4FV, UNIFORM_MATRIX_3X2FV, UNIFORM_MATRIX_3X4FV, UNIFORM_MATRIX_4X2FV, UNIFORM_MATRIX_4X3FV,
+			};
+
+			/// Identifies the format, and is followed by the version.
+			static const char MAGIC[4];
+			static const std::uint32_t VERSION;
+
+		protected:
+			std::ostream & _output;
+
+			// Records are buffered and written out at the end of each frame:
+			std::vector<ByteT> _buffer;
+
+			// The entry points which were installed before the capture began, and which the recorded calls are forwarded to:
+			GLDispatch _next;
+
+			struct Mapping {
+				GLintptr offset;
+				GLsizeiptr length;
+				void * data;
+			};
+
+			// Mapped ranges by target, recorded when the buffer is unmapped:
+			std::map<GLenum, Mapping> _mappings;
+
+			// Bound buffers by target, so that the size of a whole buffer mapping can be found:
+			std::map<GLenum, GLuint> _buffers;
+			std::unordered_map<GLuint, GLsizeiptr> _buffer_sizes;
+
+			GLint _unpack_alignment = 4;
+
+			std::size_t _frame_count = 0;
+			std::size_t _byte_count = 0;
+
+			void flush();
+
+			template <typename ValueT>
+			void write(ValueT value) {
+				const ByteT * bytes = (const ByteT *)&value;
+				_buffer.insert(_buffer.end(), bytes, bytes + sizeof(ValueT));
+			}
+
+			void write_data(const void * data, std::size_t size);
+
+			void write_opcode(Opcode opcode) {
+				write((std::uint8_t)opcode);
+			}
+
+			// The recording entry points are implemented in terms of the active capture:
+			friend struct GLRecorder;
+
+		public:
+			/// Begins capturing immediately, by installing recording entry points into `gl_dispatch`.
+			GLCapture(std::ostream & output);
+
+			/// Restores the previous entry points and writes any remaining records.
+			~GLCapture();
+
+			/// Mark the end of a frame. Replay timings are reported per frame.
+			void frame();
+
+			std::size_t frame_count() const { return _frame_count; }
+
+			/// The number of bytes written so far, including the header.
+			std::size_t byte_count() const { return _byte_count; }
+
+			static GLCapture * current();
+		};
+
+		/**
+		 Replays a stream recorded by `GLCapture`, timing each frame. Object names, uniform locations and uniform block indices are remapped to the ones created by the replay. Each frame is finished before it is timed, so the timings include GPU work.
+
+		 Replaying again creates the resources again: any objects which weren't deleted by the stream are deleted at the end of each replay.
+		 */
+		class GLReplay {
+		public:
+			typedef GLCapture::Opcode Opcode;
+
+		protected:
+			std::vector<ByteT> _data;
+
+			// The offset of the first record, after the header:
+			std::size_t _begin;
+
+		public:
+			/// Reads the whole stream. Throws std::runtime_error if it isn't a valid capture.
+			GLReplay(std::istream & input);
+
+			/// Replay all frames, returning the duration of each one, in milliseconds. Records after the last frame are replayed but not timed.
+			std::vector<double> replay(const GLDispatch & dispatch = GLDispatch::system()) const;
+		};
+	}
+}
+
+// Route the library's calls through the dispatch table:
+#if defined(DREAM_GL_CAPTURE) && !defined(DREAM_GL_DISPATCH_IMPLEMENTATION)
+	#define glGenBuffers Dream::Graphics::gl_dispatch.GenBuffers
+	#define glDeleteBuffers Dream::Graphics::gl_dispatch.DeleteBuffers
+	#define glBindBuffer Dream::Graphics::gl_dispatch.BindBuffer
+	#define glBindBufferBase Dream::Graphics::gl_dispatch.BindBufferBase
+	#define glBindBufferRange Dream::Graphics::gl_dispatch.BindBufferRange
+	#define glBufferData Dream::Graphics::gl_dispatch.BufferData
+	#define glBufferSubData Dream::Graphics::gl_dispatch.BufferSubData
+	#define glMapBuffer Dream::Graphics::gl_dispatch.MapBuffer
+	#define glMapBufferRange Dream::Graphics::gl_dispatch.MapBufferRange
+	#define glUnmapBuffer Dream::Graphics::gl_dispatch.UnmapBuffer
+	#define glGenVertexArrays Dream::Graphics::gl_dispatch.GenVertexArrays
+	#define glDeleteVertexArrays Dream::Graphics::gl_dispatch.DeleteVertexArrays
+	#define glBindVertexArray Dream::Graphics::gl_dispatch.BindVertexArray
+	#define glEnableVertexAttribArray Dream::Graphics::gl_dispatch.EnableVertexAttribArray
+	#define glDisableVertexAttribArray Dream::Graphics::gl_dispatch.DisableVertexAttribArray
+	#define glVertexAttribPointer Dream::Graphics::gl_dispatch.VertexAttribPointer
+	#define glGenTextures Dream::Graphics::gl_dispatch.GenTextures
+	#define glDeleteTextures Dream::Graphics::gl_dispatch.DeleteTextures
+	#define glActiveTexture Dream::Graphics::gl_dispatch.ActiveTexture
+	#define glBindTexture Dream::Graphics::gl_dispatch.BindTexture
+	#define glTexParameteri Dream::Graphics::gl_dispatch.TexParameteri
+	#define glTexParameterf Dream::Graphics::gl_dispatch.TexParameterf
+	#define glPixelStorei Dream::Graphics::gl_dispatch.PixelStorei
+	#define glTexImage1D Dream::Graphics::gl_dispatch.TexImage1D
+	#define glTexImage2D Dream::Graphics::gl_dispatch.TexImage2D
+	#define glTexImage3D Dream::Graphics::gl_dispatch.TexImage3D
+	#define glGenerateMipmap Dream::Graphics::gl_dispatch.GenerateMipmap
+	#define glCreateShader Dream::Graphics::gl_dispatch.CreateShader
+	#define glDeleteShader Dream::Graphics::gl_dispatch.DeleteShader
+	#define glShaderSource Dream::Graphics::gl_dispatch.ShaderSource
+	#define glCompileShader Dream::Graphics::gl_dispatch.CompileShader
+	#define glCreateProgram Dream::Graphics::gl_dispatch.CreateProgram
+	#define glDeleteProgram Dream::Graphics::gl_dispatch.DeleteProgram
+	#define glAttachShader Dream::Graphics::gl_dispatch.AttachShader
+	#define glDetachShader Dream::Graphics::gl_dispatch.DetachShader
+	#define glBindAttribLocation Dream::Graphics::gl_dispatch.BindAttribLocation
+	#define glBindFragDataLocation Dream::Graphics::gl_dispatch.BindFragDataLocation
+	#define glLinkProgram Dream::Graphics::gl_dispatch.LinkProgram
+	#define glUseProgram Dream::Graphics::gl_dispatch.UseProgram
+	#define glGetUniformLocation Dream::Graphics::gl_dispatch.GetUniformLocation
+	#define glGetUniformBlockIndex Dream::Graphics::gl_dispatch.GetUniformBlockIndex
+	#define glUniformBlockBinding Dream::Graphics::gl_dispatch.UniformBlockBinding
+	#define glUniform1i Dream::Graphics::gl_dispatch.Uniform1i
+	#define glUniform1fv Dream::Graphics::gl_dispatch.Uniform1fv
+	#define glUniform2fv Dream::Graphics::gl_dispatch.Uniform2fv
+	#define glUniform3fv Dream::Graphics::gl_dispatch.Uniform3fv
+	#define glUniform4fv Dream::Graphics::gl_dispatch.Uniform4fv
+	#define glUniform1iv Dream::Graphics::gl_dispatch.Uniform1iv
+	#define glUniform2iv Dream::Graphics::gl_dispatch.Uniform2iv
+	#define glUniform3iv Dream::Graphics::gl_dispatch.Uniform3iv
+	#define glUniform4iv Dream::Graphics::gl_dispatch.Uniform4iv
+	#define glUniform1uiv Dream::Graphics::gl_dispatch.Uniform1uiv
+	#define glUniform2uiv Dream::Graphics::gl_dispatch.Uniform2uiv
+	#define glUniform3uiv Dream::Graphics::gl_dispatch.Uniform3uiv
+	#define glUniform4uiv Dream::Graphics::gl_dispatch.Uniform4uiv
+	#define glUniformMatrix2fv Dream::Graphics::gl_dispatch.UniformMatrix2fv
+	#define glUniformMatrix3fv Dream::Graphics::gl_dispatch.UniformMatrix3fv
+	#define glUniformMatrix4fv Dream::Graphics::gl_dispatch.UniformMatrix4fv
+	#define glUniformMatrix2x3fv Dream::Graphics::gl_dispatch.UniformMatrix2x3fv
+	#define glUniformMatrix2x4fv Dream::Graphics::gl_dispatch.UniformMatrix2x4fv
+	#define glUniformMatrix3x2fv Dream::Graphics::gl_dispatch.UniformMatrix3x2fv
+	#define glUniformMatrix3x4fv Dream::Graphics::gl_dispatch.UniformMatrix3x4fv
+	#define glUniformMatrix4x2fv Dream::Graphics::gl_dispatch.UniformMatrix4x2fv
+	#define glUniformMatrix4x3fv Dream::Graphics::gl_dispatch.UniformMatrix4x3fv
+	#define glEnable Dream::Graphics::gl_dispatch.Enable
+	#define glDisable Dream::Graphics::gl_dispatch.Disable
+	#define glBlendFunc Dream::Graphics::gl_dispatch.BlendFunc
+	#define glDepthMask Dream::Graphics::gl_dispatch.DepthMask
+	#define glColorMask Dream::Graphics::gl_dispatch.ColorMask
+	#define glViewport Dream::Graphics::gl_dispatch.Viewport
+	#define glClearColor Dream::Graphics::gl_dispatch.ClearColor
+	#define glClear Dream::Graphics::gl_dispatch.Clear
+	#define glDrawArrays Dream::Graphics::gl_dispatch.DrawArrays
+	#define glDrawElements Dream::Graphics::gl_dispatch.DrawElements
+	#define glFinish Dream::Graphics::gl_dispatch.Finish
+#endif
+
+#endif
+
+#endif
@@ -0,0 +1,191 @@
+//
+//  Graphics/GPUProfiler.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		static thread_local GPUProfiler * _current_gpu_profiler = nullptr;
+
+		GPUProfiler * GPUProfiler::current()
+		{
+			return _current_gpu_profiler;
+		}
+
+		void GPUProfiler::set_current(GPUProfiler * profiler)
+		{
+			_current_gpu_profiler = profiler;
+		}
+
+		GPUProfiler::GPUProfiler(std::size_t latency, std::size_t window) : _query_pool(new QueryPool(GL_TIMESTAMP)), _latency(std::max<std::size_t>(latency, 1)), _window(std::max<std::size_t>(window, 1))
+		{
+		}
+
+		GPUProfiler::~GPUProfiler()
+		{
+			if (current() == this)
+				set_current(nullptr);
+		}
+
+		void GPUProfiler::begin_frame()
+		{
+			// Queries complete in order, so a frame is complete when its last query is:
+			while (!_frames.empty()) {
+				Frame & frame = _frames.front();
+
+				if (frame.last_query && !QueryPool::available(frame.last_query)) {
+					// Don't wait for the GPU. If it is too far behind, give up on the oldest frame:
+					if (_frames.size() < _latency)
+						break;
+
+					_dropped_frames += 1;
+				} else {
+					resolve(frame);
+				}
+
+				release(frame);
+				_frames.pop_front();
+			}
+
+			// A frame which was never ended still holds its queries:
+			release(_frame);
+			_frame = Frame();
+			_stack.clear();
+		}
+
+		void GPUProfiler::end_frame()
+		{
+			DREAM_ASSERT(_stack.empty() && "GPU profiler scopes were not closed!");
+
+			_frames.push_back(_frame);
+			_frame = Frame();
+		}
+
+		void GPUProfiler::begin_scope(const char * name)
+		{
+			Record record{name, _stack.size(), _query_pool->allocate(), 0};
+
+			glQueryCounter(record.begin_query, GL_TIMESTAMP);
+			_frame.last_query = record.begin_query;
+
+			_stack.push_back(_frame.records.size());
+			_frame.records.push_back(record);
+		}
+
+		void GPUProfiler::end_scope()
+		{
+			DREAM_ASSERT(!_stack.empty());
+
+			Record & record = _frame.records[_stack.back()];
+			_stack.pop_back();
+
+			record.end_query = _query_pool->allocate();
+			glQueryCounter(record.end_query, GL_TIMESTAMP);
+			_frame.last_query = record.end_query;
+		}
+
+		void GPUProfiler::resolve(Frame & frame)
+		{
+			for (auto & record : frame.records) {
+				GLuint64 begin = 0, end = 0;
+
+				glGetQueryObjectui64v(record.begin_query, GL_QUERY_RESULT, &begin);
+				glGetQueryObjectui64v(record.end_query, GL_QUERY_RESULT, &end);
+
+				Samples & samples = _samples[record.name];
+
+				if (samples.values.size() < _window)
+					samples.values.push_back(0);
+
+				samples.values[samples.next] = (end - begin) / 1e6;
+				samples.next = (samples.next + 1) % _window;
+				samples.count += 1;
+
+				if (_capturing) {
+					if (_origin == 0)
+						_origin = begin;
+
+					_events.push_back(Event{record.name, record.depth, begin - _origin, end - _origin});
+				}
+			}
+		}
+
+		void GPUProfiler::release(Frame & frame)
+		{
+			for (auto & record : frame.records) {
+				_query_pool->release(record.begin_query);
+
+				// Scopes which were never closed don't have an end query:
+				if (record.end_query)
+					_query_pool->release(record.end_query);
+			}
+		}
+
+		std::map<StringT, GPUProfiler::Timing> GPUProfiler::timings() const
+		{
+			std::map<StringT, Timing> timings;
+
+			for (auto & entry : _samples) {
+				const Samples & samples = entry.second;
+
+				if (samples.values.empty())
+					continue;
+
+				Timing & timing = timings[entry.first];
+
+				timing.count = samples.count;
+				timing.minimum = *std::min_element(samples.values.begin(), samples.values.end());
+				timing.maximum = *std::max_element(samples.values.begin(), samples.values.end());
+				timing.last = samples.values[(samples.next + samples.values.size() - 1) % samples.values.size()];
+
+				double total = 0;
+				for (auto value : samples.values)
+					total += value;
+
+				timing.average = total / samples.values.size();
+			}
+
+			return timings;
+		}
+
+		void GPUProfiler::set_capturing(bool capturing)
+		{
+			if (capturing && !_capturing) {
+				_events.clear();
+				_origin = 0;
+			}
+
+			_capturing = capturing;
+		}
+
+		void GPUProfiler::write_trace(std::ostream & output) const
+		{
+			auto flags = output.flags();
+			auto precision = output.precision();
+
+			output << std::fixed << std::setprecision(3);
+			output << "{\"traceEvents\":[\n";
+
+			output << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"GPU\"}}";
+
+			for (auto & event : _events) {
+				// Complete events, with times in microseconds:
+				output << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":" << (event.begin / 1000.0) << ",\"dur\":" << ((event.end - event.begin) / 1000.0) << "}";
+			}
+
+			output << "\n]}\n";
+
+			output.flags(flags);
+			output.precision(precision);
+		}
+#endif
+	}
+}
@@ -0,0 +1,151 @@
+//
+//  Graphics/GPUProfiler.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_GPUPROFILER_H
+#define _DREAM_CLIENT_GRAPHICS_GPUPROFILER_H
+
+#include "QueryPool.h"
+
+#include <deque>
+#include <map>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		/**
+		 Measures the GPU time spent in named scopes, using timestamp queries. Timestamps are used rather than GL_TIME_ELAPSED because elapsed queries can't be nested.
+
+		 	gpu_profiler->begin_frame();
+
+		 	{
+		 		DREAM_GPU_SCOPE("Scene");
+		 		// Draw the scene...
+		 	}
+
+		 	gpu_profiler->end_frame();
+
+		 Results are read several frames later, once they are available, so profiling never stalls the pipeline. If the GPU falls too far behind, the oldest frame is discarded rather than waited for. Scopes use the current profiler of the calling thread, and do nothing if there isn't one, so renderers can be instrumented permanently.
+		 */
+		class GPUProfiler : public Object {
+		public:
+			struct Timing {
+				std::size_t count = 0;
+
+				// In milliseconds, over the most recent samples:
+				double minimum = 0, average = 0, maximum = 0, last = 0;
+			};
+
+			struct Event {
+				const char * name;
+				std::size_t depth;
+
+				// In nanoseconds, relative to the first frame which was captured:
+				std::uint64_t begin, end;
+			};
+
+		protected:
+			struct Record {
+				const char * name;
+				std::size_t depth;
+				GLuint begin_query, end_query;
+			};
+
+			struct Frame {
+				std::vector<Record> records;
+
+				// The most recently issued query. Records are in the order scopes began, so with nested scopes this isn't the end query of the last record:
+				GLuint last_query = 0;
+			};
+
+			Ref<QueryPool> _query_pool;
+
+			std::size_t _latency;
+			std::size_t _window;
+
+			// Frames whose results haven't been read yet, oldest first:
+			std::deque<Frame> _frames;
+			Frame _frame;
+
+			std::vector<std::size_t> _stack;
+
+			struct Samples {
+				std::vector<double> values;
+				std::size_t next = 0;
+				std::size_t count = 0;
+			};
+
+			std::map<StringT, Samples> _samples;
+
+			bool _capturing = false;
+			std::uint64_t _origin = 0;
+			std::vector<Event> _events;
+
+			std::size_t _dropped_frames = 0;
+
+			// Read the results of a frame whose queries are all available:
+			void resolve(Frame & frame);
+			void release(Frame & frame);
+
+		public:
+			/// Results are read at most latency frames later. Timings are computed over the given number of recent samples.
+			GPUProfiler(std::size_t latency = 3, std::size_t window = 64);
+			virtual ~GPUProfiler();
+
+			/// Collect results which are available.
+			void begin_frame();
+			void end_frame();
+
+			/// Scopes must be strictly nested. The name must remain valid until the results are read, e.g. a string literal.
+			void begin_scope(const char * name);
+			void end_scope();
+
+			/// Timings for each scope name.
+			std::map<StringT, Timing> timings() const;
+
+			/// Record every scope, for export to a trace.
+			void set_capturing(bool capturing);
+			bool capturing() const { return _capturing; }
+
+			const std::vector<Event> & events() const { return _events; }
+
+			/// Write the captured events in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto.
+			void write_trace(std::ostream & output) const;
+
+			/// Frames which were discarded because their results weren't available in time.
+			std::size_t dropped_frames() const { return _dropped_frames; }
+
+			/// The current profiler of the calling thread, or null.
+			static GPUProfiler * current();
+			static void set_current(GPUProfiler * profiler);
+
+			class Scope : private NonCopyable {
+			protected:
+				GPUProfiler * _profiler;
+
+			public:
+				Scope(const char * name) : _profiler(current()) {
+					if (_profiler)
+						_profiler->begin_scope(name);
+				}
+
+				~Scope() {
+					if (_profiler)
+						_profiler->end_scope();
+				}
+			};
+		};
+
+		#define DREAM_GPU_SCOPE_NAME2(line) _dream_gpu_scope_ ## line
+		#define DREAM_GPU_SCOPE_NAME(line) DREAM_GPU_SCOPE_NAME2(line)
+		#define DREAM_GPU_SCOPE(name) Dream::Graphics::GPUProfiler::Scope DREAM_GPU_SCOPE_NAME(__LINE__)(name)
+#else
+		#define DREAM_GPU_SCOPE(name)
+#endif
+	}
+}
+
+#endif
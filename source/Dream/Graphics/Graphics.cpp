@@ -7,24 +7,231 @@
 //
 
 #include "Graphics.h"
+#include "FrameStats.h"
+
+#include <cstring>
 
 namespace Dream
 {
 	namespace Graphics
 	{
-		void check_graphics_error()
+		namespace
 		{
 #ifdef DREAM_DEBUG
-			GLenum error = GL_NO_ERROR;
+			ErrorCheckMode _error_check_mode = ERROR_CHECK_IMMEDIATE;
+#else
+			ErrorCheckMode _error_check_mode = ERROR_CHECK_NONE;
+#endif
+
+			// The most recent call site checked on this thread, so that deferred errors can be reported near where they happened:
+			thread_local const char * _error_file = nullptr;
+			thread_local int _error_line = 0;
+
+			void log_error_site(LogBuffer & buffer, const char * relation)
+			{
+				if (_error_file)
+					buffer << " " << relation << " " << _error_file << ":" << _error_line;
+			}
+
+			void check_errors(const char * relation)
+			{
+				GLenum error = GL_NO_ERROR;
+
+				while (true) {
+					error = glGetError();
+					FrameStats::count(FrameStats::ERROR_CHECKS);
+
+					if (error == GL_NO_ERROR)
+						break;
+
+					LogBuffer buffer;
+					buffer << "OpenGL Error #" << error;
+					log_error_site(buffer, relation);
+
+					logger()->log(LOG_ERROR, buffer);
+
+#ifdef DREAM_DEBUG
+					// Abort due to error
+					DREAM_ASSERT(error == GL_NO_ERROR);
+#endif
+				}
+			}
+
+#ifdef GL_DEBUG_OUTPUT
+	#ifndef APIENTRY
+		#define APIENTRY
+	#endif
+
+			void APIENTRY debug_message_callback(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar * message, const void * user_parameter)
+			{
+				if (severity == GL_DEBUG_SEVERITY_NOTIFICATION)
+					return;
+
+				LogBuffer buffer;
+				buffer << "OpenGL Debug #" << id << ": " << message;
+
+				// The callback runs before the failing call returns, so the site is the check preceding it:
+				log_error_site(buffer, "after");
+
+				if (type == GL_DEBUG_TYPE_ERROR) {
+					logger()->log(LOG_ERROR, buffer);
+
+#ifdef DREAM_DEBUG
+					DREAM_ASSERT(type != GL_DEBUG_TYPE_ERROR);
+#endif
+				} else {
+					logger()->log(LOG_WARN, buffer);
+				}
+			}
+#endif
+		}
+
+		ErrorCheckMode set_error_check_mode(ErrorCheckMode mode)
+		{
+#ifdef GL_DEBUG_OUTPUT
+			if (_error_check_mode == ERROR_CHECK_DEBUG_OUTPUT && mode != ERROR_CHECK_DEBUG_OUTPUT) {
+				glDisable(GL_DEBUG_OUTPUT);
+				glDebugMessageCallback(nullptr, nullptr);
+			}
+
+			if (mode == ERROR_CHECK_DEBUG_OUTPUT) {
+				if (has_graphics_extension("GL_KHR_debug")) {
+					glDebugMessageCallback(debug_message_callback, nullptr);
+					glEnable(GL_DEBUG_OUTPUT);
+
+#ifdef DREAM_DEBUG
+					glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+#endif
+				} else {
+					mode = ERROR_CHECK_FRAME;
+				}
+			}
+#else
+			if (mode == ERROR_CHECK_DEBUG_OUTPUT)
+				mode = ERROR_CHECK_FRAME;
+#endif
+
+			_error_check_mode = mode;
+
+			return mode;
+		}
+
+		ErrorCheckMode error_check_mode()
+		{
+			return _error_check_mode;
+		}
+
+		void check_graphics_error(const char * file, int line)
+		{
+			switch (_error_check_mode) {
+				case ERROR_CHECK_NONE:
+					break;
+
+				case ERROR_CHECK_IMMEDIATE:
+					_error_file = file;
+					_error_line = line;
+
+					check_errors("before");
+					break;
 
-			while ((error = glGetError()) != GL_NO_ERROR) {
-				logger()->log(LOG_ERROR, LogBuffer() << "OpenGL Error #" << error);
+				case ERROR_CHECK_FRAME:
+				case ERROR_CHECK_DEBUG_OUTPUT:
+					_error_file = file;
+					_error_line = line;
+					break;
+			}
+		}
+
+		void check_graphics_error()
+		{
+			check_graphics_error(nullptr, 0);
+		}
+
+		void check_frame_graphics_errors()
+		{
+			if (_error_check_mode == ERROR_CHECK_FRAME)
+				check_errors("during the frame, last checked at");
+		}
+
+		bool has_graphics_extension(const char * name)
+		{
+#ifdef DREAM_OPENGLES2
+			const char * extensions = (const char *)glGetString(GL_EXTENSIONS);
+			std::size_t length = std::strlen(name);
 
-				// Abort due to error
-				DREAM_ASSERT(error == GL_NO_ERROR);
+			// The extensions are a single space separated string, so make sure we match a whole name:
+			for (const char * match = extensions; match && (match = std::strstr(match, name)); match += length) {
+				if ((match == extensions || match[-1] == ' ') && (match[length] == ' ' || match[length] == '\0'))
+					return true;
 			}
+#else
+			GLint count = 0;
+			glGetIntegerv(GL_NUM_EXTENSIONS, &count);
 
+			for (GLint i = 0; i < count; i += 1) {
+				if (std::strcmp((const char *)glGetStringi(GL_EXTENSIONS, i), name) == 0)
+					return true;
+			}
+#endif
+
+			return false;
+		}
+
+		std::size_t pixel_size(GLenum format, GLenum data_type)
+		{
+			std::size_t components = 0, component_size = 0;
+
+			switch (format) {
+				case GL_ALPHA:
+#ifdef GL_LUMINANCE
+				case GL_LUMINANCE:
+#endif
+#ifdef GL_RED
+				case GL_RED:
+#endif
+					components = 1; break;
+#ifdef GL_LUMINANCE_ALPHA
+				case GL_LUMINANCE_ALPHA:
 #endif
+#ifdef GL_RG
+				case GL_RG:
+#endif
+					components = 2; break;
+				case GL_RGB:
+#ifdef GL_BGR
+				case GL_BGR:
+#endif
+					components = 3; break;
+				case GL_RGBA:
+#ifdef GL_BGRA
+				case GL_BGRA:
+#endif
+					components = 4; break;
+			}
+
+			switch (data_type) {
+				case GL_UNSIGNED_BYTE:
+				case GL_BYTE:
+					component_size = 1; break;
+				case GL_UNSIGNED_SHORT:
+				case GL_SHORT:
+#ifdef GL_HALF_FLOAT
+				case GL_HALF_FLOAT:
+#endif
+					component_size = 2; break;
+				case GL_UNSIGNED_INT:
+				case GL_INT:
+				case GL_FLOAT:
+					component_size = 4; break;
+
+				// Packed types store the whole pixel in one value:
+				case GL_UNSIGNED_SHORT_5_6_5:
+				case GL_UNSIGNED_SHORT_4_4_4_4:
+				case GL_UNSIGNED_SHORT_5_5_5_1:
+					return 2;
+			}
+
+			return components * component_size;
 		}
 	}
 }
@@ -43,8 +43,40 @@ namespace Dream
 	{
 		using namespace Display;
 
+		/// How errors from OpenGL calls are detected. glGetError may synchronise with the driver, so checking after every call is expensive.
+		enum ErrorCheckMode {
+			/// Errors are ignored.
+			ERROR_CHECK_NONE,
+
+			/// glGetError is called at every check. This is the default for debug builds.
+			ERROR_CHECK_IMMEDIATE,
+
+			/// glGetError is called once per frame by `check_frame_graphics_errors`. Errors are only reported with the last call site checked during the frame, which may be far from the failing call.
+			ERROR_CHECK_FRAME,
+
+			/// Errors are reported by the driver through a GL_KHR_debug message callback, with the most recent call site which was checked. In debug builds, output is synchronous, so the failing call is the first one after that site, but the call itself isn't known.
+			ERROR_CHECK_DEBUG_OUTPUT,
+		};
+
+		/// Select how errors are checked, returning the mode which was selected. If debug output isn't supported, per-frame checks are used instead.
+		ErrorCheckMode set_error_check_mode(ErrorCheckMode mode);
+		ErrorCheckMode error_check_mode();
+
+		/// Check for errors from preceding calls, according to the error check mode. Use `DREAM_CHECK_GRAPHICS_ERROR` so that errors are reported at the call site.
+		void check_graphics_error(const char * file, int line);
 		void check_graphics_error();
 
+		/// Check for errors once per frame, when using ERROR_CHECK_FRAME.
+		void check_frame_graphics_errors();
+
+#define DREAM_CHECK_GRAPHICS_ERROR() Dream::Graphics::check_graphics_error(__FILE__, __LINE__)
+
+		/// Whether the current context supports the named extension, e.g. "GL_KHR_parallel_shader_compile".
+		bool has_graphics_extension(const char * name);
+
+		/// The size in bytes of one pixel in the given client format and data type, or zero if unknown.
+		std::size_t pixel_size(GLenum format, GLenum data_type);
+
 		template <typename TypeT>
 		struct GLTypeTraits {};
 
@@ -60,4 +92,9 @@ namespace Dream
 	}
 }
 
+// Calls can be routed through a dispatch table, so that they can be captured for replay:
+#ifdef DREAM_GL_CAPTURE
+	#include "GLCapture.h"
+#endif
+
 #endif
@@ -0,0 +1,42 @@
+//
+//  Graphics/Hash.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "Hash.h"
+
+#include <iomanip>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		void Hash::append(const void * data, std::size_t size)
+		{
+			const ByteT * bytes = (const ByteT *)data;
+
+			for (std::size_t i = 0; i < size; i += 1) {
+				_value ^= bytes[i];
+				_value *= 1099511628211ULL;
+			}
+		}
+
+		void Hash::append(HashT value)
+		{
+			ByteT bytes[sizeof(value)];
+
+			for (std::size_t i = 0; i < sizeof(value); i += 1)
+				bytes[i] = (ByteT)(value >> (i * 8));
+
+			append(bytes, sizeof(bytes));
+		}
+
+		StringT Hash::to_hex() const
+		{
+			StringStreamT buffer;
+			buffer << std::hex << std::setw(16) << std::setfill('0') << _value;
+
+			return buffer.str();
+		}
+	}
+}
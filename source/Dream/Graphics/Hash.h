@@ -0,0 +1,43 @@
+//
+//  Graphics/Hash.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_HASH_H
+#define _DREAM_CLIENT_GRAPHICS_HASH_H
+
+#include <Dream/Framework.h>
+
+#include <cstdint>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		typedef std::uint64_t HashT;
+
+		/// An incremental 64-bit FNV-1a hash. Unlike std::hash, the result is stable across runs and platforms, so it is suitable for keying data which is stored on disk.
+		class Hash {
+		protected:
+			HashT _value;
+
+		public:
+			Hash() : _value(14695981039346656037ULL) {}
+
+			void append(const void * data, std::size_t size);
+
+			void append(const StringT & string) { append(string.data(), string.size()); }
+			void append(const Buffer & buffer) { append(buffer.begin(), buffer.size()); }
+
+			/// Integers are appended as little endian bytes, so the result doesn't depend on the byte order of the platform.
+			void append(HashT value);
+
+			HashT value() const { return _value; }
+
+			/// The value as a fixed width hexadecimal string, e.g. for use in file names.
+			StringT to_hex() const;
+		};
+	}
+}
+
+#endif
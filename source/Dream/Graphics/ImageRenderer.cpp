@@ -7,6 +7,7 @@
 //
 
 #include "ImageRenderer.h"
+#include "Trace.h"
 
 namespace Dream
 {
@@ -34,6 +35,8 @@ namespace Dream
 		}
 
 		Ref<Texture> ImageRenderer::fetch(Ptr<Image> image, bool invalidate) {
+			DREAM_TRACE_ZONE("ImageRenderer::fetch");
+
 			DREAM_ASSERT(image);
 
 			// We assume that the buffer doesn't need to be changed unless the pointers are different or invalidate is true.
@@ -82,6 +85,8 @@ namespace Dream
 		}
 
 		void ImageRenderer::render(const AlignedBox2 & box, Ptr<Image> image, Vec2b flip, RotationT rotation) {
+			DREAM_GPU_SCOPE("ImageRenderer::render");
+
 			const Vec2b CORNERS[] = {
 				Vec2b(false, false),
 				Vec2b(true, false),
@@ -119,7 +124,7 @@ namespace Dream
 				auto binding = _vertex_array.binding();
 				auto buffer_binding = _vertex_buffer.binding();
 
-				check_graphics_error();
+				DREAM_CHECK_GRAPHICS_ERROR();
 
 				buffer_binding.set_data(vertices);
 				binding.draw_arrays(GL_TRIANGLE_STRIP, 0, vertices.size());
@@ -128,6 +133,8 @@ namespace Dream
 
 		void ImageRenderer::render(const AlignedBox2 & box, Ptr<Image> image, const AlignedBox2 & inner)
 		{
+			DREAM_GPU_SCOPE("ImageRenderer::render");
+
 			// If the inner alignment box is bigger than the box we are rendering, we have no choice but to scale the inner box:
 			
 			Vec2 border_size = image->size() - inner.size();
@@ -202,7 +209,7 @@ namespace Dream
 				auto binding = _vertex_array.binding();
 				auto buffer_binding = _vertex_buffer.binding();
 
-				check_graphics_error();
+				DREAM_CHECK_GRAPHICS_ERROR();
 
 				buffer_binding.set_data(vertices);
 				binding.draw_arrays(GL_TRIANGLE_STRIP, 0, vertices.size());
@@ -10,6 +10,8 @@
 #define _DREAM_CLIENT_GRAPHICS_MESHBUFFER_H
 
 #include "VertexArray.h"
+#include "OcclusionQuery.h"
+#include "GPUProfiler.h"
 #include <Euclid/Geometry/Mesh.h>
 
 namespace Dream
@@ -35,6 +37,11 @@ namespace Dream
 
 			bool _invalid;
 
+#ifndef DREAM_OPENGLES2
+			// Optional, if set, drawing is skipped when the mesh is hidden:
+			Ref<Visibility> _visibility;
+#endif
+
 			void upload_buffers() {
 				DREAM_ASSERT(_mesh);
 
@@ -42,14 +49,14 @@ namespace Dream
 					auto binding = _index_buffer.binding();
 					binding.set_data(_mesh->indices);
 
-					check_graphics_error();
+					DREAM_CHECK_GRAPHICS_ERROR();
 				}
 
 				{
 					auto binding = _vertex_buffer.binding();
 					binding.set_data(_mesh->vertices);
 
-					check_graphics_error();
+					DREAM_CHECK_GRAPHICS_ERROR();
 				}
 
 				// Keep track of the number of indices uploaded for drawing:
@@ -58,11 +65,20 @@ namespace Dream
 				// The mesh buffer is now okay for drawing:
 				_invalid = false;
 
-				check_graphics_error();
+				DREAM_CHECK_GRAPHICS_ERROR();
 			}
 
 			void draw_elements(std::size_t count) {
 				if (!_invalid) {
+#ifndef DREAM_OPENGLES2
+					if (_visibility && _visibility->occluded())
+						return;
+
+					DREAM_GPU_SCOPE("MeshBuffer::draw");
+
+					Visibility::ConditionalRender conditional_render(_visibility.get());
+#endif
+
 					auto binding = _vertex_array.binding();
 					binding.draw_elements(_mesh->layout, (GLsizei)count, GLTypeTraits<typename MeshT::IndexT>::TYPE);
 				}
@@ -92,6 +108,16 @@ namespace Dream
 				return _mesh;
 			}
 
+#ifndef DREAM_OPENGLES2
+			void set_visibility(Ptr<Visibility> visibility) {
+				_visibility = visibility;
+			}
+
+			Ptr<Visibility> visibility() {
+				return _visibility;
+			}
+#endif
+
 			void invalidate() {
 				_invalid = true;
 			}
@@ -0,0 +1,357 @@
+//
+//  Graphics/OcclusionBuffer.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <thread>
+
+#if defined(__SSE__) || defined(_M_X64)
+	#include <xmmintrin.h>
+	#define DREAM_OCCLUSION_SSE
+#endif
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		OcclusionBuffer::OcclusionBuffer(const Vec2u & size)
+		{
+			std::size_t width = (size[0] + 3) & ~(std::size_t)3, height = std::max<std::size_t>(size[1], 1);
+
+			while (true) {
+				_levels.push_back(Level{width, height, std::vector<float>(width * height, 1.0f)});
+
+				if (width == 1 && height == 1)
+					break;
+
+				width = (width + 1) / 2;
+				height = (height + 1) / 2;
+			}
+
+			for (std::size_t i = 0; i < 16; i += 1)
+				_view_projection.data()[i] = (i % 5 == 0) ? 1 : 0;
+		}
+
+		OcclusionBuffer::~OcclusionBuffer()
+		{
+		}
+
+		void OcclusionBuffer::begin(const Mat44 & view_projection)
+		{
+			_view_projection = view_projection;
+			_triangles.clear();
+
+			std::fill(_levels[0].depth.begin(), _levels[0].depth.end(), 1.0f);
+
+			_statistics = Statistics();
+		}
+
+		void OcclusionBuffer::transform(ClipVertex & result, const Vec3 & position, const Mat44 & matrix)
+		{
+			const float * m = matrix.data();
+			float x = position[0], y = position[1], z = position[2];
+
+			result.x = m[0] * x + m[4] * y + m[8] * z + m[12];
+			result.y = m[1] * x + m[5] * y + m[9] * z + m[13];
+			result.z = m[2] * x + m[6] * y + m[10] * z + m[14];
+			result.w = m[3] * x + m[7] * y + m[11] * z + m[15];
+		}
+
+		void OcclusionBuffer::add_triangle(const ClipVertex & a, const ClipVertex & b, const ClipVertex & c)
+		{
+			const ClipVertex * input[3] = {&a, &b, &c};
+
+			// Reject triangles which are entirely outside one of the side or far planes:
+			if ((a.x > a.w && b.x > b.w && c.x > c.w) || (a.x < -a.w && b.x < -b.w && c.x < -c.w))
+				return;
+			if ((a.y > a.w && b.y > b.w && c.y > c.w) || (a.y < -a.w && b.y < -b.w && c.y < -c.w))
+				return;
+			if (a.z > a.w && b.z > b.w && c.z > c.w)
+				return;
+
+			// Clip against the near plane, z >= -w, which produces at most four vertices:
+			ClipVertex polygon[4];
+			std::size_t count = 0;
+
+			for (std::size_t i = 0; i < 3; i += 1) {
+				const ClipVertex & current = *input[i], & next = *input[(i + 1) % 3];
+
+				float current_distance = current.z + current.w, next_distance = next.z + next.w;
+
+				if (current_distance >= 0)
+					polygon[count++] = current;
+
+				if ((current_distance >= 0) != (next_distance >= 0)) {
+					float t = current_distance / (current_distance - next_distance);
+
+					polygon[count++] = ClipVertex{
+						current.x + (next.x - current.x) * t,
+						current.y + (next.y - current.y) * t,
+						current.z + (next.z - current.z) * t,
+						current.w + (next.w - current.w) * t,
+					};
+				}
+			}
+
+			for (std::size_t i = 2; i < count; i += 1)
+				add_screen_triangle(polygon[0], polygon[i-1], polygon[i]);
+		}
+
+		void OcclusionBuffer::add_screen_triangle(const ClipVertex & a, const ClipVertex & b, const ClipVertex & c)
+		{
+			const ClipVertex * vertices[3] = {&a, &b, &c};
+			Triangle triangle;
+
+			float width = (float)this->width(), height = (float)this->height();
+
+			for (std::size_t i = 0; i < 3; i += 1) {
+				const ClipVertex & vertex = *vertices[i];
+
+				// Vertices on the near plane may have w of zero in degenerate projections:
+				if (vertex.w <= 0)
+					return;
+
+				float inverse_w = 1.0f / vertex.w;
+
+				triangle.x[i] = (vertex.x * inverse_w * 0.5f + 0.5f) * width;
+				triangle.y[i] = (vertex.y * inverse_w * 0.5f + 0.5f) * height;
+				triangle.z[i] = vertex.z * inverse_w * 0.5f + 0.5f;
+			}
+
+			float area = (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]);
+
+			if (std::abs(area) < 1e-6f)
+				return;
+
+			// Occluders are rasterised regardless of facing, so make the winding consistent:
+			if (area < 0) {
+				std::swap(triangle.x[1], triangle.x[2]);
+				std::swap(triangle.y[1], triangle.y[2]);
+				std::swap(triangle.z[1], triangle.z[2]);
+			}
+
+			_triangles.push_back(triangle);
+		}
+
+		void OcclusionBuffer::rasterize_rows(std::size_t begin, std::size_t end)
+		{
+			Level & level = _levels[0];
+			const std::size_t width = level.width;
+
+			for (const Triangle & triangle : _triangles) {
+				const float * x = triangle.x, * y = triangle.y, * z = triangle.z;
+
+				float min_y = std::min(y[0], std::min(y[1], y[2])), max_y = std::max(y[0], std::max(y[1], y[2]));
+
+				if (max_y < (float)begin || min_y >= (float)end)
+					continue;
+
+				float min_x = std::min(x[0], std::min(x[1], x[2])), max_x = std::max(x[0], std::max(x[1], x[2]));
+
+				if (max_x < 0 || min_x >= (float)width)
+					continue;
+
+				std::size_t row_begin = std::max<std::ptrdiff_t>((std::ptrdiff_t)std::floor(min_y), (std::ptrdiff_t)begin);
+				std::size_t row_end = std::min<std::ptrdiff_t>((std::ptrdiff_t)std::ceil(max_y) + 1, (std::ptrdiff_t)end);
+
+				// Start at a multiple of 4 so that four pixels are always processed together:
+				std::size_t column_begin = std::max<std::ptrdiff_t>((std::ptrdiff_t)std::floor(min_x), 0) & ~(std::size_t)3;
+				std::size_t column_end = std::min<std::ptrdiff_t>((std::ptrdiff_t)std::ceil(max_x) + 1, (std::ptrdiff_t)width);
+
+				// Edge functions E(i, j) are positive inside the triangle. The edge opposite a vertex, divided by the area, is its barycentric weight:
+				float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+				float inverse_area = 1.0f / area;
+
+				float edge_dx[3], edge_dy[3], edge_origin[3];
+				for (std::size_t i = 0; i < 3; i += 1) {
+					std::size_t j = (i + 1) % 3;
+
+					edge_dx[i] = -(y[j] - y[i]);
+					edge_dy[i] = x[j] - x[i];
+					edge_origin[i] = -edge_dx[i] * x[i] - edge_dy[i] * y[i];
+				}
+
+				// Depth is linear in screen space: z0 + (z1 - z0) * E(2, 0) / area + (z2 - z0) * E(0, 1) / area.
+				float depth_dx = ((z[1] - z[0]) * edge_dx[2] + (z[2] - z[0]) * edge_dx[0]) * inverse_area;
+				float depth_dy = ((z[1] - z[0]) * edge_dy[2] + (z[2] - z[0]) * edge_dy[0]) * inverse_area;
+				float depth_origin = z[0] + ((z[1] - z[0]) * edge_origin[2] + (z[2] - z[0]) * edge_origin[0]) * inverse_area;
+
+				for (std::size_t row = row_begin; row < row_end; row += 1) {
+					float * output = level.depth.data() + row * width;
+					float py = (float)row + 0.5f;
+
+#ifdef DREAM_OCCLUSION_SSE
+					__m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+					__m128 e[3], e_step[3];
+
+					for (std::size_t i = 0; i < 3; i += 1) {
+						__m128 px = _mm_add_ps(_mm_set1_ps((float)column_begin), offsets);
+
+						e[i] = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(edge_dx[i])), _mm_set1_ps(edge_dy[i] * py + edge_origin[i]));
+						e_step[i] = _mm_set1_ps(edge_dx[i] * 4);
+					}
+
+					__m128 depth = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_set1_ps((float)column_begin), offsets), _mm_set1_ps(depth_dx)), _mm_set1_ps(depth_dy * py + depth_origin));
+					__m128 depth_step = _mm_set1_ps(depth_dx * 4);
+					__m128 zero = _mm_setzero_ps();
+
+					for (std::size_t column = column_begin; column < column_end; column += 4) {
+						__m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e[0], zero), _mm_cmpge_ps(e[1], zero)), _mm_cmpge_ps(e[2], zero));
+
+						if (_mm_movemask_ps(inside)) {
+							__m128 current = _mm_loadu_ps(output + column);
+							__m128 nearest = _mm_min_ps(current, depth);
+
+							_mm_storeu_ps(output + column, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+						}
+
+						for (std::size_t i = 0; i < 3; i += 1)
+							e[i] = _mm_add_ps(e[i], e_step[i]);
+
+						depth = _mm_add_ps(depth, depth_step);
+					}
+#else
+					for (std::size_t column = column_begin; column < column_end; column += 1) {
+						float px = (float)column + 0.5f;
+
+						bool inside = true;
+						for (std::size_t i = 0; i < 3; i += 1) {
+							if (edge_dx[i] * px + edge_dy[i] * py + edge_origin[i] < 0)
+								inside = false;
+						}
+
+						if (inside) {
+							float depth = depth_dx * px + depth_dy * py + depth_origin;
+
+							if (depth < output[column])
+								output[column] = depth;
+						}
+					}
+#endif
+				}
+			}
+		}
+
+		void OcclusionBuffer::build_hierarchy()
+		{
+			// Each texel stores the farthest depth of the four texels below it, so a box behind it is behind everything it covers:
+			for (std::size_t index = 1; index < _levels.size(); index += 1) {
+				const Level & source = _levels[index - 1];
+				Level & level = _levels[index];
+
+				for (std::size_t y = 0; y < level.height; y += 1) {
+					std::size_t y0 = y * 2, y1 = std::min(y0 + 1, source.height - 1);
+
+					for (std::size_t x = 0; x < level.width; x += 1) {
+						std::size_t x0 = x * 2, x1 = std::min(x0 + 1, source.width - 1);
+
+						level.depth[y * level.width + x] = std::max(
+							std::max(source.depth[y0 * source.width + x0], source.depth[y0 * source.width + x1]),
+							std::max(source.depth[y1 * source.width + x0], source.depth[y1 * source.width + x1])
+						);
+					}
+				}
+			}
+		}
+
+		void OcclusionBuffer::rasterize(std::size_t thread_count)
+		{
+			std::size_t height = this->height();
+
+			if (thread_count == 0)
+				thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+			thread_count = std::min(thread_count, height);
+
+			_statistics.triangles = _triangles.size();
+
+			// Each worker writes a separate band of rows, so no synchronisation is required:
+			std::vector<std::exception_ptr> errors(thread_count);
+
+			auto rasterize_band = [&](std::size_t worker) {
+				try {
+					rasterize_rows(height * worker / thread_count, height * (worker + 1) / thread_count);
+				} catch (...) {
+					errors[worker] = std::current_exception();
+				}
+			};
+
+			std::vector<std::thread> workers;
+
+			for (std::size_t worker = 1; worker < thread_count; worker += 1)
+				workers.push_back(std::thread(rasterize_band, worker));
+
+			rasterize_band(0);
+
+			for (auto & worker : workers)
+				worker.join();
+
+			for (auto & error : errors) {
+				if (error)
+					std::rethrow_exception(error);
+			}
+
+			build_hierarchy();
+		}
+
+		bool OcclusionBuffer::is_visible(const AlignedBox<3> & box) const
+		{
+			_statistics.tested += 1;
+
+			float min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY, nearest = INFINITY;
+
+			for (std::size_t corner = 0; corner < 8; corner += 1) {
+				Vec3 position(
+					(corner & 1) ? box.max()[0] : box.min()[0],
+					(corner & 2) ? box.max()[1] : box.min()[1],
+					(corner & 4) ? box.max()[2] : box.min()[2]
+				);
+
+				ClipVertex vertex;
+				transform(vertex, position, _view_projection);
+
+				// The box crosses the near plane, so it can't be hidden:
+				if (vertex.w <= 0 || vertex.z < -vertex.w)
+					return true;
+
+				float inverse_w = 1.0f / vertex.w;
+
+				float x = (vertex.x * inverse_w * 0.5f + 0.5f) * width();
+				float y = (vertex.y * inverse_w * 0.5f + 0.5f) * height();
+
+				min_x = std::min(min_x, x); max_x = std::max(max_x, x);
+				min_y = std::min(min_y, y); max_y = std::max(max_y, y);
+				nearest = std::min(nearest, vertex.z * inverse_w * 0.5f + 0.5f);
+			}
+
+			// Only what is covered by the buffer can be hidden:
+			if (min_x < 0 || min_y < 0 || max_x >= (float)width() || max_y >= (float)height())
+				return true;
+
+			std::size_t x0 = (std::size_t)min_x, x1 = (std::size_t)max_x, y0 = (std::size_t)min_y, y1 = (std::size_t)max_y;
+
+			// Choose the level where the box covers at most a few texels in each direction:
+			std::size_t level = 0;
+			while (level + 1 < _levels.size() && (x1 - x0 > 2 || y1 - y0 > 2)) {
+				x0 /= 2; x1 /= 2; y0 /= 2; y1 /= 2;
+				level += 1;
+			}
+
+			for (std::size_t y = y0; y <= y1; y += 1) {
+				for (std::size_t x = x0; x <= x1; x += 1) {
+					if (nearest <= depth(x, y, level))
+						return true;
+				}
+			}
+
+			_statistics.occluded += 1;
+
+			return false;
+		}
+	}
+}
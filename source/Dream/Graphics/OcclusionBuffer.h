@@ -0,0 +1,130 @@
+//
+//  Graphics/OcclusionBuffer.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_OCCLUSIONBUFFER_H
+#define _DREAM_CLIENT_GRAPHICS_OCCLUSIONBUFFER_H
+
+#include "MeshBuffer.h"
+#include "TransformHierarchy.h"
+
+#include <Euclid/Geometry/AlignedBox.h>
+#include <Euclid/Numerics/Matrix.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		using Euclid::Geometry::AlignedBox;
+		using Euclid::Numerics::Vec2u;
+		using Euclid::Numerics::Vec3;
+		using Euclid::Numerics::Mat44;
+
+		/**
+		 A low resolution depth buffer, rasterised on the CPU from a small number of large occluders, which is used to skip drawing objects that are hidden behind them. It doesn't use the GPU at all.
+
+		 Each frame:
+
+		 	occlusion_buffer->begin(view_projection);
+		 	occlusion_buffer->add_occluder(*building_mesh, building_model_matrix);
+		 	occlusion_buffer->rasterize();
+
+		 	if (occlusion_buffer->is_visible(bounds))
+		 		// Draw or queue the object...
+
+		 Occluders are triangle lists. They are rasterised in horizontal bands on worker threads, and then a hierarchy is built where each texel stores the farthest depth of the texels it covers. A box is hidden if its nearest depth is behind the farthest occluder depth everywhere it covers on screen. Testing is conservative, so boxes which cross the near plane or leave the screen are always visible.
+		 */
+		class OcclusionBuffer : public Object {
+		public:
+			struct ClipVertex {
+				float x, y, z, w;
+			};
+
+			struct Statistics {
+				std::size_t triangles = 0;
+				std::size_t tested = 0;
+				std::size_t occluded = 0;
+			};
+
+		protected:
+			struct Triangle {
+				float x[3], y[3], z[3];
+			};
+
+			struct Level {
+				std::size_t width, height;
+				std::vector<float> depth;
+			};
+
+			// Level 0 is the rasterised depth buffer, and each subsequent level is half the size:
+			std::vector<Level> _levels;
+
+			Mat44 _view_projection;
+
+			std::vector<Triangle> _triangles;
+			std::vector<ClipVertex> _transformed;
+
+			mutable Statistics _statistics;
+
+			// Clip the triangle to the near plane and convert it to screen space:
+			void add_screen_triangle(const ClipVertex & a, const ClipVertex & b, const ClipVertex & c);
+
+			void rasterize_rows(std::size_t begin, std::size_t end);
+			void build_hierarchy();
+
+		public:
+			/// The width is rounded up to a multiple of 4.
+			OcclusionBuffer(const Vec2u & size = Vec2u(256, 128));
+			virtual ~OcclusionBuffer();
+
+			std::size_t width() const { return _levels[0].width; }
+			std::size_t height() const { return _levels[0].height; }
+
+			/// Clear the depth buffer and remove all occluders.
+			void begin(const Mat44 & view_projection);
+
+			static void transform(ClipVertex & result, const Vec3 & position, const Mat44 & matrix);
+
+			/// Add a triangle given in clip space.
+			void add_triangle(const ClipVertex & a, const ClipVertex & b, const ClipVertex & c);
+
+			/// Add the triangles of a mesh, which must use a triangle list layout, transformed by the given model matrix.
+			template <typename MeshT>
+			void add_occluder(const MeshT & mesh, const Mat44 & model);
+
+			template <typename MeshT>
+			void add_occluder(MeshBuffer<MeshT> & mesh_buffer, const Mat44 & model) {
+				add_occluder(*mesh_buffer.mesh(), model);
+			}
+
+			/// Rasterise all occluders and build the depth hierarchy. If thread_count is zero, the hardware concurrency is used.
+			void rasterize(std::size_t thread_count = 0);
+
+			/// Whether any part of the box, given in world space, may be visible.
+			bool is_visible(const AlignedBox<3> & box) const;
+
+			/// The depth of the given texel, from 0 at the near plane to 1 at the far plane.
+			float depth(std::size_t x, std::size_t y, std::size_t level = 0) const { return _levels[level].depth[y * _levels[level].width + x]; }
+
+			std::size_t level_count() const { return _levels.size(); }
+
+			const Statistics & statistics() const { return _statistics; }
+		};
+
+		template <typename MeshT>
+		void OcclusionBuffer::add_occluder(const MeshT & mesh, const Mat44 & model) {
+			Mat44 model_view_projection;
+			TransformHierarchy::multiply(model_view_projection, _view_projection, model);
+
+			_transformed.resize(mesh.vertices.size());
+			for (std::size_t i = 0; i < mesh.vertices.size(); i += 1)
+				transform(_transformed[i], mesh.vertices[i].position, model_view_projection);
+
+			for (std::size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+				add_triangle(_transformed[mesh.indices[i]], _transformed[mesh.indices[i+1]], _transformed[mesh.indices[i+2]]);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,263 @@
+//
+//  Graphics/OcclusionQuery.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "OcclusionQuery.h"
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		Visibility::Visibility(Ptr<QueryPool> query_pool, const AlignedBox<3> & box, Mode mode) : _query_pool(query_pool), _box(box), _mode(mode)
+		{
+		}
+
+		Visibility::~Visibility()
+		{
+			// The results are no longer required, and a query can be reused before its result is read:
+			for (auto query : _pending)
+				_query_pool->release(query);
+		}
+
+		void Visibility::begin_query()
+		{
+			_current = _query_pool->allocate();
+			_pending.push_back(_current);
+
+			glBeginQuery(_query_pool->target(), _current);
+		}
+
+		void Visibility::end_query()
+		{
+			glEndQuery(_query_pool->target());
+		}
+
+		void Visibility::skip_query()
+		{
+			_current = 0;
+			_visible = true;
+
+			// Older results would overwrite this:
+			for (auto query : _pending)
+				_query_pool->release(query);
+
+			_pending.clear();
+		}
+
+		std::size_t Visibility::collect()
+		{
+			// Queries complete in order, so stop at the first one which isn't available:
+			while (!_pending.empty() && QueryPool::available(_pending.front())) {
+				GLuint query = _pending.front();
+				_pending.pop_front();
+
+				GLuint samples = 0;
+				glGetQueryObjectuiv(query, GL_QUERY_RESULT, &samples);
+
+				_visible = samples != 0;
+
+				_query_pool->release(query);
+			}
+
+			// A query from a previous frame must not be used for conditional rendering:
+			_current = 0;
+
+			return _pending.size();
+		}
+
+		Visibility::ConditionalRender::ConditionalRender(Visibility * visibility)
+		{
+#ifdef GL_QUERY_NO_WAIT
+			if (visibility && visibility->_mode == CONDITIONAL && visibility->_current) {
+				glBeginConditionalRender(visibility->_current, GL_QUERY_NO_WAIT);
+				_active = true;
+			}
+#endif
+		}
+
+		Visibility::ConditionalRender::~ConditionalRender()
+		{
+#ifdef GL_QUERY_NO_WAIT
+			if (_active)
+				glEndConditionalRender();
+#endif
+		}
+
+// MARK: -
+
+		OcclusionQueries::OcclusionQueries() : _query_pool(new QueryPool(query_target()))
+		{
+			std::vector<Vertex> vertices;
+
+			// The unit cube, which is scaled and translated to each box:
+			for (std::size_t corner = 0; corner < 8; corner += 1)
+				vertices.push_back({Vec3(corner & 1 ? 1 : 0, corner & 2 ? 1 : 0, corner & 4 ? 1 : 0)});
+
+			const GLubyte indices[] = {
+				0, 2, 1, 1, 2, 3, // -z
+				4, 5, 6, 5, 7, 6, // +z
+				0, 1, 4, 1, 5, 4, // -y
+				2, 6, 3, 3, 6, 7, // +y
+				0, 4, 2, 2, 4, 6, // -x
+				1, 3, 5, 3, 7, 5, // +x
+			};
+
+			{
+				auto buffer_binding = _vertex_buffer.binding();
+				buffer_binding.set_data(vertices);
+			}
+
+			// Unbinding the index buffer while the vertex array is bound would detach it, so it is uploaded first:
+			{
+				auto buffer_binding = _index_buffer.binding();
+				buffer_binding.set_data(indices, sizeof(indices));
+			}
+
+			auto binding = _vertex_array.binding();
+
+			{
+				auto attributes = binding.attach(_vertex_buffer);
+				attributes[0] = &Vertex::position;
+			}
+
+			binding.attach(_index_buffer);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		OcclusionQueries::~OcclusionQueries()
+		{
+		}
+
+		static bool context_version_at_least(GLint major, GLint minor)
+		{
+			GLint context_major = 0, context_minor = 0;
+
+			glGetIntegerv(GL_MAJOR_VERSION, &context_major);
+			glGetIntegerv(GL_MINOR_VERSION, &context_minor);
+
+			return context_major > major || (context_major == major && context_minor >= minor);
+		}
+
+		GLenum OcclusionQueries::query_target()
+		{
+			// The headers only tell us which targets can be named, the context decides which ones can be used:
+#ifdef GL_ANY_SAMPLES_PASSED_CONSERVATIVE
+			if (context_version_at_least(4, 3) || has_graphics_extension("GL_ARB_ES3_compatibility"))
+				return GL_ANY_SAMPLES_PASSED_CONSERVATIVE;
+#endif
+
+#ifdef GL_ANY_SAMPLES_PASSED
+			if (context_version_at_least(3, 3) || has_graphics_extension("GL_ARB_occlusion_query2"))
+				return GL_ANY_SAMPLES_PASSED;
+#endif
+
+			return GL_SAMPLES_PASSED;
+		}
+
+		Ref<Visibility> OcclusionQueries::add(const AlignedBox<3> & box, Visibility::Mode mode)
+		{
+			Ref<Visibility> visibility = new Visibility(_query_pool, box, mode);
+
+			_visibilities.push_back(visibility);
+
+			return visibility;
+		}
+
+		void OcclusionQueries::remove(Ptr<Visibility> visibility)
+		{
+			_visibilities.erase(std::remove(_visibilities.begin(), _visibilities.end(), visibility), _visibilities.end());
+		}
+
+		void OcclusionQueries::update()
+		{
+			_statistics.pending = 0;
+			_statistics.occluded = 0;
+
+			for (auto & visibility : _visibilities) {
+				_statistics.pending += visibility->collect();
+
+				if (!visibility->visible())
+					_statistics.occluded += 1;
+			}
+		}
+
+		void OcclusionQueries::draw_proxies(Ptr<Program> program, const Mat44 & view_projection, const char * transform_name)
+		{
+			_statistics.issued = 0;
+			_statistics.skipped = 0;
+
+			GLboolean color_mask[4], depth_mask;
+			glGetBooleanv(GL_COLOR_WRITEMASK, color_mask);
+			glGetBooleanv(GL_DEPTH_WRITEMASK, &depth_mask);
+
+			glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+			glDepthMask(GL_FALSE);
+
+			{
+				auto program_binding = program->binding();
+				auto binding = _vertex_array.binding();
+
+				for (auto & visibility : _visibilities) {
+					const AlignedBox<3> & box = visibility->box();
+
+					// Scale and translate the unit cube to the box:
+					Mat44 model, transform;
+					float * m = model.data();
+
+					for (std::size_t i = 0; i < 16; i += 1)
+						m[i] = 0;
+
+					for (std::size_t i = 0; i < 3; i += 1) {
+						m[i * 5] = box.max()[i] - box.min()[i];
+						m[12 + i] = box.min()[i];
+					}
+
+					m[15] = 1;
+
+					TransformHierarchy::multiply(transform, view_projection, model);
+
+					// If the box crosses the near plane, its faces may be clipped even though the object is visible:
+					bool crosses_near_plane = false;
+					const float * t = transform.data();
+
+					for (std::size_t corner = 0; corner < 8 && !crosses_near_plane; corner += 1) {
+						float x = corner & 1 ? 1 : 0, y = corner & 2 ? 1 : 0, z = corner & 4 ? 1 : 0;
+
+						float clip_z = t[2] * x + t[6] * y + t[10] * z + t[14];
+						float clip_w = t[3] * x + t[7] * y + t[11] * z + t[15];
+
+						if (clip_z < -clip_w)
+							crosses_near_plane = true;
+					}
+
+					if (crosses_near_plane) {
+						visibility->skip_query();
+						_statistics.skipped += 1;
+
+						continue;
+					}
+
+					program_binding.set_uniform(transform_name, transform);
+
+					visibility->begin_query();
+					binding.draw_elements(GL_TRIANGLES, 36, GL_UNSIGNED_BYTE);
+					visibility->end_query();
+
+					_statistics.issued += 1;
+				}
+			}
+
+			glColorMask(color_mask[0], color_mask[1], color_mask[2], color_mask[3]);
+			glDepthMask(depth_mask);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+#endif
+	}
+}
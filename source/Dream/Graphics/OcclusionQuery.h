@@ -0,0 +1,143 @@
+//
+//  Graphics/OcclusionQuery.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_OCCLUSIONQUERY_H
+#define _DREAM_CLIENT_GRAPHICS_OCCLUSIONQUERY_H
+
+#include "QueryPool.h"
+#include "VertexArray.h"
+#include "ShaderManager.h"
+
+#include <Euclid/Geometry/AlignedBox.h>
+#include <Euclid/Numerics/Matrix.h>
+
+#include <deque>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		using Euclid::Geometry::AlignedBox;
+		using Euclid::Numerics::Vec3;
+		using Euclid::Numerics::Mat44;
+
+		/**
+		 The GPU visibility of an object, determined by drawing its bounding box in an occlusion query. Attach it to a MeshBuffer with `set_visibility`, and the mesh buffer will skip drawing when the object is hidden.
+
+		 Results are collected only once they are available, so the CPU never waits for the GPU. As a consequence, in LATENT mode, visibility is at least one frame behind, and objects which come into view may appear a frame late. In CONDITIONAL mode the draw is wrapped in a conditional render using this frame's query instead, and the GPU discards it if the query found no samples. The GPU doesn't wait for the result either, so it may draw anyway.
+		 */
+		class Visibility : public Object {
+		public:
+			enum Mode {
+				LATENT,
+				CONDITIONAL,
+			};
+
+		protected:
+			Ref<QueryPool> _query_pool;
+
+			AlignedBox<3> _box;
+			Mode _mode;
+
+			// Queries which have been issued but whose results haven't been read yet, oldest first:
+			std::deque<GLuint> _pending;
+
+			// The query issued this frame, used for conditional rendering, or 0 if there isn't one:
+			GLuint _current = 0;
+
+			bool _visible = true;
+
+			friend class OcclusionQueries;
+
+			void begin_query();
+			void end_query();
+
+			// The box could not be queried this frame, e.g. it crosses the near plane, so assume it is visible:
+			void skip_query();
+
+			// Read any results which are available, returning the number of queries still pending:
+			std::size_t collect();
+
+		public:
+			Visibility(Ptr<QueryPool> query_pool, const AlignedBox<3> & box, Mode mode = LATENT);
+			virtual ~Visibility();
+
+			const AlignedBox<3> & box() const { return _box; }
+			void set_box(const AlignedBox<3> & box) { _box = box; }
+
+			Mode mode() const { return _mode; }
+
+			/// The most recent result. Objects are visible until a result says otherwise.
+			bool visible() const { return _visible; }
+
+			/// Whether drawing can be skipped entirely on the CPU.
+			bool occluded() const { return _mode == LATENT && !_visible; }
+
+			/// Begins a conditional render around a draw, if this visibility uses conditional rendering and was queried this frame.
+			class ConditionalRender : private NonCopyable {
+			protected:
+				bool _active = false;
+
+			public:
+				ConditionalRender(Visibility * visibility);
+				~ConditionalRender();
+			};
+		};
+
+		/**
+		 Manages the visibility of many objects using occlusion queries. Each frame, after drawing the main occluders (e.g. the opaque scene), draw the bounding boxes of all objects, which updates their visibility:
+
+		 	occlusion_queries->update();
+		 	occlusion_queries->draw_proxies(proxy_program, view_projection);
+
+		 The proxy program transforms the `position` attribute at location 0 by the `transform` uniform. Colour and depth writes are disabled while proxies are drawn.
+		 */
+		class OcclusionQueries : public Object {
+		public:
+			struct Statistics {
+				std::size_t issued = 0;
+				std::size_t skipped = 0;
+				std::size_t pending = 0;
+				std::size_t occluded = 0;
+			};
+
+		protected:
+			Ref<QueryPool> _query_pool;
+			std::vector<Ref<Visibility>> _visibilities;
+
+			struct Vertex {
+				Vec3 position;
+			};
+
+			VertexArray _vertex_array;
+			VertexBuffer<Vertex> _vertex_buffer;
+			IndexBuffer<GLubyte> _index_buffer;
+
+			Statistics _statistics;
+
+		public:
+			OcclusionQueries();
+			virtual ~OcclusionQueries();
+
+			/// The best query target the current context supports: GL_ANY_SAMPLES_PASSED_CONSERVATIVE, then GL_ANY_SAMPLES_PASSED, then GL_SAMPLES_PASSED.
+			static GLenum query_target();
+
+			Ref<Visibility> add(const AlignedBox<3> & box, Visibility::Mode mode = Visibility::LATENT);
+			void remove(Ptr<Visibility> visibility);
+
+			/// Collect the results of previous queries which are available, without blocking.
+			void update();
+
+			/// Draw the bounding box of every object within an occlusion query.
+			void draw_proxies(Ptr<Program> program, const Mat44 & view_projection, const char * transform_name = "transform");
+
+			const Statistics & statistics() const { return _statistics; }
+		};
+#endif
+	}
+}
+
+#endif
@@ -13,6 +13,7 @@
 #include "Graphics.h"
 #include "MeshBuffer.h"
 #include "ShaderManager.h"
+#include "Trace.h"
 #include <Dream/Core/Timer.h>
 #include <Dream/Core/Algorithm.h>
 
@@ -240,6 +241,8 @@ namespace Dream
 			// bool update_particle(Particle & particle, TimeT last_time, TimeT current_time, TimeT dt)
 			void update_for_duration (TimeT last_time, TimeT current_time, TimeT dt)
 			{
+				DREAM_TRACE_ZONE("ParticleRenderer::update_for_duration");
+
 				if (_particles.size() == 0)
 					return;
 
@@ -282,6 +285,8 @@ namespace Dream
 				if (_count == 0)
 					return;
 
+				DREAM_GPU_SCOPE("ParticleRenderer::draw");
+
 				// Setup indices for drawing quadrilaterals as triangles:
 				std::size_t additions = setup_triangle_indicies(_count, _indices);
 
@@ -0,0 +1,158 @@
+//
+//  Graphics/ProgramBinaryCache.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ProgramBinaryCache.h"
+
+#include <cstdio>
+#include <fstream>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		// Identifies the file format, in case it needs to change in the future:
+		static const std::uint32_t PROGRAM_BINARY_MAGIC = 0x44504231;
+
+		static StringT graphics_string(GLenum name)
+		{
+			const GLubyte * value = glGetString(name);
+
+			return value ? StringT((const char *)value) : StringT();
+		}
+
+		ProgramBinaryCache::ProgramBinaryCache(const StringT & directory) : _directory(directory)
+		{
+			GLint format_count = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+			_supported = format_count > 0;
+
+			_driver_hash = driver_hash(graphics_string(GL_VENDOR), graphics_string(GL_RENDERER), graphics_string(GL_VERSION), graphics_string(GL_SHADING_LANGUAGE_VERSION));
+
+			if (!_supported)
+				logger()->log(LOG_INFO, LogBuffer() << "Program binaries are not supported by this driver, the program cache is disabled.");
+		}
+
+		ProgramBinaryCache::~ProgramBinaryCache()
+		{
+			logger()->log(LOG_DEBUG, LogBuffer() << "Program cache: " << _statistics.hits << " hits, " << _statistics.misses << " misses, " << _statistics.rejected << " rejected, " << _statistics.stores << " stored.");
+		}
+
+		HashT ProgramBinaryCache::driver_hash(const StringT & vendor, const StringT & renderer, const StringT & version, const StringT & shading_language_version)
+		{
+			Hash hash;
+
+			// Each string is prefixed by its length, so that e.g. ("ab", "c") and ("a", "bc") are distinct:
+			for (auto string : {&vendor, &renderer, &version, &shading_language_version}) {
+				hash.append((HashT)string->size());
+				hash.append(*string);
+			}
+
+			return hash.value();
+		}
+
+		HashT ProgramBinaryCache::key(HashT driver_hash, HashT source_hash)
+		{
+			Hash hash;
+			hash.append(driver_hash);
+			hash.append(source_hash);
+
+			return hash.value();
+		}
+
+		StringT ProgramBinaryCache::path_for_key(HashT key) const
+		{
+			StringStreamT buffer;
+			buffer << _directory << "/" << std::hex;
+			buffer.width(16);
+			buffer.fill('0');
+			buffer << key << ".program";
+
+			return buffer.str();
+		}
+
+		bool ProgramBinaryCache::load(Ptr<Program> program, HashT source_hash)
+		{
+			if (!_supported) {
+				_statistics.misses += 1;
+
+				return false;
+			}
+
+			std::ifstream input(path_for_key(key(source_hash)), std::ios::binary);
+
+			std::uint32_t magic = 0, format = 0, size = 0;
+			input.read((char *)&magic, sizeof(magic));
+			input.read((char *)&format, sizeof(format));
+			input.read((char *)&size, sizeof(size));
+
+			if (!input.good() || magic != PROGRAM_BINARY_MAGIC || size == 0) {
+				_statistics.misses += 1;
+
+				return false;
+			}
+
+			Shared<MutableBuffer> buffer = PackedBuffer::new_buffer(size);
+			input.read((char *)buffer->begin(), size);
+
+			if (!input.good()) {
+				_statistics.misses += 1;
+
+				return false;
+			}
+
+			if (!program->load_binary(format, *buffer)) {
+				logger()->log(LOG_DEBUG, LogBuffer() << "Program binary was rejected by the driver, recompiling.");
+
+				_statistics.rejected += 1;
+				_statistics.misses += 1;
+
+				return false;
+			}
+
+			_statistics.hits += 1;
+
+			return true;
+		}
+
+		bool ProgramBinaryCache::store(Ptr<Program> program, HashT source_hash)
+		{
+			if (!_supported)
+				return false;
+
+			GLenum format = 0;
+			Shared<Buffer> buffer = program->binary(format);
+
+			if (!buffer)
+				return false;
+
+			StringT path = path_for_key(key(source_hash));
+
+			// Readers only ever see a complete file, even if the process dies while writing:
+			StringT temporary_path = path + ".tmp";
+			std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+
+			std::uint32_t magic = PROGRAM_BINARY_MAGIC, binary_format = format, size = (std::uint32_t)buffer->size();
+			output.write((const char *)&magic, sizeof(magic));
+			output.write((const char *)&binary_format, sizeof(binary_format));
+			output.write((const char *)&size, sizeof(size));
+			output.write((const char *)buffer->begin(), size);
+			output.close();
+
+			if (!output.good() || std::rename(temporary_path.c_str(), path.c_str()) != 0) {
+				logger()->log(LOG_WARN, LogBuffer() << "Could not write program binary to " << path);
+
+				std::remove(temporary_path.c_str());
+
+				return false;
+			}
+
+			_statistics.stores += 1;
+
+			return true;
+		}
+#endif
+	}
+}
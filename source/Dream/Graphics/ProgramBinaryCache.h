@@ -0,0 +1,72 @@
+//
+//  Graphics/ProgramBinaryCache.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_PROGRAMBINARYCACHE_H
+#define _DREAM_CLIENT_GRAPHICS_PROGRAMBINARYCACHE_H
+
+#include "ShaderManager.h"
+#include "Hash.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		/**
+		 Stores linked program binaries on disk so that later runs can skip compiling and linking.
+
+		 Entries are keyed by a hash of the full preprocessed source (which includes the defines) combined with the driver vendor, renderer and version strings, so a driver update simply results in cache misses. If the driver rejects a binary anyway, the program should be compiled as usual and stored again.
+
+		 Binaries are written to a temporary file which is renamed into place, so an interrupted write never leaves a truncated entry.
+		 */
+		class ProgramBinaryCache : public Object {
+		public:
+			struct Statistics {
+				std::size_t hits = 0;
+				std::size_t misses = 0;
+
+				// Binaries which were found but rejected by the driver:
+				std::size_t rejected = 0;
+
+				std::size_t stores = 0;
+			};
+
+		protected:
+			StringT _directory;
+			HashT _driver_hash;
+			bool _supported;
+
+			Statistics _statistics;
+
+			StringT path_for_key(HashT key) const;
+
+		public:
+			/// The directory must already exist and be writable.
+			ProgramBinaryCache(const StringT & directory);
+			virtual ~ProgramBinaryCache();
+
+			/// Whether the driver supports at least one program binary format.
+			bool supported() const { return _supported; }
+
+			/// A hash of the strings which identify the driver.
+			static HashT driver_hash(const StringT & vendor, const StringT & renderer, const StringT & version, const StringT & shading_language_version);
+
+			/// Combine the source hash with the driver identity. The result must not change between runs, otherwise every entry will miss.
+			static HashT key(HashT driver_hash, HashT source_hash);
+			HashT key(HashT source_hash) const { return key(_driver_hash, source_hash); }
+
+			/// Try to load the program from the cache. Returns true if the program is now linked.
+			bool load(Ptr<Program> program, HashT source_hash);
+
+			/// Store the binary of a linked program. The program must have been linked after calling Program::set_binary_retrievable.
+			bool store(Ptr<Program> program, HashT source_hash);
+
+			const Statistics & statistics() const { return _statistics; }
+		};
+#endif
+	}
+}
+
+#endif
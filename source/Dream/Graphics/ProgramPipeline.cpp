@@ -0,0 +1,142 @@
+//
+//  Graphics/ProgramPipeline.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ProgramPipeline.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		ProgramPipeline::ProgramPipeline()
+		{
+			glGenProgramPipelines(1, &_handle);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		ProgramPipeline::~ProgramPipeline()
+		{
+			glDeleteProgramPipelines(1, &_handle);
+		}
+
+		GLbitfield ProgramPipeline::stage_bit(GLenum shader_type)
+		{
+			switch (shader_type) {
+				case GL_VERTEX_SHADER:
+					return GL_VERTEX_SHADER_BIT;
+				case GL_GEOMETRY_SHADER:
+					return GL_GEOMETRY_SHADER_BIT;
+				case GL_FRAGMENT_SHADER:
+					return GL_FRAGMENT_SHADER_BIT;
+				default:
+					return 0;
+			}
+		}
+
+		void ProgramPipeline::use_stages(GLbitfield stages, Ptr<Program> program)
+		{
+			glUseProgramStages(_handle, stages, program->handle());
+			_programs.push_back(program);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		bool ProgramPipeline::validate()
+		{
+			glValidateProgramPipeline(_handle);
+
+			GLint status = 0;
+			glGetProgramPipelineiv(_handle, GL_VALIDATE_STATUS, &status);
+
+			if (!status) {
+				GLint length = 0;
+				glGetProgramPipelineiv(_handle, GL_INFO_LOG_LENGTH, &length);
+
+				std::vector<GLchar> log(length + 1);
+				glGetProgramPipelineInfoLog(_handle, (GLsizei)log.size(), NULL, log.data());
+
+				logger()->log(LOG_ERROR, LogBuffer() << "Error validating program pipeline:" << std::endl << log.data());
+			}
+
+			return status != 0;
+		}
+
+		void ProgramPipeline::bind()
+		{
+			// A program made current with glUseProgram takes precedence over the bound pipeline:
+			glUseProgram(0);
+			glBindProgramPipeline(_handle);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void ProgramPipeline::unbind()
+		{
+			glBindProgramPipeline(0);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		Program::Binding ProgramPipeline::Binding::stage(Ptr<Program> program)
+		{
+			glActiveShaderProgram(_pipeline->handle(), program->handle());
+
+			return Program::Binding(program.get(), false);
+		}
+
+// MARK: -
+
+		ProgramPipelineCache::ProgramPipelineCache()
+		{
+		}
+
+		ProgramPipelineCache::~ProgramPipelineCache()
+		{
+		}
+
+		Ref<ProgramPipeline> ProgramPipelineCache::fetch(Ptr<Program> vertex, Ptr<Program> fragment, Ptr<Program> geometry)
+		{
+			// The pipeline retains its programs, so these pointers remain valid as long as the entry exists:
+			KeyT key(vertex.get(), fragment.get(), geometry.get());
+
+			auto iterator = _pipelines.find(key);
+
+			if (iterator != _pipelines.end())
+				return iterator->second;
+
+			Ref<ProgramPipeline> pipeline = new ProgramPipeline;
+
+			pipeline->use_stages(GL_VERTEX_SHADER_BIT, vertex);
+			pipeline->use_stages(GL_FRAGMENT_SHADER_BIT, fragment);
+
+			if (geometry)
+				pipeline->use_stages(GL_GEOMETRY_SHADER_BIT, geometry);
+
+			_pipelines[key] = pipeline;
+
+			return pipeline;
+		}
+
+		std::size_t ProgramPipelineCache::evict(Ptr<Program> program)
+		{
+			std::size_t count = 0;
+
+			for (auto iterator = _pipelines.begin(); iterator != _pipelines.end();) {
+				const KeyT & key = iterator->first;
+
+				if (std::get<0>(key) == program.get() || std::get<1>(key) == program.get() || std::get<2>(key) == program.get()) {
+					iterator = _pipelines.erase(iterator);
+					count += 1;
+				} else {
+					++iterator;
+				}
+			}
+
+			return count;
+		}
+#endif
+	}
+}
@@ -0,0 +1,103 @@
+//
+//  Graphics/ProgramPipeline.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_PROGRAMPIPELINE_H
+#define _DREAM_CLIENT_GRAPHICS_PROGRAMPIPELINE_H
+
+#include "ShaderManager.h"
+
+#include <tuple>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		/**
+		 Combines separable single stage programs at bind time. Rather than linking every combination of vertex and fragment variants into a monolithic program, each stage is linked once and pipelines are assembled from them, so the number of links grows with the number of stages rather than with the product of variants.
+
+		 Requires OpenGL 4.1 or ARB_separate_shader_objects.
+		 */
+		class ProgramPipeline : public Object {
+		protected:
+			GLuint _handle;
+
+			// The pipeline doesn't retain programs itself, so keep them alive while they are in use:
+			std::vector<Ref<Program>> _programs;
+
+			void bind();
+			void unbind();
+
+		public:
+			ProgramPipeline();
+			virtual ~ProgramPipeline();
+
+			GLuint handle() const { return _handle; }
+
+			/// The stage bit corresponding to a shader type, e.g. GL_VERTEX_SHADER_BIT for GL_VERTEX_SHADER.
+			static GLbitfield stage_bit(GLenum shader_type);
+
+			/// Use the given separable program for the given stages.
+			void use_stages(GLbitfield stages, Ptr<Program> program);
+
+			/// Check whether the pipeline can be used with the current state. Logs any problems.
+			bool validate();
+
+			class Binding : private NonCopyable {
+			protected:
+				ProgramPipeline * _pipeline;
+
+			public:
+				Binding(ProgramPipeline * pipeline) : _pipeline(pipeline) {
+					_pipeline->bind();
+				}
+
+				Binding(Binding && other) : _pipeline(other._pipeline) {
+					other._pipeline = NULL;
+				}
+
+				~Binding() {
+					if (_pipeline)
+						_pipeline->unbind();
+				}
+
+				/// Make the given stage program the target for uniform updates, and return a binding which can be used to set them.
+				Program::Binding stage(Ptr<Program> program);
+			};
+
+			Binding binding() {
+				Binding binding(this);
+
+				return std::move(binding);
+			}
+		};
+
+		/// Caches pipelines by their combination of stage programs, so that each combination is only assembled once.
+		class ProgramPipelineCache : public Object {
+		protected:
+			typedef std::tuple<Program *, Program *, Program *> KeyT;
+
+			std::map<KeyT, Ref<ProgramPipeline>> _pipelines;
+
+		public:
+			ProgramPipelineCache();
+			virtual ~ProgramPipelineCache();
+
+			/// Fetch the pipeline for the given separable stage programs, assembling it if required. The geometry stage is optional.
+			Ref<ProgramPipeline> fetch(Ptr<Program> vertex, Ptr<Program> fragment, Ptr<Program> geometry = NULL);
+
+			std::size_t pipeline_count() const { return _pipelines.size(); }
+
+			/// Release all pipelines which use the given program, e.g. after it was replaced, as pipelines refer to the program handle they were assembled with. Returns the number of pipelines released.
+			std::size_t evict(Ptr<Program> program);
+
+			/// Release all pipelines and the programs they retain.
+			void clear() { _pipelines.clear(); }
+		};
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,73 @@
+//
+//  Graphics/ProgramQueue.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ProgramQueue.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		ProgramQueue::ProgramQueue() : _submitted(0), _linked(0), _failed(0)
+		{
+		}
+
+		ProgramQueue::~ProgramQueue()
+		{
+		}
+
+		void ProgramQueue::submit(Ptr<Program> program, CallbackT callback)
+		{
+			DREAM_ASSERT(program->link_state() != Program::LinkState::UNLINKED);
+
+			_pending.push_back({program, callback});
+			_submitted += 1;
+		}
+
+		void ProgramQueue::complete(Pending & pending)
+		{
+			if (pending.program->ready())
+				_linked += 1;
+			else
+				_failed += 1;
+
+			if (pending.callback)
+				pending.callback(pending.program);
+		}
+
+		std::size_t ProgramQueue::poll()
+		{
+			bool parallel = ShaderManager::parallel_compile_supported();
+			std::size_t i = 0;
+
+			while (i < _pending.size()) {
+				Pending pending = _pending[i];
+
+				if (pending.program->link_completed()) {
+					erase_element_at_index(i, _pending);
+					complete(pending);
+
+					// Without parallel compilation, checking the status may have blocked, so don't check any more this time around:
+					if (!parallel)
+						break;
+				} else {
+					i += 1;
+				}
+			}
+
+			return _pending.size();
+		}
+
+		void ProgramQueue::finish()
+		{
+			while (!_pending.empty()) {
+				Pending pending = _pending.back();
+				_pending.pop_back();
+
+				pending.program->finish_link();
+				complete(pending);
+			}
+		}
+	}
+}
@@ -0,0 +1,59 @@
+//
+//  Graphics/ProgramQueue.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_PROGRAMQUEUE_H
+#define _DREAM_CLIENT_GRAPHICS_PROGRAMQUEUE_H
+
+#include "ShaderManager.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 Tracks programs which are being compiled and linked asynchronously, so that many programs can be submitted up front and the driver can work on them while the application does something else, e.g. decoding assets behind a loading screen.
+
+		 When GL_KHR_parallel_shader_compile is available, polling never blocks. Otherwise, there is no way to know if linking has finished without waiting for it, so each call to poll completes at most one program.
+		 */
+		class ProgramQueue : public Object {
+		public:
+			/// Invoked once linking has finished, whether or not it was successful.
+			typedef std::function<void (Ptr<Program> program)> CallbackT;
+
+		protected:
+			struct Pending {
+				Ref<Program> program;
+				CallbackT callback;
+			};
+
+			std::vector<Pending> _pending;
+
+			std::size_t _submitted, _linked, _failed;
+
+			void complete(Pending & pending);
+
+		public:
+			ProgramQueue();
+			virtual ~ProgramQueue();
+
+			/// Track a program which has been submitted with Program::link_async.
+			void submit(Ptr<Program> program, CallbackT callback = nullptr);
+
+			/// Complete any programs which have finished linking. Returns the number of programs still pending.
+			std::size_t poll();
+
+			/// Wait for all pending programs to finish linking.
+			void finish();
+
+			std::size_t pending_count() const { return _pending.size(); }
+
+			std::size_t submitted_count() const { return _submitted; }
+			std::size_t linked_count() const { return _linked; }
+			std::size_t failed_count() const { return _failed; }
+		};
+	}
+}
+
+#endif
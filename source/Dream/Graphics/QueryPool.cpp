@@ -0,0 +1,57 @@
+//
+//  Graphics/QueryPool.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "QueryPool.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		QueryPool::QueryPool(GLenum target, std::size_t batch_size) : _target(target), _batch_size(batch_size)
+		{
+		}
+
+		QueryPool::~QueryPool()
+		{
+			if (!_handles.empty())
+				glDeleteQueries((GLsizei)_handles.size(), _handles.data());
+		}
+
+		GLuint QueryPool::allocate()
+		{
+			if (_available.empty()) {
+				std::size_t offset = _handles.size();
+
+				_handles.resize(offset + _batch_size);
+				glGenQueries((GLsizei)_batch_size, _handles.data() + offset);
+
+				DREAM_CHECK_GRAPHICS_ERROR();
+
+				// Hand out the lowest handles first:
+				_available.assign(_handles.rbegin(), _handles.rbegin() + _batch_size);
+			}
+
+			GLuint handle = _available.back();
+			_available.pop_back();
+
+			return handle;
+		}
+
+		void QueryPool::release(GLuint handle)
+		{
+			_available.push_back(handle);
+		}
+
+		bool QueryPool::available(GLuint handle)
+		{
+			GLuint available = GL_FALSE;
+			glGetQueryObjectuiv(handle, GL_QUERY_RESULT_AVAILABLE, &available);
+
+			return available == GL_TRUE;
+		}
+#endif
+	}
+}
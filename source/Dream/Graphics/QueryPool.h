@@ -0,0 +1,52 @@
+//
+//  Graphics/QueryPool.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_QUERYPOOL_H
+#define _DREAM_CLIENT_GRAPHICS_QUERYPOOL_H
+
+#include "Graphics.h"
+
+#include <vector>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		/// A pool of query objects for a single target. Queries are generated in batches and recycled, so issuing queries every frame doesn't create and delete GL objects.
+		class QueryPool : public Object {
+		protected:
+			GLenum _target;
+			std::size_t _batch_size;
+
+			std::vector<GLuint> _handles;
+			std::vector<GLuint> _available;
+
+		public:
+			QueryPool(GLenum target, std::size_t batch_size = 64);
+			virtual ~QueryPool();
+
+			GLenum target() const { return _target; }
+
+			/// Take a query from the pool, generating more if required.
+			GLuint allocate();
+
+			/// Return a query to the pool. Its result must no longer be required.
+			void release(GLuint handle);
+
+			/// Whether the result of the given query is available, without blocking.
+			static bool available(GLuint handle);
+
+			/// The number of queries which have been generated.
+			std::size_t size() const { return _handles.size(); }
+
+			/// The number of queries which are currently allocated.
+			std::size_t allocated() const { return _handles.size() - _available.size(); }
+		};
+#endif
+	}
+}
+
+#endif
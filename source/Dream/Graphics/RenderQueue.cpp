@@ -0,0 +1,204 @@
+//
+//  Graphics/RenderQueue.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "RenderQueue.h"
+
+#include <algorithm>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		RenderQueue::SortKeyT RenderQueue::make_key(std::uint32_t layer, bool translucent, std::uint32_t program, std::uint32_t texture, std::uint32_t vertex_array, float depth)
+		{
+			const SortKeyT STATE_MASK = (1 << STATE_BITS) - 1;
+			const SortKeyT DEPTH_MAX = (1 << DEPTH_BITS) - 1;
+
+			depth = std::min(std::max(depth, 0.0f), 1.0f);
+			SortKeyT quantized_depth = (SortKeyT)(depth * DEPTH_MAX);
+
+			SortKeyT state = ((program & STATE_MASK) << (STATE_BITS * 2)) | ((texture & STATE_MASK) << STATE_BITS) | (vertex_array & STATE_MASK);
+
+			SortKeyT key = (SortKeyT)(layer & ((1 << LAYER_BITS) - 1)) << (64 - LAYER_BITS);
+
+			if (translucent) {
+				key |= (SortKeyT)1 << (64 - LAYER_BITS - 1);
+
+				// Back to front:
+				key |= (DEPTH_MAX - quantized_depth) << (STATE_BITS * 3);
+				key |= state;
+			} else {
+				// Front to back, to make the most of early depth testing:
+				key |= state << DEPTH_BITS;
+				key |= quantized_depth;
+			}
+
+			return key;
+		}
+
+		RenderQueue::RenderQueue()
+		{
+		}
+
+		RenderQueue::~RenderQueue()
+		{
+		}
+
+		std::uint32_t RenderQueue::identifier(const void * object)
+		{
+			auto result = _identifiers.insert(std::make_pair(object, (std::uint32_t)_identifiers.size()));
+
+			// Beyond the available bits, objects share the last identifier:
+			return std::min<std::uint32_t>(result.first->second, (1 << STATE_BITS) - 1);
+		}
+
+		void RenderQueue::submit(const Packet & packet)
+		{
+			const void * program = packet.program.get();
+			const void * texture = packet.texture.get();
+
+			if (_packets.empty() || program != _last_program)
+				_unsorted_program_switches += 1;
+
+			if (texture && (_packets.empty() || texture != _last_texture))
+				_unsorted_texture_switches += 1;
+
+			_last_program = program;
+			_last_texture = texture;
+
+			SortKeyT key = make_key(packet.layer, packet.translucent, identifier(program), identifier(texture), identifier(packet.vertex_array), packet.depth);
+
+			_entries.push_back({key, (std::uint32_t)_packets.size()});
+			_packets.push_back(packet);
+		}
+
+		void RenderQueue::sort()
+		{
+			const std::size_t PASSES = sizeof(SortKeyT), RADIX = 256;
+			const std::size_t count = _entries.size();
+
+			_statistics.passes_skipped = 0;
+
+			if (count < 2)
+				return;
+
+			// Histograms for every pass are computed up front, in a single pass over the keys:
+			std::vector<std::size_t> histograms(PASSES * RADIX, 0);
+
+			for (auto & entry : _entries) {
+				for (std::size_t pass = 0; pass < PASSES; pass += 1)
+					histograms[pass * RADIX + ((entry.key >> (pass * 8)) & 0xFF)] += 1;
+			}
+
+			_scratch.resize(count);
+
+			// Least significant digit first; each pass is stable, so earlier passes are preserved:
+			for (std::size_t pass = 0; pass < PASSES; pass += 1) {
+				std::size_t * histogram = histograms.data() + pass * RADIX;
+
+				// If every key has the same digit, this pass wouldn't change the order:
+				if (histogram[(_entries[0].key >> (pass * 8)) & 0xFF] == count) {
+					_statistics.passes_skipped += 1;
+					continue;
+				}
+
+				std::size_t offset = 0;
+				for (std::size_t digit = 0; digit < RADIX; digit += 1) {
+					std::size_t size = histogram[digit];
+					histogram[digit] = offset;
+					offset += size;
+				}
+
+				for (auto & entry : _entries)
+					_scratch[histogram[(entry.key >> (pass * 8)) & 0xFF]++] = entry;
+
+				_entries.swap(_scratch);
+			}
+		}
+
+		void RenderQueue::flush(Ptr<TextureManager> texture_manager)
+		{
+			sort();
+
+			_statistics.packets = _packets.size();
+			_statistics.program_switches = _statistics.texture_switches = _statistics.vertex_array_switches = 0;
+
+			Program * current_program = nullptr;
+			Texture * current_texture = nullptr;
+			VertexArray * current_vertex_array = nullptr;
+
+			for (auto & entry : _entries) {
+				const Packet & packet = _packets[entry.index];
+
+				DREAM_ASSERT(packet.program && packet.vertex_array);
+
+				if (packet.program.get() != current_program) {
+					current_program = packet.program.get();
+					current_program->enable();
+
+					_statistics.program_switches += 1;
+				}
+
+				if (packet.texture && packet.texture.get() != current_texture) {
+					current_texture = packet.texture.get();
+
+					if (texture_manager) {
+						texture_manager->bind(0, current_texture);
+					} else {
+						glActiveTexture(GL_TEXTURE0);
+						glBindTexture(current_texture->target(), current_texture->handle());
+
+						FrameStats::count(FrameStats::TEXTURE_BINDS);
+					}
+
+					_statistics.texture_switches += 1;
+				}
+
+				if (packet.vertex_array != current_vertex_array) {
+					current_vertex_array = packet.vertex_array;
+					current_vertex_array->bind();
+
+					_statistics.vertex_array_switches += 1;
+				}
+
+				if (packet.uniforms) {
+					// The program is already current, so the binding doesn't change it:
+					Program::Binding binding(current_program, false);
+					packet.uniforms(binding, packet.user_data);
+				}
+
+				if (packet.index_type)
+					glDrawElements(packet.mode, packet.count, packet.index_type, (const GLvoid *)packet.first);
+				else
+					glDrawArrays(packet.mode, (GLint)packet.first, packet.count);
+
+				FrameStats::count_draw(packet.mode, packet.count);
+			}
+
+			if (current_vertex_array)
+				current_vertex_array->unbind();
+
+			if (current_program)
+				current_program->disable();
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+
+			_statistics.program_switches_avoided = _unsorted_program_switches - std::min(_unsorted_program_switches, _statistics.program_switches);
+			_statistics.texture_switches_avoided = _unsorted_texture_switches - std::min(_unsorted_texture_switches, _statistics.texture_switches);
+
+			clear();
+		}
+
+		void RenderQueue::clear()
+		{
+			_packets.clear();
+			_entries.clear();
+			_identifiers.clear();
+
+			_last_program = _last_texture = nullptr;
+			_unsorted_program_switches = _unsorted_texture_switches = 0;
+		}
+	}
+}
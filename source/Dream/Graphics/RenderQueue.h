@@ -0,0 +1,131 @@
+//
+//  Graphics/RenderQueue.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_RENDERQUEUE_H
+#define _DREAM_CLIENT_GRAPHICS_RENDERQUEUE_H
+
+#include "ShaderManager.h"
+#include "TextureManager.h"
+#include "VertexArray.h"
+
+#include <cstdint>
+#include <unordered_map>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 Collects draw packets, e.g. from IRenderer::render, sorts them by state and then issues them, so that draws which share a program, texture or vertex array are issued together rather than in traversal order.
+
+		 Packets are ordered by a 64-bit key. From the most significant bit: the layer (4 bits), translucency (1 bit), then for opaque packets the program, texture and vertex array (12 bits each) followed by the depth (23 bits, front to back). Translucent packets must be blended back to front, so the depth comes before the state.
+
+		 Programs, textures and vertex arrays are numbered in the order they are first submitted each frame. Beyond 4095 distinct objects, sorting is still correct, but less state is shared.
+		 */
+		class RenderQueue : public Object {
+		public:
+			typedef std::uint64_t SortKeyT;
+
+			/// Set uniforms for an individual packet, e.g. the model matrix. The program is already current.
+			typedef void (*UniformsCallbackT)(Program::Binding & binding, const void * user_data);
+
+			struct Packet {
+				// The layer is the most significant part of the key, e.g. for drawing overlays after the scene:
+				std::uint8_t layer = 0;
+				bool translucent = false;
+
+				// The normalized view depth, in the range [0, 1]:
+				float depth = 0;
+
+				Ptr<Program> program;
+				Ptr<Texture> texture;
+				VertexArray * vertex_array = nullptr;
+
+				GLenum mode = GL_TRIANGLES;
+
+				// If zero, the packet is drawn with glDrawArrays, otherwise glDrawElements:
+				GLenum index_type = 0;
+
+				// The first vertex for arrays, or the byte offset into the index buffer for elements:
+				std::size_t first = 0;
+				GLsizei count = 0;
+
+				UniformsCallbackT uniforms = nullptr;
+				const void * user_data = nullptr;
+			};
+
+			struct Statistics {
+				std::size_t packets = 0;
+
+				std::size_t program_switches = 0;
+				std::size_t texture_switches = 0;
+				std::size_t vertex_array_switches = 0;
+
+				// The number of switches which would have been required if packets were issued in submission order:
+				std::size_t program_switches_avoided = 0;
+				std::size_t texture_switches_avoided = 0;
+
+				// Radix sort passes which were skipped because all keys had the same digit:
+				std::size_t passes_skipped = 0;
+			};
+
+			static const std::size_t LAYER_BITS = 4, STATE_BITS = 12, DEPTH_BITS = 23;
+
+			/// Construct a sort key from its parts, which are truncated to the available bits.
+			static SortKeyT make_key(std::uint32_t layer, bool translucent, std::uint32_t program, std::uint32_t texture, std::uint32_t vertex_array, float depth);
+
+		protected:
+			struct Entry {
+				SortKeyT key;
+				std::uint32_t index;
+			};
+
+			std::vector<Packet> _packets;
+			std::vector<Entry> _entries, _scratch;
+
+			// Numbers assigned to each object in the order they are first submitted:
+			std::unordered_map<const void *, std::uint32_t> _identifiers;
+
+			// The state of the previously submitted packet, to count the switches required in submission order:
+			const void * _last_program = nullptr;
+			const void * _last_texture = nullptr;
+			std::size_t _unsorted_program_switches = 0, _unsorted_texture_switches = 0;
+
+			Statistics _statistics;
+
+			std::uint32_t identifier(const void * object);
+
+		public:
+			RenderQueue();
+			virtual ~RenderQueue();
+
+			/// Add a packet to be drawn by the next call to `flush`.
+			void submit(const Packet & packet);
+
+			/// Sort the submitted packets by key. This is done by `flush`, but can be used separately.
+			void sort();
+
+			/// The packets in sorted order, once `sort` has been called.
+			template <typename CallbackT>
+			void each_sorted(CallbackT callback) const {
+				for (auto & entry : _entries)
+					callback(_packets[entry.index], entry.key);
+			}
+
+			/// Sort and draw all submitted packets, then clear the queue. If a texture manager is given, it is used to bind textures, so its state remains consistent.
+			void flush(Ptr<TextureManager> texture_manager = nullptr);
+
+			/// Discard all submitted packets.
+			void clear();
+
+			std::size_t size() const { return _packets.size(); }
+
+			/// Statistics for the most recent flush.
+			const Statistics & statistics() const { return _statistics; }
+		};
+	}
+}
+
+#endif
@@ -9,6 +9,10 @@
 #include "Renderer.h"
 #include "ShaderFactory.h"
 
+#include <thread>
+#include <exception>
+#include <algorithm>
+
 namespace Dream
 {
 	namespace Graphics
@@ -40,20 +44,220 @@ namespace Dream
 			node->accept(this);
 		}
 
+		void IRenderer::traverse_parallel(const std::vector<INode *> & subtrees, std::vector<Ref<CommandBuffer>> & command_buffers, std::size_t thread_count) {
+			// Existing command buffers are reused, so recording doesn't allocate once they have grown:
+			while (command_buffers.size() < subtrees.size())
+				command_buffers.push_back(new CommandBuffer);
+
+			command_buffers.resize(subtrees.size());
+
+			if (thread_count == 0)
+				thread_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+			thread_count = std::min(thread_count, subtrees.size());
+
+			std::vector<std::exception_ptr> errors(thread_count);
+
+			// Each worker records a contiguous range of subtrees:
+			auto record = [&](std::size_t worker) {
+				std::size_t begin = subtrees.size() * worker / thread_count, end = subtrees.size() * (worker + 1) / thread_count;
+
+				try {
+					for (std::size_t i = begin; i < end; i += 1) {
+						command_buffers[i]->clear();
+
+						CommandBuffer::Recording recording(command_buffers[i].get());
+						traverse(subtrees[i]);
+					}
+				} catch (...) {
+					errors[worker] = std::current_exception();
+				}
+			};
+
+			std::vector<std::thread> workers;
+
+			// The calling thread records the first range itself:
+			for (std::size_t worker = 1; worker < thread_count; worker += 1)
+				workers.emplace_back(record, worker);
+
+			if (thread_count > 0)
+				record(0);
+
+			for (auto & worker : workers)
+				worker.join();
+
+			for (auto & error : errors) {
+				if (error)
+					std::rethrow_exception(error);
+			}
+		}
+
 // MARK: -
 
+		RendererState::RendererState() : shader_variants(new ShaderVariantCache), program_queue(new ProgramQueue), render_queue(new RenderQueue) {
+#ifndef DREAM_OPENGLES2
+			program_pipelines = new ProgramPipelineCache;
+#endif
+		}
+
 		RendererState::~RendererState() {
 		}
 
 		Ref<Program> RendererState::load_program(const Path & name, const ShaderParser::DefinesMapT * defines) {
-			Ref<ShaderFactory> factory = resource_loader->load<ShaderFactory>(name);
+			if (!shader_variants)
+				return compile_program(resource_loader->load<ShaderFactory>(name), defines);
+
+			Ref<Program> program = shader_variants->lookup(name, defines);
+
+			if (!program) {
+				Ref<ShaderFactory> factory = shader_variants->factory(resource_loader, name);
+
+				if (shader_reloader)
+					shader_reloader->watch(resource_loader, name, factory);
+
+				program = compile_program(factory, defines);
+				shader_variants->insert(name, defines, program);
+
+				if (shader_manifest)
+					shader_manifest->add(name, defines);
+			} else {
+				// The variant may still be linking in the background:
+				program->finish_link();
+			}
+
+			return program;
+		}
+
+		Ref<Program> RendererState::load_program_async(const Path & name, const ShaderParser::DefinesMapT * defines) {
+			if (!shader_variants)
+				return compile_program(resource_loader->load<ShaderFactory>(name), defines, false);
+
+			Ref<Program> program = shader_variants->lookup(name, defines);
+
+			if (!program) {
+				Ref<ShaderFactory> factory = shader_variants->factory(resource_loader, name);
+
+				if (shader_reloader)
+					shader_reloader->watch(resource_loader, name, factory);
+
+				program = compile_program(factory, defines, false);
+				shader_variants->insert(name, defines, program);
+
+				if (shader_manifest)
+					shader_manifest->add(name, defines);
+			}
+
+			return program;
+		}
 
-			Ref<Program> program = new Program;
-			factory->attach(shader_manager, program, defines);
-			program->link();
+#ifndef DREAM_OPENGLES2
+		Ref<Program> RendererState::load_stage_program(const Path & name, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines) {
+			Ref<Program> program = shader_variants ? shader_variants->lookup(name, defines, (GLenum)stage) : nullptr;
 
+			if (program) {
+				program->finish_link();
+
+				return program;
+			}
+
+			Ref<ShaderFactory> factory = shader_variants ? shader_variants->factory(resource_loader, name) : resource_loader->load<ShaderFactory>(name);
+
+			if (shader_reloader && shader_variants)
+				shader_reloader->watch(resource_loader, name, factory);
+
+			program = compile_stage_program(factory, stage, defines);
+
+			if (shader_variants)
+				shader_variants->insert(name, defines, program, (GLenum)stage);
+
+			return program;
+		}
+
+		Ref<Program> RendererState::compile_stage_program(Ptr<ShaderFactory> factory, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines, bool wait, Ptr<Program> existing) {
+			Ref<Program> program = existing ? Ref<Program>(existing) : Ref<Program>(new Program);
+			program->set_separable();
+
+			if (stage == ShaderParser::SourceType::FRAGMENT)
+				program->bind_fragment_location("fragment_color");
+
+			// Separable programs must not share cache entries with complete programs built from the same source:
+			Hash hash;
+			hash.append(factory->hash(stage, defines));
+			hash.append(StringT("separable"));
+
+			HashT source_hash = hash.value();
+
+			if (program_cache && program_cache->load(program, source_hash))
+				return program;
+
+			if (program_cache)
+				program->set_binary_retrievable();
+
+			if (wait) {
+				factory->attach_stage(shader_manager, program, stage, defines);
+
+				if (program->link() && program_cache)
+					program_cache->store(program, source_hash);
+			} else {
+				factory->submit_stage(shader_manager, program, stage, defines);
+				program->link_async();
+
+				Ref<ProgramBinaryCache> cache = program_cache;
+				program_queue->submit(program, [cache, source_hash](Ptr<Program> program) {
+					if (cache && program->ready())
+						cache->store(program, source_hash);
+				});
+			}
+
+			return program;
+		}
+#endif
+
+		Ref<Program> RendererState::compile_program(Ptr<ShaderFactory> factory, const ShaderParser::DefinesMapT * defines, bool wait, Ptr<Program> existing) {
+			Ref<Program> program = existing ? Ref<Program>(existing) : Ref<Program>(new Program);
+
+			// This must be done before linking, otherwise it isn't part of the linked (and cached) program:
 			program->bind_fragment_location("fragment_color");
 
+#ifndef DREAM_OPENGLES2
+			if (program_cache) {
+				HashT source_hash = factory->hash(defines);
+
+				if (program_cache->load(program, source_hash))
+					return program;
+
+				program->set_binary_retrievable();
+
+				if (wait) {
+					factory->attach(shader_manager, program, defines);
+
+					if (program->link())
+						program_cache->store(program, source_hash);
+				} else {
+					factory->submit(shader_manager, program, defines);
+					program->link_async();
+
+					Ref<ProgramBinaryCache> cache = program_cache;
+					program_queue->submit(program, [cache, source_hash](Ptr<Program> program) {
+						if (program->ready())
+							cache->store(program, source_hash);
+					});
+				}
+
+				return program;
+			}
+#endif
+
+			if (wait) {
+				factory->attach(shader_manager, program, defines);
+				program->link();
+			} else {
+				factory->submit(shader_manager, program, defines);
+				program->link_async();
+
+				program_queue->submit(program);
+			}
+
 			return program;
 		}
 
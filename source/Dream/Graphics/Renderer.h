@@ -12,6 +12,14 @@
 #include "TextureManager.h"
 #include "ShaderManager.h"
 #include "ShaderParser.h"
+#include "ProgramBinaryCache.h"
+#include "ShaderVariantCache.h"
+#include "ProgramQueue.h"
+#include "ProgramPipeline.h"
+#include "ShaderReloader.h"
+#include "ShaderManifest.h"
+#include "RenderQueue.h"
+#include "CommandBuffer.h"
 
 #include <Dream/Display/Scene.h>
 #include <Dream/Renderer/Viewport.h>
@@ -47,15 +55,19 @@ namespace Dream
 		public:
 			virtual ~IRenderer();
 
-			// Overload this function with specific object callbacks. You may want to implement a hard coded version of this to avoid dynamic dispatch.
+			// Overload this function with specific object callbacks. You may want to implement a hard coded version of this to avoid dynamic dispatch, or use StaticSceneGraph for a closed set of node types.
 			virtual void render(INode * node);
 
-			// Call this function to begin the graph traversal.
+			// Call this function to begin the graph traversal. Every node is visited; to skip nodes outside the view, see `BoundingVolumeHierarchy::traverse`.
 			virtual void traverse(INode * node);
+
+			// Traverse the subtrees, e.g. the children of the root node, on worker threads. Each subtree is recorded into its own command buffer, which is current while it is traversed, see `CommandBuffer::current`. Rendering must record commands rather than issue GL calls, and must be safe to call from several threads. Replay the command buffers in order on the render thread. If thread_count is zero, the hardware concurrency is used.
+			virtual void traverse_parallel(const std::vector<INode *> & subtrees, std::vector<Ref<CommandBuffer>> & command_buffers, std::size_t thread_count = 0);
 		};
 
 		/// This state encapsulates the global state for many types of renderers.
 		struct RendererState : public Object {
+			RendererState();
 			virtual ~RendererState();
 
 			Ref<Resources::ILoader> resource_loader;
@@ -63,8 +75,59 @@ namespace Dream
 			Ref<ShaderManager> shader_manager;
 			Ref<Renderer::IViewport> viewport;
 
+#ifndef DREAM_OPENGLES2
+			// Optional, if set, linked programs are cached on disk:
+			Ref<ProgramBinaryCache> program_cache;
+#endif
+
+			// Programs are shared between all requests for the same path and defines:
+			Ref<ShaderVariantCache> shader_variants;
+
+			// Programs which are being compiled and linked asynchronously:
+			Ref<ProgramQueue> program_queue;
+
+			// Renderers may submit draw packets here rather than drawing immediately, so that draws are grouped by state, see `flush_render_queue`:
+			Ref<RenderQueue> render_queue;
+
+			// Optional, if set, every variant loaded by `load_program` or `load_program_async` is recorded in the manifest, see ShaderWarmup:
+			Ref<ShaderManifest> shader_manifest;
+
+			// Optional, if set, shader sources are watched and live programs are rebuilt when they change, see `reload_shaders`:
+			Ref<ShaderReloader> shader_reloader;
+
+#ifndef DREAM_OPENGLES2
+			// Pipelines assembled from separable stage programs, see `load_stage_program`:
+			Ref<ProgramPipelineCache> program_pipelines;
+#endif
+
+			// Compile and link a new program from the given factory, bypassing the variant cache. If wait is false, the program is linked asynchronously via the program queue. If an existing program is given, it is used rather than a new one, e.g. so that attribute locations can be bound beforehand:
+			Ref<Program> compile_program(Ptr<ShaderFactory> factory, const ShaderParser::DefinesMapT * defines = nullptr, bool wait = true, Ptr<Program> existing = nullptr);
+
+#ifndef DREAM_OPENGLES2
+			// Compile and link a separable program containing a single stage of the given factory, bypassing the variant cache. The wait and existing arguments behave as for `compile_program`:
+			Ref<Program> compile_stage_program(Ptr<ShaderFactory> factory, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines = nullptr, bool wait = true, Ptr<Program> existing = nullptr);
+#endif
+
 			// These are essentially helper methods to load shader programs:
 			Ref<Program> load_program(const Path & path, const ShaderParser::DefinesMapT * defines = nullptr);
+
+			// Start compiling and linking a program in the background. The program can't be used until it is ready, see `poll_programs`:
+			Ref<Program> load_program_async(const Path & path, const ShaderParser::DefinesMapT * defines = nullptr);
+
+#ifndef DREAM_OPENGLES2
+			// Load a separable program containing a single stage of the given shader, to be combined with other stages using `program_pipelines`:
+			Ref<Program> load_stage_program(const Path & path, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines = nullptr);
+#endif
+
+			// Complete any programs which have finished linking, without blocking. Returns the number of programs still pending.
+			std::size_t poll_programs() { return program_queue->poll(); }
+
+			// Draw all submitted packets, binding textures via the texture manager:
+			void flush_render_queue() { render_queue->flush(texture_manager); }
+
+			// Rebuild shaders which changed on disk and replace programs which are ready. This should be called once per frame, before drawing. Returns the number of programs still being rebuilt.
+			std::size_t reload_shaders() { return shader_reloader ? shader_reloader->update(this) : 0; }
+
 			Ref<Texture> load_texture(const TextureParameters & parameters, const Path & path);
 		};
 	}
@@ -7,40 +7,116 @@
 //
 
 #include "ShaderFactory.h"
+#include "Trace.h"
 
 namespace Dream
 {
 	namespace Graphics
 	{
-		ShaderFactory::ShaderFactory(Ptr<IData> data, const ILoader * loader) : _shader_parser(*data->buffer())
+		// Included paths are resolved by the same loader as the shader itself:
+		static ShaderParser::IncludeResolverT include_resolver(const ILoader * loader)
+		{
+			return [loader](const std::string & path) -> Shared<Buffer> {
+				Ref<IData> data = loader->data_for_resource(Path(path));
+
+				return data ? data->buffer() : nullptr;
+			};
+		}
+
+		ShaderFactory::ShaderFactory(Ptr<IData> data, const ILoader * loader, Shared<ShaderParser::ChunkCache> chunk_cache) : _shader_parser(data->buffer(), include_resolver(loader), chunk_cache)
 		{
 		}
 		
+		ShaderFactory::ShaderFactory(const Buffer & buffer) : _shader_parser(buffer)
+		{
+		}
+
 		ShaderFactory::~ShaderFactory()
 		{
 		}
 		
 		void ShaderFactory::attach(Ptr<ShaderManager> shader_manager, Ptr<Program> program, const ShaderParser::DefinesMapT * defines)
 		{
+			attach(shader_manager, program, defines, true);
+		}
+
+		void ShaderFactory::submit(Ptr<ShaderManager> shader_manager, Ptr<Program> program, const ShaderParser::DefinesMapT * defines)
+		{
+			attach(shader_manager, program, defines, false);
+		}
+
+		void ShaderFactory::attach(Ptr<ShaderManager> shader_manager, Ptr<Program> program, const ShaderParser::DefinesMapT * defines, bool wait)
+		{
+			DREAM_TRACE_ZONE("ShaderFactory::attach");
+
+			// The source strings point into the parsed buffers, so nothing is copied before it is given to the driver:
+			ShaderParser::Source source;
+
 			for (auto & pair : _shader_parser.source_buffers())
 			{
 				if (pair.first == ShaderParser::SourceType::HEADER) continue;
 				
-				StringStreamT source_buffer;
-				_shader_parser.full_buffer(source_buffer, pair.first, defines);
-			
-				source_buffer.seekg(0);
-				BufferedData data(source_buffer);
+				_shader_parser.assemble(source, pair.first, defines);
 				
-				GLuint shader = shader_manager->compile((GLenum)pair.first, *data.buffer());
+				GLuint shader = wait ? shader_manager->compile_shared((GLenum)pair.first, source.count(), source.strings(), source.lengths()) : shader_manager->submit_shared((GLenum)pair.first, source.count(), source.strings(), source.lengths());
 				
 				if (shader)
-					program->attach(shader);
+					program->attach(shader_manager, shader);
 				else
 					throw std::runtime_error("Could not load shader!");
 			}
 		}
 		
+		void ShaderFactory::attach_stage(Ptr<ShaderManager> shader_manager, Ptr<Program> program, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines)
+		{
+			attach_stage(shader_manager, program, stage, defines, true);
+		}
+
+		void ShaderFactory::submit_stage(Ptr<ShaderManager> shader_manager, Ptr<Program> program, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines)
+		{
+			attach_stage(shader_manager, program, stage, defines, false);
+		}
+
+		void ShaderFactory::attach_stage(Ptr<ShaderManager> shader_manager, Ptr<Program> program, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines, bool wait)
+		{
+			if (!has_stage(stage))
+				throw std::runtime_error("Shader does not contain the requested stage!");
+
+			ShaderParser::Source source;
+			_shader_parser.assemble(source, stage, defines);
+
+			GLuint shader = wait ? shader_manager->compile_shared((GLenum)stage, source.count(), source.strings(), source.lengths()) : shader_manager->submit_shared((GLenum)stage, source.count(), source.strings(), source.lengths());
+
+			if (shader)
+				program->attach(shader_manager, shader);
+			else
+				throw std::runtime_error("Could not load shader!");
+		}
+
+		bool ShaderFactory::has_stage(ShaderParser::SourceType stage) const
+		{
+			return stage != ShaderParser::SourceType::HEADER && _shader_parser.source_buffers().count(stage) != 0;
+		}
+
+		HashT ShaderFactory::hash(ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines) const
+		{
+			return _shader_parser.hash(stage, defines);
+		}
+
+		HashT ShaderFactory::hash(const ShaderParser::DefinesMapT * defines) const
+		{
+			Hash hash;
+
+			for (auto & pair : _shader_parser.source_buffers())
+			{
+				if (pair.first == ShaderParser::SourceType::HEADER) continue;
+
+				hash.append(_shader_parser.hash(pair.first, defines));
+			}
+
+			return hash.value();
+		}
+
 		void ShaderFactory::Loader::register_loader_types (ILoader * loader)
 		{
 			loader->set_loader_for_extension(this, "shader");
@@ -48,7 +124,7 @@ namespace Dream
 		
 		Ref<Object> ShaderFactory::Loader::load_from_data (const Ptr<IData> data, const ILoader * loader)
 		{
-			return new ShaderFactory(data, loader);
+			return new ShaderFactory(data, loader, _chunk_cache);
 		}
 	}
 }
@@ -11,6 +11,7 @@
 
 #include "ShaderParser.h"
 #include "ShaderManager.h"
+#include "Hash.h"
 
 namespace Dream
 {
@@ -20,19 +21,53 @@ namespace Dream
 		{
 		public:
 			class Loader : public Object, public virtual Resources::ILoadable {
+			protected:
+				// Included files are shared by all shaders loaded by this loader:
+				Shared<ShaderParser::ChunkCache> _chunk_cache = std::make_shared<ShaderParser::ChunkCache>();
+
 			public:
+				// Remove a changed include, and everything which includes it, from the cache:
+				std::set<std::string> invalidate(const std::string & path) { return _chunk_cache->invalidate(path); }
+
 				virtual void register_loader_types (ILoader * loader);
 				virtual Ref<Object> load_from_data (const Ptr<IData> data, const ILoader * loader);
 			};
 
-			ShaderFactory(Ptr<IData> data, const ILoader * loader);
+			ShaderFactory(Ptr<IData> data, const ILoader * loader, Shared<ShaderParser::ChunkCache> chunk_cache = nullptr);
+
+			// Construct a factory directly from shader source, e.g. for built-in programs:
+			ShaderFactory(const Buffer & buffer);
 			virtual ~ShaderFactory();
 
 			// Compile and attach all shaders to the given program:
 			void attach(Ptr<ShaderManager> shader_manager, Ptr<Program> program, const ShaderParser::DefinesMapT * defines = nullptr);
 
+			// Submit all shaders for compilation and attach them to the given program without waiting for the results. Errors are reported when the program is linked:
+			void submit(Ptr<ShaderManager> shader_manager, Ptr<Program> program, const ShaderParser::DefinesMapT * defines = nullptr);
+
+			// Compile and attach a single stage, e.g. for a separable program used with ProgramPipeline:
+			void attach_stage(Ptr<ShaderManager> shader_manager, Ptr<Program> program, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines = nullptr);
+
+			// Submit a single stage for compilation and attach it to the given program without waiting for the result:
+			void submit_stage(Ptr<ShaderManager> shader_manager, Ptr<Program> program, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines = nullptr);
+
+			// Whether the shader has source code for the given stage:
+			bool has_stage(ShaderParser::SourceType stage) const;
+
+			// A hash of the full preprocessed source of every stage, including the given defines:
+			HashT hash(const ShaderParser::DefinesMapT * defines = nullptr) const;
+
+			// A hash of the full preprocessed source of a single stage:
+			HashT hash(ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines = nullptr) const;
+
+			// All files included by the shader, directly or indirectly:
+			const std::set<std::string> & dependencies() const { return _shader_parser.dependencies(); }
+
 		protected:
 			ShaderParser _shader_parser;
+
+			void attach(Ptr<ShaderManager> shader_manager, Ptr<Program> program, const ShaderParser::DefinesMapT * defines, bool wait);
+			void attach_stage(Ptr<ShaderManager> shader_manager, Ptr<Program> program, ShaderParser::SourceType stage, const ShaderParser::DefinesMapT * defines, bool wait);
 		};
 	}
 }
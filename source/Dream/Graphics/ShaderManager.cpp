@@ -7,8 +7,15 @@
 //
 
 #include "ShaderManager.h"
+#include "FrameStats.h"
 
 #include <exception>
+#include <algorithm>
+#include <cstring>
+
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
 
 namespace Dream
 {
@@ -25,13 +32,15 @@ namespace Dream
 
 // MARK: -
 
-		Program::Program()
+		Program::Program() : _link_state(LinkState::UNLINKED)
 		{
 			_handle = glCreateProgram();
 		}
 
 		Program::~Program()
 		{
+			release_shaders();
+
 			glDeleteProgram(_handle);
 		}
 
@@ -40,6 +49,31 @@ namespace Dream
 			glAttachShader(_handle, shader);
 		}
 
+		void Program::attach(Ptr<ShaderManager> shader_manager, GLuint shader)
+		{
+			DREAM_ASSERT(!_shader_manager || _shader_manager == shader_manager);
+
+			_shader_manager = shader_manager;
+			_shader_manager->retain(shader);
+			_managed_shaders.push_back(shader);
+
+			glAttachShader(_handle, shader);
+		}
+
+		void Program::release_shaders()
+		{
+			if (!_shader_manager)
+				return;
+
+			for (auto shader : _managed_shaders) {
+				glDetachShader(_handle, shader);
+				_shader_manager->release(shader);
+			}
+
+			_managed_shaders.clear();
+			_shader_manager = nullptr;
+		}
+
 		static Shared<Buffer> program_info_log(GLuint program)
 		{
 			GLint length;
@@ -56,21 +90,99 @@ namespace Dream
 			}
 		}
 
+		static Shared<Buffer> shader_info_log(GLuint shader)
+		{
+			GLint length;
+			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+
+			if (length > 0) {
+				Shared<MutableBuffer> buffer = PackedBuffer::new_buffer(length);
+
+				glGetShaderInfoLog(shader, length, NULL, (GLchar *)buffer->begin());
+
+				return buffer;
+			} else {
+				return NULL;
+			}
+		}
+
 		bool Program::link()
+		{
+			link_async();
+
+			return finish_link();
+		}
+
+		void Program::link_async()
 		{
 			glLinkProgram(_handle);
 
+			_link_state = LinkState::LINKING;
+		}
+
+		bool Program::link_completed()
+		{
+			if (_link_state != LinkState::LINKING)
+				return _link_state != LinkState::UNLINKED;
+
+			if (ShaderManager::parallel_compile_supported()) {
+				GLint completion_status = GL_FALSE;
+				property(GL_COMPLETION_STATUS_KHR, &completion_status);
+
+				if (!completion_status)
+					return false;
+			}
+
+			finish_link();
+
+			return true;
+		}
+
+		bool Program::finish_link()
+		{
+			if (_link_state != LinkState::LINKING)
+				return ready();
+
 			GLint link_status;
 			property(GL_LINK_STATUS, &link_status);
-			glGetProgramiv(_handle, GL_LINK_STATUS, &link_status);
 
 			if (!link_status) {
 				LogBuffer buffer;
 				buffer << "Error linking program:" << std::endl;
-				buffer << program_info_log(_handle)->begin() << std::endl;
+
+				Shared<Buffer> log = program_info_log(_handle);
+				if (log)
+					buffer << log->begin() << std::endl;
+
+				// Shaders which were submitted without checking their status are reported here:
+				GLuint shaders[8];
+				GLsizei count = 0;
+				glGetAttachedShaders(_handle, 8, &count, shaders);
+
+				for (GLsizei i = 0; i < count; i += 1) {
+					GLint compile_status;
+					glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &compile_status);
+
+					if (!compile_status) {
+						Shared<Buffer> shader_log = shader_info_log(shaders[i]);
+
+						if (shader_log)
+							buffer << "Error compiling shader:" << std::endl << shader_log->begin() << std::endl;
+					}
+				}
+
 				logger()->log(LOG_ERROR, buffer);
+
+				_link_state = LinkState::FAILED;
+			} else {
+				_link_state = LinkState::LINKED;
+
+				reflect_uniforms();
 			}
 
+			// The linked program doesn't need the shaders any more:
+			release_shaders();
+
 			return link_status != 0;
 		}
 
@@ -79,15 +191,304 @@ namespace Dream
 			return glGetAttribLocation(_handle, name);
 		}
 
+		// The size in bytes of a single element of the given uniform type:
+		static std::size_t uniform_type_size(GLenum type)
+		{
+			switch (type) {
+				case GL_FLOAT_VEC2: case GL_INT_VEC2: case GL_BOOL_VEC2:
+					return 2 * 4;
+				case GL_FLOAT_VEC3: case GL_INT_VEC3: case GL_BOOL_VEC3:
+					return 3 * 4;
+				case GL_FLOAT_VEC4: case GL_INT_VEC4: case GL_BOOL_VEC4: case GL_FLOAT_MAT2:
+					return 4 * 4;
+				case GL_FLOAT_MAT3:
+					return 9 * 4;
+				case GL_FLOAT_MAT4:
+					return 16 * 4;
+#ifndef DREAM_OPENGLES2
+				case GL_UNSIGNED_INT_VEC2:
+					return 2 * 4;
+				case GL_UNSIGNED_INT_VEC3:
+					return 3 * 4;
+				case GL_UNSIGNED_INT_VEC4:
+					return 4 * 4;
+				case GL_FLOAT_MAT2x3: case GL_FLOAT_MAT3x2:
+					return 6 * 4;
+				case GL_FLOAT_MAT2x4: case GL_FLOAT_MAT4x2:
+					return 8 * 4;
+				case GL_FLOAT_MAT3x4: case GL_FLOAT_MAT4x3:
+					return 12 * 4;
+#endif
+				default:
+					// Scalars and samplers:
+					return 4;
+			}
+		}
+
+		void Program::reflect_uniforms()
+		{
+			_uniforms.clear();
+			_shadow.clear();
+
+			GLint count = 0, max_length = 0;
+			property(GL_ACTIVE_UNIFORMS, &count);
+			property(GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+
+			std::vector<GLchar> name(max_length + 1);
+
+			for (GLint i = 0; i < count; i += 1) {
+				GLsizei length = 0;
+				Uniform uniform;
+
+				glGetActiveUniform(_handle, i, (GLsizei)name.size(), &length, &uniform.size, &uniform.type, name.data());
+
+				// Uniforms in blocks don't have a location, but are still valid names:
+				uniform.location = glGetUniformLocation(_handle, name.data());
+
+				uniform.offset = _shadow.size();
+				uniform.byte_size = uniform.location != -1 ? uniform_type_size(uniform.type) * uniform.size : 0;
+				uniform.valid_size = 0;
+				_shadow.resize(uniform.offset + uniform.byte_size);
+
+				StringT key(name.data(), length);
+
+				// Arrays are reported as "name[0]", but are typically referred to as "name":
+				if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+					key.resize(key.size() - 3);
+
+				_uniforms[UniformName(key).identifier()] = uniform;
+			}
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void upload_uniform(GLint location, GLenum type, GLsizei count, const ByteT * data)
+		{
+			const GLfloat * floats = (const GLfloat *)data;
+			const GLint * integers = (const GLint *)data;
+
+			switch (type) {
+				case GL_FLOAT: glUniform1fv(location, count, floats); break;
+				case GL_FLOAT_VEC2: glUniform2fv(location, count, floats); break;
+				case GL_FLOAT_VEC3: glUniform3fv(location, count, floats); break;
+				case GL_FLOAT_VEC4: glUniform4fv(location, count, floats); break;
+				case GL_INT_VEC2: case GL_BOOL_VEC2: glUniform2iv(location, count, integers); break;
+				case GL_INT_VEC3: case GL_BOOL_VEC3: glUniform3iv(location, count, integers); break;
+				case GL_INT_VEC4: case GL_BOOL_VEC4: glUniform4iv(location, count, integers); break;
+				// Matrices are restored as they were stored, which is only correct if they weren't transposed on upload:
+				case GL_FLOAT_MAT2: glUniformMatrix2fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT3: glUniformMatrix3fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT4: glUniformMatrix4fv(location, count, GL_FALSE, floats); break;
+#ifndef DREAM_OPENGLES2
+				case GL_UNSIGNED_INT: glUniform1uiv(location, count, (const GLuint *)data); break;
+				case GL_UNSIGNED_INT_VEC2: glUniform2uiv(location, count, (const GLuint *)data); break;
+				case GL_UNSIGNED_INT_VEC3: glUniform3uiv(location, count, (const GLuint *)data); break;
+				case GL_UNSIGNED_INT_VEC4: glUniform4uiv(location, count, (const GLuint *)data); break;
+				case GL_FLOAT_MAT2x3: glUniformMatrix2x3fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT3x2: glUniformMatrix3x2fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT2x4: glUniformMatrix2x4fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT4x2: glUniformMatrix4x2fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT3x4: glUniformMatrix3x4fv(location, count, GL_FALSE, floats); break;
+				case GL_FLOAT_MAT4x3: glUniformMatrix4x3fv(location, count, GL_FALSE, floats); break;
+#endif
+				default:
+					// Integers, booleans and samplers:
+					glUniform1iv(location, count, integers);
+			}
+		}
+
+		void Program::bind_attribute_locations(Program & other)
+		{
+			GLint count = 0, max_length = 0;
+			other.property(GL_ACTIVE_ATTRIBUTES, &count);
+			other.property(GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &max_length);
+
+			std::vector<GLchar> name(max_length + 1);
+
+			for (GLint i = 0; i < count; i += 1) {
+				GLint size;
+				GLenum type;
+
+				glGetActiveAttrib(other._handle, i, (GLsizei)name.size(), NULL, &size, &type, name.data());
+
+				GLint location = glGetAttribLocation(other._handle, name.data());
+
+				// Built-in attributes don't have a location:
+				if (location != -1)
+					glBindAttribLocation(_handle, location, name.data());
+			}
+		}
+
+		void Program::replace(Program & replacement)
+		{
+			DREAM_ASSERT(replacement.ready());
+
+			std::swap(_handle, replacement._handle);
+			std::swap(_link_state, replacement._link_state);
+			std::swap(_uniforms, replacement._uniforms);
+			std::swap(_shadow, replacement._shadow);
+
+			// The replacement now holds the previous state, which is restored where the names and types still match:
+			glUseProgram(_handle);
+
+			for (auto & pair : replacement._uniforms) {
+				const Uniform & previous = pair.second;
+				auto current = _uniforms.find(pair.first);
+
+				if (previous.valid_size == 0 || current == _uniforms.end())
+					continue;
+
+				Uniform & uniform = current->second;
+
+				if (uniform.location == -1 || uniform.type != previous.type)
+					continue;
+
+				std::size_t size = std::min(previous.valid_size, uniform.byte_size);
+				std::memcpy(_shadow.data() + uniform.offset, replacement._shadow.data() + previous.offset, size);
+				uniform.valid_size = size;
+
+				upload_uniform(uniform.location, uniform.type, (GLsizei)(size / uniform_type_size(uniform.type)), _shadow.data() + uniform.offset);
+			}
+
+			glUseProgram(0);
+
+#ifndef DREAM_OPENGLES2
+			GLint count = 0, max_length = 0;
+			replacement.property(GL_ACTIVE_UNIFORM_BLOCKS, &count);
+			replacement.property(GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_length);
+
+			std::vector<GLchar> name(max_length + 1);
+
+			for (GLint i = 0; i < count; i += 1) {
+				GLint binding = 0;
+
+				glGetActiveUniformBlockName(replacement._handle, i, (GLsizei)name.size(), NULL, name.data());
+				glGetActiveUniformBlockiv(replacement._handle, i, GL_UNIFORM_BLOCK_BINDING, &binding);
+
+				GLuint index = glGetUniformBlockIndex(_handle, name.data());
+
+				if (index != GL_INVALID_INDEX)
+					glUniformBlockBinding(_handle, index, binding);
+			}
+#endif
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		UniformName Program::uniform_name(const char * name)
+		{
+			CachedName & cached = _names[name];
+
+			// The same address may hold a different string, e.g. a reused buffer:
+			if (cached.name.empty() || cached.name != name) {
+				cached.name = name;
+				cached.identifier = UniformName(cached.name).identifier();
+			}
+
+			return UniformName::for_identifier(cached.identifier);
+		}
+
 		GLint Program::uniform_location(const char * name)
 		{
-			return glGetUniformLocation(_handle, name);
+			return uniform_location(uniform_name(name));
+		}
+
+		GLint Program::uniform_location(const UniformName & name)
+		{
+			auto iterator = _uniforms.find(name.identifier());
+
+			if (iterator != _uniforms.end())
+				return iterator->second.location;
+
+			// Until the program is linked, nothing is known about its uniforms:
+			if (!ready())
+				return -1;
+
+			// Reflection only reports the first element of arrays, so names like "weights[2]" are looked up by the driver. They don't have a shadow copy:
+			GLint location = glGetUniformLocation(_handle, name.name().c_str());
+
+			if (location == -1)
+				logger()->log(LOG_WARN, LogBuffer() << "Program " << _handle << " has no active uniform named " << name.name());
+
+			// Remember the result so that the driver is only asked, and the name only reported, once:
+			_uniforms[name.identifier()] = {location, 0, 0, 0, 0, 0};
+
+			return location;
+		}
+
+		void Program::invalidate_uniform(GLint location)
+		{
+			bool found = false;
+
+			for (auto & pair : _uniforms) {
+				Uniform & uniform = pair.second;
+
+				// Array elements usually have consecutive locations:
+				if (uniform.byte_size && location >= uniform.location && location < uniform.location + uniform.size) {
+					uniform.valid_size = 0;
+					found = true;
+				}
+			}
+
+			// Otherwise, the value could belong to any uniform:
+			if (!found) {
+				for (auto & pair : _uniforms)
+					pair.second.valid_size = 0;
+			}
+		}
+
+		GLint Program::update_uniform(const UniformName & name, const void * data, std::size_t size)
+		{
+			auto iterator = _uniforms.find(name.identifier());
+
+			if (iterator == _uniforms.end()) {
+				if (uniform_location(name) == -1)
+					return -1;
+
+				iterator = _uniforms.find(name.identifier());
+			}
+
+			Uniform & uniform = iterator->second;
+
+			if (uniform.location == -1)
+				return -1;
+
+			// Names without a shadow copy, e.g. array elements, may overwrite part of a value which has one:
+			if (uniform.byte_size == 0)
+				invalidate_uniform(uniform.location);
+
+			// Values larger than the reflected storage (which shouldn't happen) are always uploaded:
+			if (size <= uniform.byte_size) {
+				ByteT * shadow = _shadow.data() + uniform.offset;
+
+				if (size <= uniform.valid_size && std::memcmp(shadow, data, size) == 0) {
+					FrameStats::count(FrameStats::UNIFORM_SKIPPED);
+
+					return -1;
+				}
+
+				std::memcpy(shadow, data, size);
+				uniform.valid_size = std::max(uniform.valid_size, size);
+			}
+
+			FrameStats::count(FrameStats::UNIFORM_UPLOADS);
+
+			return uniform.location;
 		}
 
 #ifndef DREAM_OPENGLES2
 		GLint Program::uniform_block_index(const char * name) {
 			return glGetUniformBlockIndex(_handle, name);
 		}
+
+		void Program::set_uniform_block_binding(const char * name, GLuint binding_index) {
+			GLuint index = glGetUniformBlockIndex(_handle, name);
+
+			if (index != GL_INVALID_INDEX)
+				glUniformBlockBinding(_handle, index, binding_index);
+			else
+				logger()->log(LOG_WARN, LogBuffer() << "Program " << _handle << " has no uniform block named " << name);
+		}
 #endif
 
 		void Program::bind_fragment_location(const char * name, GLuint output)
@@ -97,9 +498,63 @@ namespace Dream
 //#endif
 		}
 
+#ifndef DREAM_OPENGLES2
+		void Program::set_feedback_varyings(const std::vector<const char *> & varyings, GLenum mode)
+		{
+			glTransformFeedbackVaryings(_handle, (GLsizei)varyings.size(), varyings.data(), mode);
+		}
+
+		void Program::set_separable(bool separable)
+		{
+			glProgramParameteri(_handle, GL_PROGRAM_SEPARABLE, separable ? GL_TRUE : GL_FALSE);
+		}
+
+		void Program::set_binary_retrievable(bool retrievable)
+		{
+			glProgramParameteri(_handle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, retrievable ? GL_TRUE : GL_FALSE);
+		}
+
+		bool Program::load_binary(GLenum format, const Buffer & buffer)
+		{
+			glProgramBinary(_handle, format, buffer.begin(), (GLsizei)buffer.size());
+
+			// A rejected binary is expected, e.g. after a driver update, so it isn't logged as an error:
+			GLint link_status;
+			glGetProgramiv(_handle, GL_LINK_STATUS, &link_status);
+
+			if (link_status) {
+				_link_state = LinkState::LINKED;
+
+				reflect_uniforms();
+			} else {
+				_link_state = LinkState::FAILED;
+			}
+
+			return link_status != 0;
+		}
+
+		Shared<Buffer> Program::binary(GLenum & format) const
+		{
+			GLint length = 0;
+			glGetProgramiv(_handle, GL_PROGRAM_BINARY_LENGTH, &length);
+
+			if (length > 0) {
+				Shared<MutableBuffer> buffer = PackedBuffer::new_buffer(length);
+
+				glGetProgramBinary(_handle, length, NULL, &format, buffer->begin());
+
+				return buffer;
+			} else {
+				return NULL;
+			}
+		}
+#endif
+
 		void Program::enable()
 		{
 			glUseProgram(_handle);
+
+			FrameStats::count(FrameStats::PROGRAM_BINDS);
 		}
 
 		void Program::disable()
@@ -109,44 +564,106 @@ namespace Dream
 
 // MARK: -
 
-		ShaderManager::ShaderManager()
+		ShaderManager::ShaderManager() : _compile_count(0), _deduplicated_count(0)
 		{
 		}
 
 		ShaderManager::~ShaderManager()
 		{
-			for (auto i : _shaders) {
-				glDeleteShader(i);
+			for (auto & pair : _shaders) {
+				glDeleteShader(pair.second.handle);
 			}
 		}
 
-		static Shared<Buffer> shader_info_log(GLuint shader)
+		bool ShaderManager::parallel_compile_supported()
 		{
-			GLint length;
-			glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+			static bool supported = has_graphics_extension("GL_KHR_parallel_shader_compile") || has_graphics_extension("GL_ARB_parallel_shader_compile");
 
-			if (length > 0) {
-				Shared<MutableBuffer> buffer = PackedBuffer::new_buffer(length);
+			return supported;
+		}
 
-				glGetShaderInfoLog(shader, length, NULL, (GLchar *)buffer->begin());
+		HashT ShaderManager::source_hash(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths)
+		{
+			Hash hash;
 
-				return buffer;
-			} else {
-				return NULL;
+			hash.append((HashT)type);
+
+			for (GLsizei i = 0; i < count; i += 1) {
+				std::size_t length = lengths ? lengths[i] : std::strlen(strings[i]);
+
+				hash.append(strings[i], length);
 			}
+
+			return hash.value();
 		}
 
-		GLenum ShaderManager::compile(GLenum type, const Buffer & buffer)
+		void ShaderManager::retain(GLuint shader)
 		{
-			GLuint shader = glCreateShader(type);
+			auto hash = _hashes.find(shader);
+
+			if (hash != _hashes.end())
+				_shaders[hash->second].references += 1;
+		}
+
+		void ShaderManager::release(GLuint shader)
+		{
+			auto hash = _hashes.find(shader);
+
+			if (hash == _hashes.end())
+				return;
 
+			Shader & record = _shaders[hash->second];
+
+			if (record.references > 0)
+				record.references -= 1;
+
+			if (record.references == 0)
+				erase(shader);
+		}
+
+		void ShaderManager::erase(GLuint shader)
+		{
+			auto hash = _hashes.find(shader);
+
+			if (hash != _hashes.end()) {
+				_shaders.erase(hash->second);
+				_hashes.erase(hash);
+			}
+
+			glDeleteShader(shader);
+		}
+
+		GLenum ShaderManager::submit(GLenum type, const Buffer & buffer)
+		{
+			const GLchar * source = (GLchar*)buffer.begin();
+			GLint length = (GLint)buffer.size();
+
+			return submit(type, 1, &source, &length);
+		}
+
+		GLenum ShaderManager::compile(GLenum type, const Buffer & buffer)
+		{
 			const GLchar * source = (GLchar*)buffer.begin();
 			GLint length = (GLint)buffer.size();
-			glShaderSource(shader, 1, &source, &length);
-			check_graphics_error();
+
+			return compile(type, 1, &source, &length);
+		}
+
+		GLuint ShaderManager::create(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths)
+		{
+			GLuint shader = glCreateShader(type);
+
+			glShaderSource(shader, count, strings, lengths);
+			DREAM_CHECK_GRAPHICS_ERROR();
 
 			glCompileShader(shader);
-			
+			_compile_count += 1;
+
+			return shader;
+		}
+
+		bool ShaderManager::compile_status(GLuint shader)
+		{
 			GLint compile_status;
 			glGetShaderiv(shader, GL_COMPILE_STATUS, &compile_status);
 
@@ -155,9 +672,60 @@ namespace Dream
 				log_buffer << "Error compiling shader:" << std::endl;
 				log_buffer << shader_info_log(shader)->begin() << std::endl;
 				logger()->log(LOG_ERROR, log_buffer);
-				
+
+				return false;
+			}
+
+			return true;
+		}
+
+		GLenum ShaderManager::submit(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths)
+		{
+			return create(type, count, strings, lengths);
+		}
+
+		GLenum ShaderManager::compile(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths)
+		{
+			GLuint shader = create(type, count, strings, lengths);
+
+			if (!compile_status(shader)) {
 				glDeleteShader(shader);
-				
+
+				return 0;
+			}
+
+			return shader;
+		}
+
+		GLenum ShaderManager::submit_shared(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths)
+		{
+			HashT hash = source_hash(type, count, strings, lengths);
+
+			auto existing = _shaders.find(hash);
+
+			if (existing != _shaders.end()) {
+				_deduplicated_count += 1;
+
+				return existing->second.handle;
+			}
+
+			GLuint shader = create(type, count, strings, lengths);
+
+			_shaders[hash] = Shader{shader, 0};
+			_hashes[shader] = hash;
+
+			return shader;
+		}
+
+		GLenum ShaderManager::compile_shared(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths)
+		{
+			GLuint shader = submit_shared(type, count, strings, lengths);
+
+			if (!compile_status(shader)) {
+				// A failed shader may have been submitted earlier and still be attached to a pending program:
+				if (_shaders[_hashes[shader]].references == 0)
+					erase(shader);
+
 				return 0;
 			}
 
@@ -10,6 +10,12 @@
 #define _DREAM_CLIENT_GRAPHICS_SHADERMANAGER_H
 
 #include "Graphics.h"
+#include "FrameStats.h"
+#include "UniformName.h"
+#include "Hash.h"
+
+#include <unordered_map>
+#include <map>
 
 #include <Euclid/Numerics/Vector.h>
 
@@ -28,9 +34,11 @@ namespace Dream
 
 		 UniformBuffer::Binding uniform_binding(0);
 
-		 program->set_uniform_block(uniform_binding);
-		 buffer->bind_range(uniform_binding);
+		 program->set_uniform_block_binding("lighting", uniform_binding.index());
+		 lighting_buffer->bind_range(uniform_binding.index(), sizeof(Lighting));
 		 }
+
+		 For per-object data, see UniformRing.
 		 */
 
 #ifndef DREAM_OPENGLES2
@@ -53,6 +61,8 @@ namespace Dream
 				glDeleteBuffers(1, &_handle);
 			}
 
+			GLuint handle() const { return _handle; }
+
 			void bind() {
 				glBindBuffer(GL_UNIFORM_BUFFER, _handle);
 			}
@@ -101,11 +111,68 @@ namespace Dream
 			const char * what () const noexcept;
 		};
 
+		/// Upload count elements of the given uniform type, e.g. GL_FLOAT_VEC4, to the current program. Matrices are not transposed.
+		void upload_uniform(GLint location, GLenum type, GLsizei count, const ByteT * data);
+
+		class ProgramPipeline;
+		class CommandBuffer;
+		class RenderQueue;
+		class ShaderManager;
+
 		class Program : public Object {
+		public:
+			enum class LinkState {
+				UNLINKED, LINKING, LINKED, FAILED
+			};
+
 		protected:
 			// This is actually a program handle.
 			GLenum _handle;
 
+			LinkState _link_state;
+
+			struct Uniform {
+				GLint location;
+				GLenum type;
+				GLint size;
+
+				// The storage for the last uploaded value in the shadow buffer:
+				std::size_t offset, byte_size;
+
+				// How many bytes of the shadow storage hold the last uploaded value:
+				std::size_t valid_size;
+			};
+
+			// Active uniforms by interned name, reflected once the program is linked:
+			std::unordered_map<UniformName::IdentifierT, Uniform> _uniforms;
+
+			// A copy of the values held by the program, so that redundant uploads can be skipped:
+			std::vector<ByteT> _shadow;
+
+			// Names which were interned from strings, by address, so that repeated lookups with the same string don't need to lock the global name table:
+			struct CachedName {
+				StringT name;
+				UniformName::IdentifierT identifier;
+			};
+
+			std::unordered_map<const char *, CachedName> _names;
+
+			UniformName uniform_name(const char * name);
+
+			// Forget any shadow copy which may hold the value at the given location, after it was written by some other means:
+			void invalidate_uniform(GLint location);
+
+			// Shaders owned by the shader manager, which are released once linking has finished:
+			Ref<ShaderManager> _shader_manager;
+			std::vector<GLuint> _managed_shaders;
+
+			void release_shaders();
+
+			void reflect_uniforms();
+
+			friend class RenderQueue;
+			friend class CommandBuffer;
+
 			void enable();
 			void disable();
 
@@ -114,14 +181,65 @@ namespace Dream
 			~Program();
 
 			void attach(GLenum shader);
+
+			/// Attach a shared shader which was compiled by the given shader manager, see `ShaderManager::compile_shared`. It is detached and released once linking has finished, so that the driver can reclaim it.
+			void attach(Ptr<ShaderManager> shader_manager, GLuint shader);
+
+			/// Link the program and wait for the result.
 			bool link();
 
+			/// Start linking the program without waiting for the result. Use `link_completed` to poll for completion.
+			void link_async();
+
+			/// Returns true once linking has finished, successfully or not. When GL_KHR_parallel_shader_compile is available, this never blocks.
+			bool link_completed();
+
+			/// Wait for linking to finish and return whether it was successful.
+			bool finish_link();
+
+			LinkState link_state() const { return _link_state; }
+
+			/// Whether the program is linked and can be used for drawing.
+			bool ready() const { return _link_state == LinkState::LINKED; }
+
+			/// Bind the same attribute locations as the other program, e.g. before linking a reloaded version of it. This only takes effect when the program is next linked.
+			void bind_attribute_locations(Program & other);
+
+			/// Take over the linked program from the replacement, which must be ready, e.g. after the shader was reloaded. Uniform values and uniform block bindings are carried over, as renderers may only set them once. The replacement is left holding the previous program.
+			void replace(Program & replacement);
+
 			GLint attribute_location(const char * name);
 			GLint uniform_location(const char * name);
+			GLint uniform_location(const UniformName & name);
+
+			/// Record a new value for the given uniform. Returns the location to upload the value to, or -1 if the program already holds it.
+			GLint update_uniform(const UniformName & name, const void * data, std::size_t size);
 			GLint uniform_block_index(const char * name);
 
+#ifndef DREAM_OPENGLES2
+			/// Associate the named uniform block with the given binding index, e.g. as used by UniformBuffer::bind_range.
+			void set_uniform_block_binding(const char * name, GLuint binding_index);
+#endif
+
 			void bind_fragment_location(const char * name, GLuint output = 0);
 
+#ifndef DREAM_OPENGLES2
+			/// Specify which outputs are captured by transform feedback. This only takes effect when the program is next linked.
+			void set_feedback_varyings(const std::vector<const char *> & varyings, GLenum mode = GL_INTERLEAVED_ATTRIBS);
+
+			/// Allow the program to be used for individual stages of a ProgramPipeline. This only takes effect when the program is next linked.
+			void set_separable(bool separable = true);
+
+			/// Ask the driver to keep the linked binary so it can be retrieved with `binary`. This only takes effect when the program is next linked.
+			void set_binary_retrievable(bool retrievable = true);
+
+			/// Load a previously retrieved binary. Returns false if the driver rejected it, in which case the program should be compiled and linked as usual.
+			bool load_binary(GLenum format, const Buffer & buffer);
+
+			/// Retrieve the linked program binary and its driver specific format, or NULL if it is not available.
+			Shared<Buffer> binary(GLenum & format) const;
+#endif
+
 		public:
 			void set_attribute_location(const char * name, GLuint location) {
 				glBindAttribLocation(_handle, location, name);
@@ -131,46 +249,105 @@ namespace Dream
 			protected:
 				Program * _program;
 
-				GLuint location_of(GLuint location) {
+				// Whether the program was made current with glUseProgram, rather than being the active program of a bound pipeline:
+				bool _current;
+
+				friend class ProgramPipeline;
+				friend class RenderQueue;
+				friend class CommandBuffer;
+
+				Binding(Program * program, bool current) : _program(program), _current(current) {
+					if (_current)
+						_program->enable();
+				}
+
+				// These return the location to upload the value to, or -1 if the program already holds it:
+				GLint location_for(GLuint location, const void * data, std::size_t size) {
+					// There is no shadow copy for raw locations, but a named uniform may have one for the same location:
+					_program->invalidate_uniform(location);
+					FrameStats::count(FrameStats::UNIFORM_UPLOADS);
+
 					return location;
 				}
 
-				GLuint location_of(const char * name) {
-					return _program->uniform_location(name);
+				template <typename LocationT, dimension R, dimension C, typename T>
+				void set_matrix(LocationT name, const T * data) {
+					GLint location = location_for(name, data, sizeof(T) * R * C);
+
+					if (location != -1)
+						GLUniformMatrixTraits<R, C>::set(location, 1, GL_FALSE, data);
+				}
+
+				GLint location_for(const char * name, const void * data, std::size_t size) {
+					return _program->update_uniform(_program->uniform_name(name), data, size);
+				}
+
+				GLint location_for(const UniformName & name, const void * data, std::size_t size) {
+					return _program->update_uniform(name, data, size);
 				}
 
 			public:
-				Binding(Program * program) : _program(program) {
+				Binding(Program * program) : _program(program), _current(true) {
 					_program->enable();
 				}
 
-				Binding(Binding && other) : _program(other._program) {
+				Binding(Binding && other) : _program(other._program), _current(other._current) {
 					other._program = NULL;
 				}
 
 				~Binding() {
-					if (_program)
+					if (_program && _current)
 						_program->disable();
 				}
 
 				template <typename LocationT>
 				void set_texture_unit(LocationT name, GLuint unit) {
-					glUniform1i(location_of(name), unit);
+					GLint value = unit;
+					GLint location = location_for(name, &value, sizeof(value));
+
+					if (location != -1)
+						glUniform1i(location, value);
+				}
+
+				template <typename LocationT>
+				void set_uniform(LocationT name, const GLfloat & value) {
+					GLint location = location_for(name, &value, sizeof(value));
+
+					if (location != -1)
+						glUniform1fv(location, 1, &value);
 				}
 
 				template <typename LocationT, dimension E, typename T>
 				void set_uniform(LocationT name, const Vector<E, T> & vector) {
-					GLUniformTraits<E>::set(location_of(name), 1, vector.data());
+					GLint location = location_for(name, vector.data(), sizeof(T) * E);
+
+					if (location != -1)
+						GLUniformTraits<E>::set(location, 1, vector.data());
 				}
 
 				template <typename LocationT, dimension E, typename T, dimension N>
 				void set_uniform(LocationT name, const Vector<E, T>(&vector)[N]) {
-					GLUniformTraits<E>::set(location_of(name), N, vector[0].data());
+					GLint location = location_for(name, vector[0].data(), sizeof(T) * E * N);
+
+					if (location != -1)
+						GLUniformTraits<E>::set(location, N, vector[0].data());
 				}
 
 				template <typename LocationT, dimension R, dimension C, typename T>
 				void set_uniform(LocationT name, const Matrix<R, C, T> & matrix, bool transpose = false) {
-					GLUniformMatrixTraits<R, C>::set(location_of(name), 1, transpose, matrix.data());
+					if (transpose) {
+						// The shadow copy must hold the value as the program sees it, so the matrix is transposed here rather than by the driver:
+						T transposed[R * C];
+
+						for (dimension row = 0; row < C; row += 1) {
+							for (dimension column = 0; column < R; column += 1)
+								transposed[column * C + row] = matrix.data()[row * R + column];
+						}
+
+						set_matrix<LocationT, R, C>(name, transposed);
+					} else {
+						set_matrix<LocationT, R, C>(name, matrix.data());
+					}
 				}
 			};
 
@@ -181,24 +358,74 @@ namespace Dream
 				return std::move(binding);
 			}
 
+			GLuint handle() const { return _handle; }
+
 			void property(GLenum name, GLint * value) {
 				glGetProgramiv(_handle, name, value);
 			}
 		};
 
 		/*
-		 Once the ShaderManager is deallocated, associated Program objects that are not linked will become invalid.
+		 Compiled shaders are shared by all programs which use the same source and type. Programs retain the shaders they attach until they have finished linking, after which the shader is deleted, unless another pending program still needs it.
 		 */
 		class ShaderManager : public Object
 		{
 		protected:
-			std::vector<GLenum> _shaders;
+			struct Shader {
+				GLuint handle;
+
+				// The number of programs which have attached the shader but not finished linking:
+				std::size_t references;
+			};
+
+			// Live shaders by a hash of their type and source:
+			std::map<HashT, Shader> _shaders;
+			std::map<GLuint, HashT> _hashes;
+
+			std::size_t _compile_count, _deduplicated_count;
+
+			static HashT source_hash(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths);
+
+			GLuint create(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths);
+			static bool compile_status(GLuint shader);
+
+			void erase(GLuint shader);
 
 		public:
 			ShaderManager();
 			~ShaderManager();
 
+			/// Keep a shared shader alive, e.g. while a program which it is attached to is linking. Shaders which are not shared are ignored.
+			void retain(GLuint shader);
+
+			/// Once no longer retained, a shared shader is deleted. Shaders which are not shared are ignored.
+			void release(GLuint shader);
+
+			/// The number of shaders which were actually compiled.
+			std::size_t compile_count() const { return _compile_count; }
+
+			/// The number of requests for shared shaders which were satisfied by an existing shader with the same source.
+			std::size_t deduplicated_count() const { return _deduplicated_count; }
+
+			/// The number of shared shader objects which currently exist.
+			std::size_t live_count() const { return _shaders.size(); }
+
+			/// Compile a shader which is owned by the caller, who is responsible for deleting it.
 			GLenum compile(GLenum type, const Buffer & buffer);
+
+			/// Start compiling a shader, owned by the caller, without checking the result, so that the driver can compile several shaders in parallel. Errors are reported when the program is linked.
+			GLenum submit(GLenum type, const Buffer & buffer);
+
+			/// Compile a shader from several strings, which are concatenated by the driver rather than copied beforehand.
+			GLenum compile(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths);
+			GLenum submit(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths);
+
+			/// Compile a shader which is owned by the manager and shared between all requests with the same source. It must be attached using `Program::attach(shader_manager, shader)`, which releases it once linking has finished.
+			GLenum compile_shared(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths);
+			GLenum submit_shared(GLenum type, GLsizei count, const GLchar * const * strings, const GLint * lengths);
+
+			/// Whether the driver supports GL_KHR_parallel_shader_compile, i.e. compile and link status can be polled without blocking.
+			static bool parallel_compile_supported();
 			
 			// Deprecated
 			GLenum compile(GLenum type, const Buffer * buffer) { return compile(type, *buffer); }
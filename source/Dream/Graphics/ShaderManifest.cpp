@@ -0,0 +1,122 @@
+//
+//  Graphics/ShaderManifest.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ShaderManifest.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		static void write_entry(std::ostream & output, const ShaderManifest::Entry & entry)
+		{
+			output << entry.path;
+
+			for (auto & pair : entry.defines)
+				output << '\t' << pair.first << '=' << pair.second;
+
+			output << std::endl;
+		}
+
+		ShaderManifest::ShaderManifest()
+		{
+		}
+
+		ShaderManifest::~ShaderManifest()
+		{
+		}
+
+		bool ShaderManifest::insert(const Entry & entry)
+		{
+			StringStreamT path_buffer;
+			path_buffer << entry.path;
+
+			if (!_keys.insert(std::make_pair(path_buffer.str(), ShaderVariantCache::canonical_defines(&entry.defines))).second)
+				return false;
+
+			_entries.push_back(entry);
+
+			return true;
+		}
+
+		bool ShaderManifest::add(const Path & path, const DefinesMapT * defines)
+		{
+			Entry entry{path, defines ? *defines : DefinesMapT()};
+
+			if (!insert(entry))
+				return false;
+
+			if (_recording.is_open())
+				write_entry(_recording, entry);
+
+			return true;
+		}
+
+		void ShaderManifest::parse(std::istream & input)
+		{
+			StringT line;
+			std::size_t number = 0;
+
+			while (std::getline(input, line)) {
+				number += 1;
+
+				if (!line.empty() && line.back() == '\r')
+					line.pop_back();
+
+				if (line.empty() || line[0] == '#')
+					continue;
+
+				std::size_t end = line.find('\t');
+				Path path(line.substr(0, end));
+				DefinesMapT defines;
+
+				while (end != StringT::npos) {
+					std::size_t begin = end + 1;
+					end = line.find('\t', begin);
+
+					StringT define = line.substr(begin, end == StringT::npos ? StringT::npos : end - begin);
+					std::size_t separator = define.find('=');
+
+					if (separator == StringT::npos) {
+						StringStreamT message;
+						message << "Invalid define on line " << number << " of shader manifest, expected NAME=VALUE.";
+
+						throw std::runtime_error(message.str());
+					}
+
+					defines[define.substr(0, separator)] = define.substr(separator + 1);
+				}
+
+				insert(Entry{path, defines});
+			}
+		}
+
+		void ShaderManifest::write(std::ostream & output) const
+		{
+			for (auto & entry : _entries)
+				write_entry(output, entry);
+		}
+
+		bool ShaderManifest::load(const StringT & path)
+		{
+			std::ifstream input(path);
+
+			if (!input.is_open())
+				return false;
+
+			parse(input);
+
+			return true;
+		}
+
+		void ShaderManifest::record(const StringT & path)
+		{
+			_recording.close();
+			_recording.open(path, std::ios::out | std::ios::app);
+
+			if (!_recording.is_open())
+				logger()->log(LOG_WARN, LogBuffer() << "Could not open shader manifest " << path << " for recording.");
+		}
+	}
+}
@@ -0,0 +1,69 @@
+//
+//  Graphics/ShaderManifest.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_SHADERMANIFEST_H
+#define _DREAM_CLIENT_GRAPHICS_SHADERMANIFEST_H
+
+#include "ShaderVariantCache.h"
+
+#include <fstream>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 A list of shader variants, i.e. a shader path and a set of defines, which can be compiled up front using ShaderWarmup.
+
+		 The manifest is stored as text, with one variant per line: the path, followed by tab separated NAME=VALUE defines. Blank lines and lines starting with '#' are ignored.
+
+		 A manifest can be recorded by assigning it to RendererState::shader_manifest, in which case every variant loaded is added to it. If a recording file is set, new variants are appended to it immediately, so nothing is lost if the application exits unexpectedly.
+		 */
+		class ShaderManifest : public Object {
+		public:
+			typedef ShaderParser::DefinesMapT DefinesMapT;
+
+			struct Entry {
+				Path path;
+				DefinesMapT defines;
+			};
+
+		protected:
+			std::vector<Entry> _entries;
+
+			// The path and canonical defines of every entry, so that variants are only listed once:
+			std::set<std::pair<StringT, StringT>> _keys;
+
+			std::ofstream _recording;
+
+			// Add the entry without recording it. Returns true if it was added:
+			bool insert(const Entry & entry);
+
+		public:
+			ShaderManifest();
+			virtual ~ShaderManifest();
+
+			/// Add the variant if it isn't already listed. Returns true if it was added.
+			bool add(const Path & path, const DefinesMapT * defines = nullptr);
+
+			/// Add all variants listed in the input, in the format described above. They are not recorded, as they are already listed elsewhere. Throws std::runtime_error if a line is malformed.
+			void parse(std::istream & input);
+
+			/// Write all variants in the format described above.
+			void write(std::ostream & output) const;
+
+			/// Parse the manifest file, if it exists. Returns false if it couldn't be opened.
+			bool load(const StringT & path);
+
+			/// Append new variants to the given file as they are added. Existing variants are not written.
+			void record(const StringT & path);
+
+			const std::vector<Entry> & entries() const { return _entries; }
+			std::size_t size() const { return _entries.size(); }
+		};
+	}
+}
+
+#endif
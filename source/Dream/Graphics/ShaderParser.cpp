@@ -8,92 +8,366 @@
 
 #include "ShaderParser.h"
 
+#include <algorithm>
+#include <cstring>
+
 namespace Dream
 {
 	namespace Graphics
 	{
-		ShaderParser::ShaderParser(const Buffer & buffer)
+		static const char * NEWLINE = "\n";
+
+		// Invoke the callback for each line in the buffer, including its trailing newline if present:
+		template <typename CallbackT>
+		static void each_line(const Buffer & buffer, CallbackT callback)
 		{
-			BufferStream input_stream(buffer);
+			const char * current = (const char *)buffer.begin();
+			const char * end = current + buffer.size();
+
+			while (current < end) {
+				const char * next = (const char *)std::memchr(current, '\n', end - current);
+				next = next ? next + 1 : end;
+
+				callback(ShaderParser::Slice{current, (std::size_t)(next - current)});
 
-			parse(input_stream);
+				current = next;
+			}
 		}
-		
-		void ShaderParser::parse_header(std::istream & input_stream)
+
+		bool ShaderParser::Slice::starts_with(const char * prefix) const
+		{
+			std::size_t length = std::strlen(prefix);
+
+			return size >= length && std::memcmp(data, prefix, length) == 0;
+		}
+
+		bool ShaderParser::parse_include(const Slice & line, std::string & path)
 		{
-			std::string line_buffer;
-			std::getline(input_stream, line_buffer);
+			if (!line.starts_with("@include"))
+				return false;
+
+			const char * begin = std::find(line.data, line.end(), '"');
+			const char * end = begin != line.end() ? std::find(begin + 1, line.end(), '"') : line.end();
+
+			if (end == line.end())
+				throw ParseError("Invalid include directive, expected @include \"path\".");
+
+			path.assign(begin + 1, end);
+
+			return true;
+		}
+
+		Shared<ShaderParser::Chunk> ShaderParser::ChunkCache::fetch(const std::string & path, const IncludeResolverT & resolver)
+		{
+			auto existing = _chunks.find(path);
+
+			if (existing != _chunks.end())
+				return existing->second;
+
+			Shared<Buffer> buffer = resolver ? resolver(path) : nullptr;
+
+			if (!buffer)
+				throw ParseError("Could not load included file " + path + ".");
+
+			Shared<Chunk> chunk = std::make_shared<Chunk>();
+			chunk->buffer = buffer;
+
+			std::string include_path;
+			std::size_t number = 0;
+
+			each_line(*buffer, [&](const Slice & line) {
+				number += 1;
+
+				if (parse_include(line, include_path)) {
+					chunk->lines.push_back({number, line, include_path});
+					chunk->includes.insert(include_path);
+				} else {
+					chunk->lines.push_back({number, line, std::string()});
+				}
+			});
+
+			_chunks[path] = chunk;
+
+			return chunk;
+		}
+
+		std::set<std::string> ShaderParser::ChunkCache::invalidate(const std::string & path)
+		{
+			std::set<std::string> removed{path};
+			_chunks.erase(path);
+
+			// Walk the dependency graph backwards until no more chunks include anything which was removed:
+			bool changed = true;
+			while (changed) {
+				changed = false;
+
+				for (auto iterator = _chunks.begin(); iterator != _chunks.end();) {
+					auto & includes = iterator->second->includes;
+
+					bool dependent = std::any_of(includes.begin(), includes.end(), [&](const std::string & include) {
+						return removed.count(include) != 0;
+					});
+
+					if (dependent) {
+						removed.insert(iterator->first);
+						iterator = _chunks.erase(iterator);
+						changed = true;
+					} else {
+						++iterator;
+					}
+				}
+			}
+
+			return removed;
+		}
+
+// MARK: -
+
+		void ShaderParser::Source::clear()
+		{
+			// Capacity is retained, so a reused instance doesn't allocate:
+			_strings.clear();
+			_lengths.clear();
+			_storage.clear();
+		}
+
+		void ShaderParser::Source::append(const char * data, std::size_t size)
+		{
+			_strings.push_back(data);
+			_lengths.push_back((GLint)size);
+		}
+
+		std::size_t ShaderParser::Source::size() const
+		{
+			std::size_t total = 0;
+
+			for (auto length : _lengths)
+				total += length;
+
+			return total;
+		}
+
+		void ShaderParser::Source::write(std::ostream & output) const
+		{
+			for (std::size_t i = 0; i < _strings.size(); i += 1)
+				output.write(_strings[i], _lengths[i]);
+		}
+
+// MARK: -
+
+		ShaderParser::ShaderParser(Shared<Buffer> buffer, IncludeResolverT include_resolver, Shared<ChunkCache> chunk_cache) : _include_resolver(include_resolver), _chunk_cache(chunk_cache)
+		{
+			// Even without a shared cache, a file included several times is only parsed once:
+			if (!_chunk_cache)
+				_chunk_cache = std::make_shared<ChunkCache>();
+
+			_files.push_back("");
+
+			parse(buffer);
+		}
 
-			if (line_buffer.find("@shader") != 0)
+		static Shared<Buffer> copy_buffer(const Buffer & buffer)
+		{
+			Shared<MutableBuffer> copy = PackedBuffer::new_buffer(buffer.size());
+
+			std::memcpy(copy->begin(), buffer.begin(), buffer.size());
+
+			return copy;
+		}
+
+		ShaderParser::ShaderParser(const Buffer & buffer, IncludeResolverT include_resolver, Shared<ChunkCache> chunk_cache) : ShaderParser(copy_buffer(buffer), include_resolver, chunk_cache)
+		{
+		}
+		
+		void ShaderParser::parse_header(const Slice & line)
+		{
+			if (!line.starts_with("@shader"))
 				throw ParseError("Invalid start sequence, missing @shader.");
 
+			_line = 1;
+
 			_header = set_current_source(SourceType::HEADER, false);
 		}
 
-		std::stringstream * ShaderParser::set_current_source(SourceType source_type, bool append_line_number)
+		ShaderParser::SlicesT * ShaderParser::set_current_source(SourceType source_type, bool append_line_number)
 		{
 			_current_source = &_source_buffers[source_type];
 
+			// The directive itself is on line _line, so the source which follows begins on the next line:
 			if (append_line_number)
-				(*_current_source) << "#line " << _line << std::endl;
+				append_generated("#line " + std::to_string(_line + 1) + " 0\n");
 
 			return _current_source;
 		}
 
-		void ShaderParser::append_line(const std::string & line)
+		void ShaderParser::append_line(const Slice & line)
+		{
+			if (!_current_source)
+				return;
+
+			SlicesT & slices = *_current_source;
+
+			// Consecutive lines from the same buffer are merged:
+			if (!slices.empty() && slices.back().end() == line.data)
+				slices.back().size += line.size;
+			else
+				slices.push_back(line);
+
+			// The last line of a file may not have a newline:
+			if (line.data[line.size - 1] != '\n')
+				slices.push_back(Slice{NEWLINE, 1});
+		}
+
+		void ShaderParser::append_generated(std::string && line)
+		{
+			if (!_current_source)
+				return;
+
+			_generated.push_back(std::move(line));
+			_current_source->push_back(Slice{_generated.back().data(), _generated.back().size()});
+		}
+
+		void ShaderParser::append_include(const std::string & path, std::size_t return_line, std::size_t return_file)
 		{
-			if (_current_source)
-				(*_current_source) << line << std::endl;
+			if (!_current_source)
+				return;
+
+			if (std::find(_include_stack.begin(), _include_stack.end(), path) != _include_stack.end())
+				throw ParseError("Recursive include of " + path + ".");
+
+			Shared<Chunk> chunk = _chunk_cache->fetch(path, _include_resolver);
+
+			// The chunk may be removed from the cache, but the slices must remain valid:
+			_chunks.push_back(chunk);
+			_dependencies.insert(path);
+
+			auto file = std::find(_files.begin(), _files.end(), path);
+			std::size_t file_index = file - _files.begin();
+
+			if (file == _files.end())
+				_files.push_back(path);
+
+			_include_stack.push_back(path);
+
+			append_generated("#line 1 " + std::to_string(file_index) + "\n");
+
+			for (auto & line : chunk->lines) {
+				if (!line.include.empty())
+					append_include(line.include, line.number + 1, file_index);
+				else
+					append_line(line.text);
+			}
+
+			_include_stack.pop_back();
+
+			append_generated("#line " + std::to_string(return_line) + " " + std::to_string(return_file) + "\n");
 		}
 
 		void ShaderParser::add_definitions(const DefinesMapT & defines)
 		{
+			SlicesT * current_source = _current_source;
+			_current_source = _header;
+
 			for (auto & pair : defines)
-				(*_header) << "#define " << pair.first << " " << pair.second << std::endl;
+				append_generated("#define " + pair.first + " " + pair.second + "\n");
+
+			_current_source = current_source;
 		}
 
-		//, const std::map<std::string, std::string> & definitions
-		void ShaderParser::parse(std::istream & input_stream)
+		void ShaderParser::parse(Shared<Buffer> buffer)
 		{
-			parse_header(input_stream);
-			
-			std::string line_buffer;
+			_buffer = buffer;
+
+			std::string include_path;
+			bool first = true;
 
-			while (input_stream.good()) {
-				// Read one line:
-				std::getline(input_stream, line_buffer);
+			each_line(*buffer, [&](const Slice & line) {
+				if (first) {
+					parse_header(line);
+					first = false;
+
+					return;
+				}
 
 				_line += 1;
 
-				if (line_buffer.find("@geometry") == 0) {
+				if (line.starts_with("@geometry")) {
 					set_current_source(SourceType::GEOMETRY);
-				} else if (line_buffer.find("@vertex") == 0) {
+				} else if (line.starts_with("@vertex")) {
 					set_current_source(SourceType::VERTEX);
-				} else if (line_buffer.find("@fragment") == 0) {
+				} else if (line.starts_with("@fragment")) {
 					set_current_source(SourceType::FRAGMENT);
+				} else if (parse_include(line, include_path)) {
+					append_include(include_path, _line + 1, 0);
 				} else {
-					append_line(line_buffer);
+					append_line(line);
 				}
-			}
+			});
+
+			if (first)
+				throw ParseError("Invalid start sequence, missing @shader.");
 		}
 
-		void ShaderParser::full_buffer(std::stringstream & buffer, SourceType source_type, const DefinesMapT * defines) const
+		void ShaderParser::assemble(Source & source, SourceType source_type, const DefinesMapT * defines) const
 		{
-			buffer << _header->str();
+			source.clear();
+
+			for (auto & slice : *_header)
+				source.append(slice.data, slice.size);
+
+			if (defines && !defines->empty()) {
+				std::size_t size = 0;
 
-			if (defines)
-			{
 				for (auto & pair : *defines)
-					buffer << "#define " << pair.first << " " << pair.second << std::endl;
+					size += pair.first.size() + pair.second.size() + 10;
+
+				// Allocate once, so the string doesn't move while being written:
+				source._storage.reserve(size);
+
+				for (auto & pair : *defines) {
+					source._storage += "#define ";
+					source._storage += pair.first;
+					source._storage += ' ';
+					source._storage += pair.second;
+					source._storage += '\n';
+				}
+
+				source.append(source._storage.data(), source._storage.size());
 			}
 
 			if (source_type != SourceType::HEADER)
 			{
 				auto source_buffer = _source_buffers.find(source_type);
 
-				if (source_buffer != _source_buffers.end())
-					buffer << source_buffer->second.str();
+				if (source_buffer != _source_buffers.end()) {
+					for (auto & slice : source_buffer->second)
+						source.append(slice.data, slice.size);
+				}
 			}
 		}
+
+		void ShaderParser::full_buffer(std::stringstream & buffer, SourceType source_type, const DefinesMapT * defines) const
+		{
+			Source source;
+			assemble(source, source_type, defines);
+
+			source.write(buffer);
+		}
+
+		HashT ShaderParser::hash(SourceType source_type, const DefinesMapT * defines) const
+		{
+			Hash hash;
+
+			Source source;
+			assemble(source, source_type, defines);
+
+			hash.append((HashT)source_type);
+
+			// Appending each string in turn is equivalent to hashing the concatenated source:
+			for (GLsizei i = 0; i < source.count(); i += 1)
+				hash.append(source.strings()[i], source.lengths()[i]);
+
+			return hash.value();
+		}
 	}
 }
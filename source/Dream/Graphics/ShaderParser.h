@@ -10,10 +10,15 @@
 #define DREAM_CLIENT_GRAPHICS_SHADERPARSER_H
 
 #include <map>
+#include <deque>
+#include <set>
+#include <vector>
+#include <functional>
 #include <sstream>
 #include <iosfwd>
 
 #include "Graphics.h"
+#include "Hash.h"
 
 namespace Dream
 {
@@ -22,7 +27,7 @@ namespace Dream
 		class ShaderParser
 		{
 		public:
-			class ParseError : std::runtime_error
+			class ParseError : public std::runtime_error
 			{
 			public:
 				ParseError(const std::string & what) : std::runtime_error(what) {}
@@ -34,36 +39,157 @@ namespace Dream
 			
 			typedef std::map<std::string, std::string> DefinesMapT;
 
+			// Load the contents of an included file, given the path from an `@include "path"` directive:
+			typedef std::function<Shared<Buffer> (const std::string & path)> IncludeResolverT;
+
+			// A range of characters within a buffer which is retained by the parser:
+			struct Slice {
+				const char * data;
+				std::size_t size;
+
+				const char * end() const { return data + size; }
+				bool starts_with(const char * prefix) const;
+			};
+
+			// Adjacent lines are merged into a single slice, so a stage is typically only a handful of slices:
+			typedef std::vector<Slice> SlicesT;
+
+			// An included file, parsed into lines of source code and nested include directives:
+			struct Chunk {
+				struct Line {
+					// The line number within the file, starting at 1:
+					std::size_t number;
+
+					// A line of source code, including the trailing newline:
+					Slice text;
+
+					// If not empty, the path of a nested include:
+					std::string include;
+				};
+
+				// The lines refer to this buffer:
+				Shared<Buffer> buffer;
+
+				std::vector<Line> lines;
+				std::set<std::string> includes;
+			};
+
+			// Included files are shared between parsers, so each one is only parsed once:
+			class ChunkCache
+			{
+			protected:
+				std::map<std::string, Shared<Chunk>> _chunks;
+
+			public:
+				// Parse the included file, or return the cached chunk:
+				Shared<Chunk> fetch(const std::string & path, const IncludeResolverT & resolver);
+
+				// Remove the chunk and any chunks which include it, directly or indirectly. Returns all the removed paths:
+				std::set<std::string> invalidate(const std::string & path);
+
+				std::size_t size() const { return _chunks.size(); }
+			};
+
+			// An assembled stage, which can be passed directly to glShaderSource as multiple strings. Most strings point into the parsed buffers. Generated code, such as defines, is written into a single preallocated buffer. Reusing the same instance avoids reallocation:
+			class Source
+			{
+			protected:
+				std::vector<const GLchar *> _strings;
+				std::vector<GLint> _lengths;
+				std::string _storage;
+
+				friend class ShaderParser;
+
+				void append(const char * data, std::size_t size);
+
+			public:
+				void clear();
+
+				GLsizei count() const { return (GLsizei)_strings.size(); }
+				const GLchar * const * strings() const { return _strings.data(); }
+				const GLint * lengths() const { return _lengths.data(); }
+
+				// The total length of all strings:
+				std::size_t size() const;
+
+				// Concatenate all strings, e.g. for logging:
+				void write(std::ostream & output) const;
+			};
+
+			// Parse a line which may be an include directive, returning the path if it is:
+			static bool parse_include(const Slice & line, std::string & path);
+
 		protected:
-			// All source code buffers currently encountered:
-			std::map<SourceType, std::stringstream> _source_buffers;
+			// The main buffer, and all included chunks, which the slices refer to:
+			Shared<Buffer> _buffer;
+			std::vector<Shared<Chunk>> _chunks;
+
+			// Generated lines, e.g. #line directives. A deque doesn't move existing elements, so slices into them remain valid:
+			std::deque<std::string> _generated;
+
+			// All source code slices currently encountered:
+			std::map<SourceType, SlicesT> _source_buffers;
 
 			// The currently selected source code buffer:
-			std::stringstream * _header;
-			std::stringstream * _current_source = nullptr;
+			SlicesT * _header = nullptr;
+			SlicesT * _current_source = nullptr;
 
 			std::size_t _line = 0;
 
-			std::stringstream * set_current_source(SourceType source_type, bool append_line_number = true);
-			void append_line(const std::string & line);
+			IncludeResolverT _include_resolver;
+			Shared<ChunkCache> _chunk_cache;
+
+			// The source string number for each file, as used in #line directives. The main file is 0:
+			std::vector<std::string> _files;
+			std::set<std::string> _dependencies;
+
+			// The chain of files currently being included, to detect cycles:
+			std::vector<std::string> _include_stack;
+
+			SlicesT * set_current_source(SourceType source_type, bool append_line_number = true);
+			void append_line(const Slice & line);
+			void append_generated(std::string && line);
+
+			// Append the contents of an included file to the current source buffer:
+			void append_include(const std::string & path, std::size_t return_line, std::size_t return_file);
 
 			// Parse the shader header token.
-			void parse_header(std::istream & input_stream);
+			void parse_header(const Slice & line);
+
+			// Parse shader source code.
+			void parse(Shared<Buffer> buffer);
 
 		public:
-			ShaderParser(const Buffer & buffer);
+			// The buffer is retained and parsed in place:
+			ShaderParser(Shared<Buffer> buffer, IncludeResolverT include_resolver = nullptr, Shared<ChunkCache> chunk_cache = nullptr);
+
+			// The buffer is copied once, as its lifetime is unknown:
+			ShaderParser(const Buffer & buffer, IncludeResolverT include_resolver = nullptr, Shared<ChunkCache> chunk_cache = nullptr);
+
+			// Slices refer to storage owned by the parser, so it can't be copied:
+			ShaderParser(const ShaderParser &) = delete;
+			ShaderParser & operator=(const ShaderParser &) = delete;
 			
 			// Add #define statements to the header.
 			void add_definitions(const DefinesMapT & defines);
 
-			// Parse shader source code.
-			void parse(std::istream & input_stream);
+			// Assemble the source strings for the corresponding source type with an optional map of defines as per `add_definitions`.
+			void assemble(Source & source, SourceType source_type, const DefinesMapT * defines = nullptr) const;
 
-			// Get a buffer for the corresponding source type with an optional map of defines as per `add_definitions`.
+			// Get a buffer for the corresponding source type. This copies the source, so prefer `assemble`.
 			void full_buffer(std::stringstream & buffer, SourceType source_type, const DefinesMapT * defines = nullptr) const;
 
-			// To get a full source buffer, you should call `full_buffer(pair.first)`.
-			const std::map<SourceType, std::stringstream> & source_buffers() const { return _source_buffers; }
+			// A hash of the full source for the given source type, e.g. for keying compile caches.
+			HashT hash(SourceType source_type, const DefinesMapT * defines = nullptr) const;
+
+			// To get the full source, you should call `assemble(source, pair.first)`.
+			const std::map<SourceType, SlicesT> & source_buffers() const { return _source_buffers; }
+
+			// The files referred to by #line directives, indexed by source string number. The main file is "".
+			const std::vector<std::string> & files() const { return _files; }
+
+			// All files included directly or indirectly.
+			const std::set<std::string> & dependencies() const { return _dependencies; }
 		};
 	}
 }
@@ -0,0 +1,156 @@
+//
+//  Graphics/ShaderReloader.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ShaderReloader.h"
+#include "Renderer.h"
+
+#include <algorithm>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		static StringT local_path(const Path & path)
+		{
+			StringStreamT buffer;
+			buffer << path;
+
+			return buffer.str();
+		}
+
+		ShaderReloader::ShaderReloader() : _chunk_cache(std::make_shared<ShaderParser::ChunkCache>()), _reloaded(0), _failed(0)
+		{
+		}
+
+		ShaderReloader::~ShaderReloader()
+		{
+		}
+
+		void ShaderReloader::watch_file(Ptr<ILoader> loader, const StringT & resource, const Path & shader)
+		{
+			StringT path = local_path(loader->path_for_resource(Path(resource)));
+
+			Watched & watched = _files[path];
+			watched.resource = resource;
+			watched.shaders.insert(shader);
+
+			_watcher.watch(path);
+		}
+
+		void ShaderReloader::watch(Ptr<ILoader> loader, const Path & path, Ptr<ShaderFactory> factory)
+		{
+			watch_file(loader, local_path(path), path);
+
+			for (auto & include : factory->dependencies())
+				watch_file(loader, include, path);
+		}
+
+		void ShaderReloader::reload(RendererState * state, const Path & path)
+		{
+			Ref<ShaderFactory> factory;
+
+			try {
+				Ref<IData> data = state->resource_loader->data_for_resource(path);
+
+				if (!data)
+					throw std::runtime_error("Could not load shader source!");
+
+				factory = new ShaderFactory(data, state->resource_loader.get(), _chunk_cache);
+			} catch (std::exception & error) {
+				logger()->log(LOG_ERROR, LogBuffer() << "Error reloading shader " << path << ": " << error.what());
+				_failed += 1;
+
+				return;
+			}
+
+			// New includes are watched too:
+			watch(state->resource_loader, path, factory);
+
+			state->shader_variants->replace_factory(path, factory);
+
+			for (auto & variant : state->shader_variants->variants(path)) {
+				Ref<Program> replacement = new Program;
+				replacement->bind_attribute_locations(*variant.program);
+
+				// Replacements are linked in the background and swapped in by `update` once they are ready:
+				try {
+#ifndef DREAM_OPENGLES2
+					if (variant.stage)
+						state->compile_stage_program(factory, (ShaderParser::SourceType)variant.stage, &variant.defines, false, replacement);
+					else
+#endif
+						state->compile_program(factory, &variant.defines, false, replacement);
+				} catch (std::exception & error) {
+					logger()->log(LOG_ERROR, LogBuffer() << "Error reloading shader " << path << ": " << error.what());
+					_failed += 1;
+
+					continue;
+				}
+
+				// If the file changed again before the previous rebuild finished, only the latest one is used:
+				_pending.erase(std::remove_if(_pending.begin(), _pending.end(), [&](const Pending & pending) {
+					return pending.program == variant.program;
+				}), _pending.end());
+
+				_pending.push_back({variant.program, replacement});
+			}
+		}
+
+		std::size_t ShaderReloader::update(RendererState * state)
+		{
+			std::set<Path> shaders;
+
+			for (auto & path : _watcher.poll()) {
+				auto iterator = _files.find(path);
+
+				if (iterator == _files.end())
+					continue;
+
+				Watched & watched = iterator->second;
+
+				// Files which include the changed file must also be parsed again:
+				_chunk_cache->invalidate(watched.resource);
+
+				shaders.insert(watched.shaders.begin(), watched.shaders.end());
+			}
+
+			for (auto & path : shaders) {
+				logger()->log(LOG_INFO, LogBuffer() << "Reloading shader " << path);
+
+				reload(state, path);
+			}
+
+			// Completion callbacks, e.g. storing the binary, must run before the programs are swapped:
+			state->poll_programs();
+
+			for (auto iterator = _pending.begin(); iterator != _pending.end();) {
+				Pending & pending = *iterator;
+
+				if (pending.replacement->link_state() == Program::LinkState::LINKING) {
+					++iterator;
+					continue;
+				}
+
+				if (pending.replacement->ready()) {
+					pending.program->replace(*pending.replacement);
+					_reloaded += 1;
+
+#ifndef DREAM_OPENGLES2
+					// Pipelines were assembled with the previous handle, so they are assembled again when next fetched:
+					if (state->program_pipelines)
+						state->program_pipelines->evict(pending.program);
+#endif
+				} else {
+					logger()->log(LOG_WARN, LogBuffer() << "Reloaded program failed to link, keeping program " << pending.program->handle());
+					_failed += 1;
+				}
+
+				iterator = _pending.erase(iterator);
+			}
+
+			return _pending.size();
+		}
+	}
+}
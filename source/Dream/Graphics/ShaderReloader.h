@@ -0,0 +1,72 @@
+//
+//  Graphics/ShaderReloader.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_SHADERRELOADER_H
+#define _DREAM_CLIENT_GRAPHICS_SHADERRELOADER_H
+
+#include "FileWatcher.h"
+#include "ShaderFactory.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		struct RendererState;
+
+		/**
+		 Watches shader sources and their includes, and rebuilds the affected variants when they change, so that shaders can be edited while the application is running.
+
+		 Only variants of shaders which depend on a changed file are rebuilt. They are compiled and linked in the background via the program queue, and each live program is replaced in place by `update`, which should be called at a frame boundary. If a shader fails to parse, compile or link, the previous program is kept.
+		 */
+		class ShaderReloader : public Object {
+		protected:
+			FileWatcher _watcher;
+
+			// Reloaded shaders share their includes, which are only parsed again when they change:
+			Shared<ShaderParser::ChunkCache> _chunk_cache;
+
+			// The resource path of each watched file, and the shaders which depend on it:
+			struct Watched {
+				StringT resource;
+				std::set<Path> shaders;
+			};
+
+			std::map<StringT, Watched> _files;
+
+			struct Pending {
+				Ref<Program> program;
+				Ref<Program> replacement;
+			};
+
+			std::vector<Pending> _pending;
+
+			std::size_t _reloaded, _failed;
+
+			void watch_file(Ptr<ILoader> loader, const StringT & resource, const Path & shader);
+
+			// Start rebuilding all live variants of the given shader:
+			void reload(RendererState * state, const Path & path);
+
+		public:
+			ShaderReloader();
+			virtual ~ShaderReloader();
+
+			/// Watch the shader source and all of its includes.
+			void watch(Ptr<ILoader> loader, const Path & path, Ptr<ShaderFactory> factory);
+
+			/// Start rebuilding shaders which changed on disk, and replace programs which have finished linking. Returns the number of programs still being rebuilt.
+			std::size_t update(RendererState * state);
+
+			/// Whether file changes are reported by the operating system rather than by polling.
+			bool notifications() const { return _watcher.notifications(); }
+
+			std::size_t pending_count() const { return _pending.size(); }
+			std::size_t reloaded_count() const { return _reloaded; }
+			std::size_t failed_count() const { return _failed; }
+		};
+	}
+}
+
+#endif
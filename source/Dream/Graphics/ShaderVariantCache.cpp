@@ -0,0 +1,136 @@
+//
+//  Graphics/ShaderVariantCache.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ShaderVariantCache.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		ShaderVariantCache::ShaderVariantCache()
+		{
+		}
+
+		ShaderVariantCache::~ShaderVariantCache()
+		{
+			// Programs may outlive the cache, e.g. when they are held by a renderer:
+			for (auto & pair : _keys)
+				pair.first->erase_finalizer(this);
+		}
+
+		StringT ShaderVariantCache::canonical_defines(const DefinesMapT * defines)
+		{
+			StringStreamT buffer;
+
+			// The map is ordered by name, so the result doesn't depend on insertion order:
+			if (defines) {
+				for (auto & pair : *defines)
+					buffer << pair.first << '=' << pair.second << '\n';
+			}
+
+			return buffer.str();
+		}
+
+		Ref<ShaderFactory> ShaderVariantCache::factory(Ptr<ILoader> loader, const Path & path)
+		{
+			auto iterator = _factories.find(path);
+
+			if (iterator != _factories.end())
+				return iterator->second;
+
+			Ref<ShaderFactory> factory = loader->load<ShaderFactory>(path);
+			_factories[path] = factory;
+
+			return factory;
+		}
+
+		void ShaderVariantCache::replace_factory(const Path & path, Ptr<ShaderFactory> factory)
+		{
+			auto iterator = _factories.find(path);
+
+			if (iterator != _factories.end())
+				iterator->second = factory;
+		}
+
+		Ptr<Program> ShaderVariantCache::lookup(const Path & path, const DefinesMapT * defines, GLenum stage)
+		{
+			auto iterator = _variants.find(KeyT(path, canonical_defines(defines), stage));
+
+			if (iterator == _variants.end())
+				return NULL;
+
+			// Programs which were linked asynchronously may only have failed since they were inserted:
+			if (iterator->second.program->link_state() == Program::LinkState::FAILED) {
+				erase(iterator);
+
+				return NULL;
+			}
+
+			return iterator->second.program;
+		}
+
+		void ShaderVariantCache::insert(const Path & path, const DefinesMapT * defines, Ptr<Program> program, GLenum stage)
+		{
+			if (program->link_state() == Program::LinkState::FAILED)
+				return;
+
+			KeyT key(path, canonical_defines(defines), stage);
+
+			// Replace any previous program for the same variant, which would otherwise still remove this entry when it is finalized:
+			auto existing = _variants.find(key);
+
+			if (existing != _variants.end())
+				erase(existing);
+
+			_variants[key] = Variant{program, defines ? *defines : DefinesMapT(), stage};
+			_keys[program.get()] = key;
+
+			program->insert_finalizer(this);
+		}
+
+		std::size_t ShaderVariantCache::variant_count(const Path & path) const
+		{
+			std::size_t count = 0;
+
+			for (auto & pair : _variants) {
+				if (std::get<0>(pair.first) == path)
+					count += 1;
+			}
+
+			return count;
+		}
+
+		std::vector<ShaderVariantCache::Variant> ShaderVariantCache::variants(const Path & path) const
+		{
+			std::vector<Variant> variants;
+
+			for (auto & pair : _variants) {
+				if (std::get<0>(pair.first) == path)
+					variants.push_back(pair.second);
+			}
+
+			return variants;
+		}
+
+		void ShaderVariantCache::erase(std::map<KeyT, Variant>::iterator iterator)
+		{
+			Program * program = iterator->second.program.get();
+
+			program->erase_finalizer(this);
+			_keys.erase(program);
+			_variants.erase(iterator);
+		}
+
+		void ShaderVariantCache::finalize(Object * object)
+		{
+			auto iterator = _keys.find(object);
+
+			if (iterator != _keys.end()) {
+				_variants.erase(iterator->second);
+				_keys.erase(iterator);
+			}
+		}
+	}
+}
@@ -0,0 +1,85 @@
+//
+//  Graphics/ShaderVariantCache.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_SHADERVARIANTCACHE_H
+#define _DREAM_CLIENT_GRAPHICS_SHADERVARIANTCACHE_H
+
+#include "ShaderFactory.h"
+
+#include <tuple>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 Maps a shader path and a set of defines to the program which was built from them, so that renderers asking for the same variant share a single program.
+
+		 Programs are not retained by the cache: they are removed automatically when they are finalized. Programs which failed to link are never returned, so that the variant is built again when it is next requested. Parsed shader factories are retained per path, so all variants of a shader share the same parse.
+		 */
+		class ShaderVariantCache : public Object, implements IFinalizer {
+		public:
+			typedef ShaderParser::DefinesMapT DefinesMapT;
+			// The path, the canonical defines and the stage for separable programs, or 0 for complete programs:
+			typedef std::tuple<Path, StringT, GLenum> KeyT;
+
+			struct Variant {
+				Ptr<Program> program;
+
+				// The defines are kept so that the variant can be rebuilt, e.g. when the shader is reloaded:
+				DefinesMapT defines;
+				GLenum stage;
+			};
+
+		protected:
+			std::map<Path, Ref<ShaderFactory>> _factories;
+
+			std::map<KeyT, Variant> _variants;
+
+			// Used to find the key of a program when it is finalized:
+			std::map<Object *, KeyT> _keys;
+
+			virtual void finalize(Object * object);
+
+			void erase(std::map<KeyT, Variant>::iterator iterator);
+
+		public:
+			ShaderVariantCache();
+			virtual ~ShaderVariantCache();
+
+			/// A canonical representation of the defines. No defines and an empty set of defines are equivalent.
+			static StringT canonical_defines(const DefinesMapT * defines);
+
+			/// Load the shader factory for the given path, parsing it only the first time it is requested.
+			Ref<ShaderFactory> factory(Ptr<ILoader> loader, const Path & path);
+
+			/// Replace the cached factory for the given path, if there is one, e.g. after the shader was reloaded.
+			void replace_factory(const Path & path, Ptr<ShaderFactory> factory);
+
+			/// Find a live program for the given variant, or NULL if there isn't one or it failed to link. Separable single stage programs are distinguished by their stage.
+			Ptr<Program> lookup(const Path & path, const DefinesMapT * defines, GLenum stage = 0);
+
+			/// Record the program for the given variant, unless it has already failed to link.
+			void insert(const Path & path, const DefinesMapT * defines, Ptr<Program> program, GLenum stage = 0);
+
+			/// The number of distinct live variants across all shaders.
+			std::size_t variant_count() const { return _variants.size(); }
+
+			/// The number of distinct live variants of the given shader.
+			std::size_t variant_count(const Path & path) const;
+
+			/// All live variants of the given shader.
+			std::vector<Variant> variants(const Path & path) const;
+
+			/// The number of parsed shader factories.
+			std::size_t factory_count() const { return _factories.size(); }
+
+			/// Release all parsed shader factories, e.g. after loading is complete. Live programs are unaffected.
+			void purge_factories() { _factories.clear(); }
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,79 @@
+//
+//  Graphics/ShaderWarmup.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "ShaderWarmup.h"
+#include "Renderer.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		ShaderWarmup::ShaderWarmup(Ptr<ShaderManifest> manifest, ProgressCallbackT progress, std::size_t batch_size) : _manifest(manifest), _progress(progress), _batch_size(batch_size), _next(0), _completed(0), _failed(0)
+		{
+		}
+
+		ShaderWarmup::~ShaderWarmup()
+		{
+		}
+
+		void ShaderWarmup::submit(RendererState * state, const ShaderManifest::Entry & entry)
+		{
+			try {
+				_programs.push_back(state->load_program_async(entry.path, &entry.defines));
+			} catch (std::exception & error) {
+				// A missing or broken shader shouldn't prevent the remaining variants from being loaded:
+				logger()->log(LOG_ERROR, LogBuffer() << "Error warming up shader " << entry.path << ": " << error.what());
+
+				_programs.push_back(nullptr);
+			}
+		}
+
+		bool ShaderWarmup::update(RendererState * state)
+		{
+			auto & entries = _manifest->entries();
+
+			for (std::size_t i = 0; i < _batch_size && _next < entries.size(); i += 1, _next += 1)
+				submit(state, entries[_next]);
+
+			state->poll_programs();
+
+			std::size_t completed = 0, failed = 0;
+
+			for (auto & program : _programs) {
+				if (!program) {
+					failed += 1;
+				} else if (program->link_state() == Program::LinkState::FAILED) {
+					failed += 1;
+				} else if (program->link_state() == Program::LinkState::LINKED) {
+					completed += 1;
+				}
+			}
+
+			completed += failed;
+
+			if (completed != _completed) {
+				_completed = completed;
+				_failed = failed;
+
+				if (_progress)
+					_progress(_completed, total());
+			}
+
+			return done();
+		}
+
+		void ShaderWarmup::finish(RendererState * state)
+		{
+			auto & entries = _manifest->entries();
+
+			for (; _next < entries.size(); _next += 1)
+				submit(state, entries[_next]);
+
+			state->program_queue->finish();
+
+			update(state);
+		}
+	}
+}
@@ -0,0 +1,63 @@
+//
+//  Graphics/ShaderWarmup.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_SHADERWARMUP_H
+#define _DREAM_CLIENT_GRAPHICS_SHADERWARMUP_H
+
+#include "ShaderManifest.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		struct RendererState;
+
+		/**
+		 Compiles and links all variants listed in a manifest during loading, so that they don't cause a hitch the first time they are drawn.
+
+		 Variants are loaded with RendererState::load_program_async, so they are linked in parallel where the driver supports it, stored in the program binary cache if there is one, and found by later calls to `load_program`. The programs are retained until the warm-up is released.
+		 */
+		class ShaderWarmup : public Object {
+		public:
+			/// Invoked whenever more variants have finished, e.g. to update a loading screen.
+			typedef std::function<void (std::size_t completed, std::size_t total)> ProgressCallbackT;
+
+		protected:
+			Ref<ShaderManifest> _manifest;
+			ProgressCallbackT _progress;
+
+			// The number of variants submitted per update, so that the loading screen keeps updating:
+			std::size_t _batch_size;
+
+			// The next entry to be submitted:
+			std::size_t _next;
+
+			std::vector<Ref<Program>> _programs;
+			std::size_t _completed, _failed;
+
+			void submit(RendererState * state, const ShaderManifest::Entry & entry);
+
+		public:
+			ShaderWarmup(Ptr<ShaderManifest> manifest, ProgressCallbackT progress = nullptr, std::size_t batch_size = 16);
+			virtual ~ShaderWarmup();
+
+			/// Submit the next batch of variants and check for completed ones. This never blocks if the driver supports parallel compilation. Returns true once all variants have finished.
+			bool update(RendererState * state);
+
+			/// Submit all remaining variants and wait for them to finish.
+			void finish(RendererState * state);
+
+			bool done() const { return _completed == total(); }
+
+			std::size_t total() const { return _manifest->size(); }
+			std::size_t completed() const { return _completed; }
+			std::size_t failed() const { return _failed; }
+
+			const std::vector<Ref<Program>> & programs() const { return _programs; }
+		};
+	}
+}
+
+#endif
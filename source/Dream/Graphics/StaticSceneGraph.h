@@ -0,0 +1,168 @@
+//
+//  Graphics/StaticSceneGraph.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_STATICSCENEGRAPH_H
+#define _DREAM_CLIENT_GRAPHICS_STATICSCENEGRAPH_H
+
+#include <Dream/Framework.h>
+
+#include <tuple>
+#include <vector>
+#include <type_traits>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		namespace Detail
+		{
+			// The index of T in the list of types, which must contain it:
+			template <typename T, typename... TypesT>
+			struct TypeIndex;
+
+			template <typename T, typename... TypesT>
+			struct TypeIndex<T, T, TypesT...> : std::integral_constant<std::size_t, 0> {};
+
+			template <typename T, typename U, typename... TypesT>
+			struct TypeIndex<T, U, TypesT...> : std::integral_constant<std::size_t, 1 + TypeIndex<T, TypesT...>::value> {};
+		}
+
+		/**
+		 A scene graph with a closed set of node types, as an alternative to INode and IRenderer when dynamic dispatch is too expensive.
+
+		 Nodes are stored by value, contiguously per type, and visited type by type in tight loops, so the visitor is resolved at compile time and can be inlined. Nodes of the same type are visited in the order they were added, but there is no ordering between types.
+
+		 	struct Sprite { ... };
+		 	struct Model { ... };
+
+		 	class SpriteRenderer : public StaticRenderer<SpriteRenderer> {
+		 	public:
+		 		void render(Sprite & sprite);
+		 		void render(Model & model);
+		 	};
+
+		 	StaticSceneGraph<Sprite, Model> graph;
+		 	graph.add(Sprite{...});
+		 	renderer.traverse(graph);
+		 */
+		template <typename... NodeTypesT>
+		class StaticSceneGraph {
+		public:
+			template <typename NodeT>
+			using IndexOf = Detail::TypeIndex<NodeT, NodeTypesT...>;
+
+			/// Refers to a node by its type and position, which is stable until the graph is cleared.
+			template <typename NodeT>
+			struct Handle {
+				std::size_t index;
+			};
+
+		protected:
+			std::tuple<std::vector<NodeTypesT>...> _nodes;
+
+			template <std::size_t I, typename VisitorT>
+			typename std::enable_if<I == sizeof...(NodeTypesT)>::type visit_from(VisitorT &) {
+			}
+
+			template <std::size_t I, typename VisitorT>
+			typename std::enable_if<I < sizeof...(NodeTypesT)>::type visit_from(VisitorT & visitor) {
+				for (auto & node : std::get<I>(_nodes))
+					visitor(node);
+
+				visit_from<I + 1>(visitor);
+			}
+
+			template <std::size_t I>
+			typename std::enable_if<I == sizeof...(NodeTypesT), std::size_t>::type size_from() const {
+				return 0;
+			}
+
+			template <std::size_t I>
+			typename std::enable_if<I < sizeof...(NodeTypesT), std::size_t>::type size_from() const {
+				return std::get<I>(_nodes).size() + size_from<I + 1>();
+			}
+
+			template <std::size_t I>
+			typename std::enable_if<I == sizeof...(NodeTypesT)>::type clear_from() {
+			}
+
+			template <std::size_t I>
+			typename std::enable_if<I < sizeof...(NodeTypesT)>::type clear_from() {
+				std::get<I>(_nodes).clear();
+
+				clear_from<I + 1>();
+			}
+
+		public:
+			template <typename NodeT>
+			Handle<NodeT> add(NodeT && node) {
+				typedef typename std::decay<NodeT>::type ValueT;
+				auto & nodes = this->nodes<ValueT>();
+
+				nodes.push_back(std::forward<NodeT>(node));
+
+				return Handle<ValueT>{nodes.size() - 1};
+			}
+
+			template <typename NodeT>
+			NodeT & operator[](Handle<NodeT> handle) {
+				return nodes<NodeT>()[handle.index];
+			}
+
+			/// All nodes of the given type, in the order they were added.
+			template <typename NodeT>
+			std::vector<NodeT> & nodes() {
+				return std::get<IndexOf<NodeT>::value>(_nodes);
+			}
+
+			template <typename NodeT>
+			const std::vector<NodeT> & nodes() const {
+				return std::get<IndexOf<NodeT>::value>(_nodes);
+			}
+
+			/// Reserve storage, e.g. before adding many nodes of the same type.
+			template <typename NodeT>
+			void reserve(std::size_t count) {
+				nodes<NodeT>().reserve(count);
+			}
+
+			/// Invoke visitor(node) for every node, one type at a time.
+			template <typename VisitorT>
+			void visit(VisitorT & visitor) {
+				visit_from<0>(visitor);
+			}
+
+			/// Invoke visitor(node) for every node of the given type.
+			template <typename NodeT, typename VisitorT>
+			void visit(VisitorT & visitor) {
+				for (auto & node : nodes<NodeT>())
+					visitor(node);
+			}
+
+			std::size_t size() const { return size_from<0>(); }
+
+			void clear() { clear_from<0>(); }
+		};
+
+		/**
+		 The statically dispatched equivalent of IRenderer. The derived class implements `render` for every node type in the graph; a missing overload is a compile time error.
+		 */
+		template <typename DerivedT>
+		class StaticRenderer {
+		public:
+			template <typename NodeT>
+			void operator()(NodeT & node) {
+				static_cast<DerivedT *>(this)->render(node);
+			}
+
+			template <typename... NodeTypesT>
+			void traverse(StaticSceneGraph<NodeTypesT...> & graph) {
+				graph.visit(*this);
+			}
+		};
+	}
+}
+
+#endif
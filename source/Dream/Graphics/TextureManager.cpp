@@ -7,6 +7,8 @@
 //
 
 #include "TextureManager.h"
+#include "Trace.h"
+#include "FrameStats.h"
 
 #include <Euclid/Numerics/Numerics.h>
 
@@ -291,6 +293,9 @@ namespace Dream
 				throw std::runtime_error("Invalid texture target");
 			}
 
+			if (pixels)
+				FrameStats::count(FrameStats::TEXTURE_BYTES, (std::uint64_t)size[WIDTH] * std::max(size[HEIGHT], 1u) * std::max(size[DEPTH], 1u) * pixel_size(format, data_type));
+
 			// Update the client-side texture details:
 			_size = size;
 			_format = format;
@@ -300,7 +305,7 @@ namespace Dream
 				glGenerateMipmap(target);
 			}
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void TextureManager::Binding::resize(const Vec3u & size, GLenum format, GLenum data_type) {
@@ -350,6 +355,8 @@ namespace Dream
 		}
 
 		Ref<Texture> TextureManager::allocate(const TextureParameters & parameters, Ptr<IPixelBuffer> pixel_buffer) {
+			DREAM_TRACE_ZONE("TextureManager::allocate");
+
 			const std::size_t HANDLE_POOL_REFILL_SIZE = 64;
 
 			if (_handles.size() == 0) {
@@ -359,13 +366,13 @@ namespace Dream
 				_handles.resize(64);
 				glGenTextures(64, _handles.data());
 
-				check_graphics_error();
+				DREAM_CHECK_GRAPHICS_ERROR();
 			}
 
 			Ref<Texture> texture = new Texture(parameters, _handles.back());
 			_handles.pop_back();
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 
 			if (pixel_buffer) {
 				auto & binding = this->bind(texture);
@@ -376,6 +383,8 @@ namespace Dream
 		}
 
 		void TextureManager::bind(std::size_t unit, Ptr<Texture> texture) {
+			DREAM_TRACE_ZONE("TextureManager::bind");
+
 			DREAM_ASSERT(unit < _image_unit_count);
 
 			if (_state[unit] == texture)
@@ -386,7 +395,9 @@ namespace Dream
 			glActiveTexture(GL_TEXTURE0 + unit);
 			glBindTexture(target, texture->handle());
 
-			check_graphics_error();
+			FrameStats::count(FrameStats::TEXTURE_BINDS);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
 
 			_state[unit] = texture;
 
@@ -410,7 +421,7 @@ namespace Dream
 
 #endif
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void TextureManager::bind(const TextureBindingsT & bindings) {
@@ -0,0 +1,196 @@
+//
+//  Graphics/Trace.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "Trace.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		Trace::Ring::Ring(std::size_t capacity, std::size_t thread) : _head(0), _tail(0), _dropped(0), _thread(thread)
+		{
+			std::size_t size = 1;
+			while (size < capacity)
+				size <<= 1;
+
+			_events.resize(size);
+			_mask = size - 1;
+		}
+
+		bool Trace::Ring::push(const Event & event)
+		{
+			std::size_t head = _head.load(std::memory_order_relaxed);
+
+			if (head - _tail.load(std::memory_order_acquire) > _mask) {
+				_dropped.fetch_add(1, std::memory_order_relaxed);
+
+				return false;
+			}
+
+			_events[head & _mask] = event;
+			_head.store(head + 1, std::memory_order_release);
+
+			return true;
+		}
+
+		std::size_t Trace::Ring::drain(std::vector<Event> & events)
+		{
+			std::size_t tail = _tail.load(std::memory_order_relaxed);
+			std::size_t head = _head.load(std::memory_order_acquire);
+
+			for (std::size_t i = tail; i != head; i += 1)
+				events.push_back(_events[i & _mask]);
+
+			_tail.store(head, std::memory_order_release);
+
+			return head - tail;
+		}
+
+// MARK: -
+
+		namespace
+		{
+			struct Registry {
+				std::mutex mutex;
+
+				// Rings are kept after their thread exits, so that its events can still be written:
+				std::vector<std::shared_ptr<Trace::Ring>> rings;
+
+				// Rings whose thread has exited, which can be used by the next thread:
+				std::vector<Trace::Ring *> retired;
+
+				std::size_t ring_capacity = 1 << 14;
+			};
+
+			Registry & registry()
+			{
+				static Registry registry;
+
+				return registry;
+			}
+		}
+
+		std::atomic<bool> Trace::_enabled(false);
+
+		namespace
+		{
+			// Retires the ring of the calling thread when the thread exits:
+			struct RingOwner {
+				Trace::Ring * ring = nullptr;
+
+				~RingOwner() {
+					if (ring) {
+						Registry & registry = Graphics::registry();
+						std::lock_guard<std::mutex> lock(registry.mutex);
+
+						registry.retired.push_back(ring);
+					}
+				}
+			};
+		}
+
+		static thread_local RingOwner _current_ring;
+
+		std::uint64_t Trace::now()
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+
+		void Trace::set_enabled(bool enabled)
+		{
+			_enabled.store(enabled, std::memory_order_relaxed);
+		}
+
+		void Trace::set_ring_capacity(std::size_t capacity)
+		{
+			Registry & registry = Graphics::registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			registry.ring_capacity = capacity;
+		}
+
+		Trace::Ring * Trace::ring()
+		{
+			if (!_current_ring.ring) {
+				Registry & registry = Graphics::registry();
+				std::lock_guard<std::mutex> lock(registry.mutex);
+
+				// The lock orders the previous thread's writes before ours, so the ring still has a single producer:
+				if (!registry.retired.empty()) {
+					_current_ring.ring = registry.retired.back();
+					registry.retired.pop_back();
+				} else {
+					auto ring = std::make_shared<Ring>(registry.ring_capacity, registry.rings.size() + 1);
+					registry.rings.push_back(ring);
+
+					_current_ring.ring = ring.get();
+				}
+			}
+
+			return _current_ring.ring;
+		}
+
+		std::size_t Trace::ring_count()
+		{
+			Registry & registry = Graphics::registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			return registry.rings.size();
+		}
+
+		void Trace::record(const char * name, std::uint64_t begin, std::uint64_t end)
+		{
+			ring()->push(Event{name, begin, end});
+		}
+
+		std::size_t Trace::dropped()
+		{
+			Registry & registry = Graphics::registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			std::size_t total = 0;
+			for (auto & ring : registry.rings)
+				total += ring->dropped();
+
+			return total;
+		}
+
+		void Trace::write(std::ostream & output)
+		{
+			Registry & registry = Graphics::registry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+
+			auto flags = output.flags();
+			auto precision = output.precision();
+
+			output << std::fixed << std::setprecision(3);
+			output << "{\"traceEvents\":[";
+
+			bool first = true;
+			std::vector<Event> events;
+
+			for (auto & ring : registry.rings) {
+				events.clear();
+				ring->drain(events);
+
+				for (auto & event : events) {
+					output << (first ? "\n" : ",\n");
+					first = false;
+
+					// Complete events, with times in microseconds. Thread 1 is left for the GPU timeline of GPUProfiler:
+					output << "{\"name\":\"" << event.name << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << (ring->thread() + 1) << ",\"ts\":" << (event.begin / 1000.0) << ",\"dur\":" << ((event.end - event.begin) / 1000.0) << "}";
+				}
+			}
+
+			output << "\n]}\n";
+
+			output.flags(flags);
+			output.precision(precision);
+		}
+	}
+}
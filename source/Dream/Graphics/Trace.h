@@ -0,0 +1,125 @@
+//
+//  Graphics/Trace.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_TRACE_H
+#define _DREAM_CLIENT_GRAPHICS_TRACE_H
+
+#include <Dream/Framework.h>
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 Low overhead CPU tracing. Each thread writes completed zones into its own fixed size ring, without locks, and the rings are drained when the trace is written:
+
+		 	void ParticleRenderer::update_for_duration(...) {
+		 		DREAM_TRACE_ZONE("ParticleRenderer::update_for_duration");
+		 		// ...
+		 	}
+
+		 	Trace::set_enabled(true);
+		 	// Run some frames...
+		 	Trace::write(output);
+
+		 `DREAM_TRACE_ZONE` expands to nothing unless the library is compiled with `DREAM_TRACE` defined, so release builds don't pay for it. If a ring fills up before it is drained, new zones are dropped and counted.
+
+		 When a thread exits, its ring is handed to the next thread which records a zone, along with any events which haven't been drained yet. Threads which are started every frame therefore share a fixed number of rings, and appear on the same timeline rows.
+		 */
+		class Trace {
+		public:
+			struct Event {
+				const char * name;
+
+				// In nanoseconds, from a steady clock:
+				std::uint64_t begin, end;
+			};
+
+			/// A single producer, single consumer ring of events.
+			class Ring : private NonCopyable {
+			protected:
+				std::vector<Event> _events;
+				std::size_t _mask;
+
+				std::atomic<std::size_t> _head, _tail;
+				std::atomic<std::size_t> _dropped;
+
+				std::size_t _thread;
+
+			public:
+				/// The capacity is rounded up to a power of two.
+				Ring(std::size_t capacity, std::size_t thread);
+
+				/// The timeline row of the ring, which is shared by all threads that have used it.
+				std::size_t thread() const { return _thread; }
+
+				/// Called by the owning thread only.
+				bool push(const Event & event);
+
+				/// Called by the consumer only. Appends all available events and returns the number appended.
+				std::size_t drain(std::vector<Event> & events);
+
+				std::size_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+			};
+
+			static std::uint64_t now();
+
+			static void set_enabled(bool enabled);
+			static bool enabled() { return _enabled.load(std::memory_order_relaxed); }
+
+			/// The capacity of rings created after this is called, in events.
+			static void set_ring_capacity(std::size_t capacity);
+
+			/// The ring of the calling thread, which is taken from an exited thread or created on first use.
+			static Ring * ring();
+
+			/// The number of rings which have been created, i.e. the largest number of threads which have recorded zones at the same time.
+			static std::size_t ring_count();
+
+			static void record(const char * name, std::uint64_t begin, std::uint64_t end);
+
+			/// Drain all rings and write the events in the Chrome trace event format, which can be opened in chrome://tracing or Perfetto.
+			static void write(std::ostream & output);
+
+			/// The total number of events dropped because rings were full.
+			static std::size_t dropped();
+
+			class Zone : private NonCopyable {
+			protected:
+				const char * _name;
+				std::uint64_t _begin;
+
+			public:
+				Zone(const char * name) : _name(name), _begin(enabled() ? now() : 0) {
+				}
+
+				~Zone() {
+					if (_begin)
+						record(_name, _begin, now());
+				}
+			};
+
+		protected:
+			static std::atomic<bool> _enabled;
+		};
+
+#ifdef DREAM_TRACE
+		#define DREAM_TRACE_ZONE_NAME2(line) _dream_trace_zone_ ## line
+		#define DREAM_TRACE_ZONE_NAME(line) DREAM_TRACE_ZONE_NAME2(line)
+		#define DREAM_TRACE_ZONE(name) Dream::Graphics::Trace::Zone DREAM_TRACE_ZONE_NAME(__LINE__)(name)
+#else
+		#define DREAM_TRACE_ZONE(name)
+#endif
+	}
+}
+
+#endif
@@ -0,0 +1,56 @@
+//
+//  Graphics/TransformFeedback.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "TransformFeedback.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		TransformFeedback::TransformFeedback() {
+			glGenTransformFeedbacks(1, &_handle);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		TransformFeedback::~TransformFeedback() {
+			glDeleteTransformFeedbacks(1, &_handle);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void TransformFeedback::bind() {
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, _handle);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void TransformFeedback::unbind() {
+			glBindTransformFeedback(GL_TRANSFORM_FEEDBACK, 0);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void TransformFeedback::attach(GLuint index, BufferHandle<GL_ARRAY_BUFFER> & buffer) {
+			glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, index, buffer.handle());
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void TransformFeedback::begin(GLenum primitive_mode) {
+			glBeginTransformFeedback(primitive_mode);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		void TransformFeedback::end() {
+			glEndTransformFeedback();
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+#endif
+	}
+}
@@ -0,0 +1,41 @@
+//
+//  Graphics/TransformFeedback.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_TRANSFORMFEEDBACK_H
+#define _DREAM_CLIENT_GRAPHICS_TRANSFORMFEEDBACK_H
+
+#include "Buffer.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		/// A transform feedback object captures the output of the vertex processing stages into one or more buffers. It also remembers how many primitives were written, so the captured data can be drawn with VertexArray::Binding::draw_transform_feedback without a round trip to the CPU.
+		class TransformFeedback : private NonCopyable {
+		protected:
+			GLuint _handle;
+
+		public:
+			TransformFeedback();
+			~TransformFeedback();
+
+			GLuint handle() const { return _handle; }
+
+			void bind();
+			void unbind();
+
+			/// Attach the given buffer as the capture destination for the given output index. The transform feedback object must be bound.
+			void attach(GLuint index, BufferHandle<GL_ARRAY_BUFFER> & buffer);
+
+			/// Begin capturing primitives of the given type, which must match the output of the last vertex processing stage.
+			void begin(GLenum primitive_mode);
+			void end();
+		};
+#endif
+	}
+}
+
+#endif
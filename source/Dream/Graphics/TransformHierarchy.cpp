@@ -0,0 +1,377 @@
+//
+//  Graphics/TransformHierarchy.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE__) || defined(_M_X64)
+	#include <xmmintrin.h>
+	#define DREAM_TRANSFORM_SSE
+#endif
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		enum DirtyFlags : std::uint8_t {
+			// The local transform changed, so the local matrix must be recomputed:
+			DIRTY_LOCAL = 1,
+			// The world matrix must be recomputed:
+			DIRTY_WORLD = 2,
+			// The node was destroyed, and will be dropped by the next compaction:
+			REMOVED = 4,
+		};
+
+		TransformHierarchy::Local::Local() : translation(0, 0, 0), rotation(0, 0, 0, 1), scale(1, 1, 1)
+		{
+		}
+
+		TransformHierarchy::Local::Local(const Vec3 & translation_, const Vec4 & rotation_, const Vec3 & scale_) : translation(translation_), rotation(rotation_), scale(scale_)
+		{
+		}
+
+		void TransformHierarchy::multiply(Mat44 & result, const Mat44 & left, const Mat44 & right)
+		{
+			const float * a = left.data();
+			const float * b = right.data();
+
+#ifdef DREAM_TRANSFORM_SSE
+			__m128 a0 = _mm_loadu_ps(a), a1 = _mm_loadu_ps(a + 4), a2 = _mm_loadu_ps(a + 8), a3 = _mm_loadu_ps(a + 12);
+			__m128 columns[4];
+
+			// Each column of the result is a linear combination of the columns of the left matrix:
+			for (std::size_t j = 0; j < 4; j += 1) {
+				const float * column = b + j * 4;
+
+				__m128 c = _mm_mul_ps(a0, _mm_set1_ps(column[0]));
+				c = _mm_add_ps(c, _mm_mul_ps(a1, _mm_set1_ps(column[1])));
+				c = _mm_add_ps(c, _mm_mul_ps(a2, _mm_set1_ps(column[2])));
+				c = _mm_add_ps(c, _mm_mul_ps(a3, _mm_set1_ps(column[3])));
+
+				columns[j] = c;
+			}
+
+			float * r = result.data();
+			for (std::size_t j = 0; j < 4; j += 1)
+				_mm_storeu_ps(r + j * 4, columns[j]);
+#else
+			float c[16];
+
+			for (std::size_t j = 0; j < 4; j += 1) {
+				for (std::size_t i = 0; i < 4; i += 1) {
+					c[j * 4 + i] = a[i] * b[j * 4] + a[4 + i] * b[j * 4 + 1] + a[8 + i] * b[j * 4 + 2] + a[12 + i] * b[j * 4 + 3];
+				}
+			}
+
+			std::memcpy(result.data(), c, sizeof(c));
+#endif
+		}
+
+		void TransformHierarchy::compose(Mat44 & result, const Local & local)
+		{
+			float x = local.rotation[0], y = local.rotation[1], z = local.rotation[2], w = local.rotation[3];
+			float sx = local.scale[0], sy = local.scale[1], sz = local.scale[2];
+
+			float * m = result.data();
+
+			// The rotation matrix, with each column scaled:
+			m[0] = (1 - 2 * (y * y + z * z)) * sx;
+			m[1] = (2 * (x * y + z * w)) * sx;
+			m[2] = (2 * (x * z - y * w)) * sx;
+			m[3] = 0;
+
+			m[4] = (2 * (x * y - z * w)) * sy;
+			m[5] = (1 - 2 * (x * x + z * z)) * sy;
+			m[6] = (2 * (y * z + x * w)) * sy;
+			m[7] = 0;
+
+			m[8] = (2 * (x * z + y * w)) * sz;
+			m[9] = (2 * (y * z - x * w)) * sz;
+			m[10] = (1 - 2 * (x * x + y * y)) * sz;
+			m[11] = 0;
+
+			m[12] = local.translation[0];
+			m[13] = local.translation[1];
+			m[14] = local.translation[2];
+			m[15] = 1;
+		}
+
+// MARK: -
+
+		const TransformHierarchy::HandleT TransformHierarchy::NONE;
+
+		TransformHierarchy::TransformHierarchy()
+		{
+		}
+
+		TransformHierarchy::~TransformHierarchy()
+		{
+		}
+
+		TransformHierarchy::HandleT TransformHierarchy::create(HandleT parent, const Local & local)
+		{
+			HandleT handle;
+
+			if (!_free_handles.empty()) {
+				handle = _free_handles.back();
+				_free_handles.pop_back();
+			} else {
+				handle = (HandleT)_positions.size();
+				_positions.push_back(NONE);
+			}
+
+			// Appending keeps the order valid, as the parent already exists:
+			_positions[handle] = (std::uint32_t)_handles.size();
+
+			_parents.push_back(parent == NONE ? NONE : _positions[parent]);
+			_handles.push_back(handle);
+			_locals.push_back(local);
+			_local_matrices.push_back(Mat44());
+			_world_matrices.push_back(Mat44());
+			_dirty.push_back(DIRTY_LOCAL | DIRTY_WORLD);
+
+			return handle;
+		}
+
+		void TransformHierarchy::destroy(HandleT handle)
+		{
+			if (!exists(handle))
+				return;
+
+			if (_unsorted)
+				sort();
+
+			std::size_t count = _handles.size();
+			std::uint32_t position = _positions[handle];
+
+			std::vector<std::uint8_t> removed(count, 0);
+			removed[position] = 1;
+
+			// Descendants always come after their ancestors:
+			for (std::size_t i = position; i < count; i += 1) {
+				if (i != position && (_parents[i] == NONE || !removed[_parents[i]]))
+					continue;
+
+				removed[i] = 1;
+
+				// Descendants of a node which was removed earlier are still attached to it:
+				if (_dirty[i] & REMOVED)
+					continue;
+
+				_dirty[i] |= REMOVED;
+				_positions[_handles[i]] = NONE;
+				_removed_count += 1;
+			}
+		}
+
+		void TransformHierarchy::remove(HandleT handle)
+		{
+			if (!exists(handle))
+				return;
+
+			std::uint32_t position = _positions[handle];
+
+			// The children are attached to the grandparent by the next compaction:
+			_dirty[position] |= REMOVED;
+			_positions[handle] = NONE;
+			_removed_count += 1;
+		}
+
+		void TransformHierarchy::compact()
+		{
+			std::size_t count = _handles.size();
+
+			// Attach the children of removed nodes to their nearest remaining ancestor. Parents come first, so they have already been resolved:
+			for (std::size_t i = 0; i < count; i += 1) {
+				std::uint32_t parent = _parents[i];
+
+				if (parent != NONE && (_dirty[parent] & REMOVED)) {
+					_parents[i] = _parents[parent];
+					_dirty[i] |= DIRTY_WORLD;
+				}
+			}
+
+			// Compact the arrays, preserving the order and remapping the parents:
+			std::vector<std::uint32_t> remap(count, NONE);
+			std::size_t next = 0;
+
+			for (std::size_t i = 0; i < count; i += 1) {
+				if (_dirty[i] & REMOVED) {
+					// The handle was already unmapped when the node was removed:
+					_free_handles.push_back(_handles[i]);
+
+					continue;
+				}
+
+				remap[i] = (std::uint32_t)next;
+
+				_parents[next] = _parents[i] == NONE ? NONE : remap[_parents[i]];
+				_handles[next] = _handles[i];
+				_locals[next] = _locals[i];
+				_local_matrices[next] = _local_matrices[i];
+				_world_matrices[next] = _world_matrices[i];
+				_dirty[next] = _dirty[i];
+
+				_positions[_handles[next]] = (std::uint32_t)next;
+
+				next += 1;
+			}
+
+			_parents.resize(next);
+			_handles.resize(next);
+			_locals.resize(next);
+			_local_matrices.resize(next);
+			_world_matrices.resize(next);
+			_dirty.resize(next);
+
+			_removed_count = 0;
+		}
+
+		void TransformHierarchy::set_parent(HandleT handle, HandleT parent)
+		{
+			std::uint32_t position = _positions[handle];
+
+			_parents[position] = parent == NONE ? NONE : _positions[parent];
+			_dirty[position] |= DIRTY_WORLD;
+
+			// The parent may now come after the child:
+			if (parent != NONE && _positions[parent] > position)
+				_unsorted = true;
+		}
+
+		TransformHierarchy::HandleT TransformHierarchy::parent(HandleT handle) const
+		{
+			std::uint32_t parent = _parents[_positions[handle]];
+
+			// Skip over removed nodes which haven't been compacted yet:
+			while (parent != NONE && (_dirty[parent] & REMOVED))
+				parent = _parents[parent];
+
+			return parent == NONE ? NONE : _handles[parent];
+		}
+
+		void TransformHierarchy::set_local(HandleT handle, const Local & local)
+		{
+			std::uint32_t position = _positions[handle];
+
+			_locals[position] = local;
+			_dirty[position] |= DIRTY_LOCAL | DIRTY_WORLD;
+		}
+
+		void TransformHierarchy::sort()
+		{
+			std::size_t count = _handles.size();
+
+			// Build the list of children for each node, then emit nodes breadth first from the roots:
+			std::vector<std::uint32_t> first_child(count, NONE), next_sibling(count, NONE);
+			std::vector<std::uint32_t> order;
+			order.reserve(count);
+
+			for (std::size_t i = count; i-- > 0;) {
+				if (_parents[i] == NONE) {
+					order.push_back((std::uint32_t)i);
+				} else {
+					next_sibling[i] = first_child[_parents[i]];
+					first_child[_parents[i]] = (std::uint32_t)i;
+				}
+			}
+
+			std::reverse(order.begin(), order.end());
+
+			for (std::size_t i = 0; i < order.size(); i += 1) {
+				for (std::uint32_t child = first_child[order[i]]; child != NONE; child = next_sibling[child])
+					order.push_back(child);
+			}
+
+			DREAM_ASSERT(order.size() == count && "Transform hierarchy contains a cycle!");
+
+			std::vector<std::uint32_t> remap(count);
+			for (std::size_t i = 0; i < count; i += 1)
+				remap[order[i]] = (std::uint32_t)i;
+
+			std::vector<std::uint32_t> parents(count);
+			std::vector<HandleT> handles(count);
+			std::vector<Local> locals(count);
+			std::vector<Mat44> local_matrices(count), world_matrices(count);
+			std::vector<std::uint8_t> dirty(count);
+
+			for (std::size_t i = 0; i < count; i += 1) {
+				std::uint32_t previous = order[i];
+
+				parents[i] = _parents[previous] == NONE ? NONE : remap[_parents[previous]];
+				handles[i] = _handles[previous];
+				locals[i] = _locals[previous];
+				local_matrices[i] = _local_matrices[previous];
+				world_matrices[i] = _world_matrices[previous];
+				dirty[i] = _dirty[previous];
+
+				_positions[handles[i]] = (std::uint32_t)i;
+			}
+
+			_parents.swap(parents);
+			_handles.swap(handles);
+			_locals.swap(locals);
+			_local_matrices.swap(local_matrices);
+			_world_matrices.swap(world_matrices);
+			_dirty.swap(dirty);
+
+			_unsorted = false;
+		}
+
+		void TransformHierarchy::update()
+		{
+			if (_unsorted)
+				sort();
+
+			if (_removed_count)
+				compact();
+
+			std::size_t count = _handles.size();
+			_updates.clear();
+
+			// Propagate changes to descendants. Parents come first, so they have already been marked:
+			for (std::size_t i = 0; i < count; i += 1) {
+				if (_parents[i] != NONE && (_dirty[_parents[i]] & DIRTY_WORLD))
+					_dirty[i] |= DIRTY_WORLD;
+
+				if (_dirty[i])
+					_updates.push_back((std::uint32_t)i);
+			}
+
+			// Local matrices first, then world matrices, so that each loop does one kind of work:
+			for (auto i : _updates) {
+				if (_dirty[i] & DIRTY_LOCAL)
+					compose(_local_matrices[i], _locals[i]);
+			}
+
+			for (auto i : _updates) {
+				if (_parents[i] == NONE)
+					_world_matrices[i] = _local_matrices[i];
+				else
+					multiply(_world_matrices[i], _world_matrices[_parents[i]], _local_matrices[i]);
+			}
+
+			for (auto i : _updates)
+				_dirty[i] = 0;
+
+			_updated_count = _updates.size();
+		}
+
+// MARK: -
+
+		TransformNode::TransformNode(Ptr<TransformHierarchy> hierarchy, TransformHierarchy::HandleT parent) : _hierarchy(hierarchy)
+		{
+			_transform = _hierarchy->create(parent);
+		}
+
+		TransformNode::~TransformNode()
+		{
+			// Child nodes own their own transforms, and may outlive this one:
+			_hierarchy->remove(_transform);
+		}
+	}
+}
@@ -0,0 +1,132 @@
+//
+//  Graphics/TransformHierarchy.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_TRANSFORMHIERARCHY_H
+#define _DREAM_CLIENT_GRAPHICS_TRANSFORMHIERARCHY_H
+
+#include "Renderer.h"
+
+#include <Euclid/Numerics/Vector.h>
+#include <Euclid/Numerics/Matrix.h>
+
+#include <cstdint>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		using Euclid::Numerics::Vec3;
+		using Euclid::Numerics::Vec4;
+		using Euclid::Numerics::Mat44;
+
+		/**
+		 Stores the transforms of many nodes in flat arrays, ordered so that every parent comes before its children. World matrices are updated in a single pass: changes are propagated down to dirty subtrees, then the world matrices of dirty nodes are computed in batches using SIMD, where available. Nodes which didn't change are not touched.
+
+		 Nodes are referred to by handles, which remain valid while the arrays are reordered, e.g. when a node is given a new parent. A handle must not be used after the node has been destroyed, as it may be reused by a new node.
+
+		 Destroyed nodes are only marked, and the arrays are compacted once by the next update, so destroying many nodes, e.g. when tearing down a scene, is linear in the size of the hierarchy.
+		 */
+		class TransformHierarchy : public Object {
+		public:
+			typedef std::uint32_t HandleT;
+			static const HandleT NONE = ~(HandleT)0;
+
+			/// A local transform: scale, then rotate by a unit quaternion (x, y, z, w), then translate.
+			struct Local {
+				Vec3 translation;
+				Vec4 rotation;
+				Vec3 scale;
+
+				Local();
+				Local(const Vec3 & translation, const Vec4 & rotation, const Vec3 & scale);
+			};
+
+		protected:
+			// These arrays are indexed by position in the topologically sorted order:
+			std::vector<std::uint32_t> _parents;
+			std::vector<HandleT> _handles;
+			std::vector<Local> _locals;
+			std::vector<Mat44> _local_matrices;
+			std::vector<Mat44> _world_matrices;
+			std::vector<std::uint8_t> _dirty;
+
+			// The position of each handle, or NONE if the handle is free:
+			std::vector<std::uint32_t> _positions;
+			std::vector<HandleT> _free_handles;
+
+			// Set when a node is given a new parent, which may break the ordering:
+			bool _unsorted = false;
+
+			// The number of nodes marked as removed but not yet compacted:
+			std::size_t _removed_count = 0;
+
+			// Positions of dirty nodes, reused between updates:
+			std::vector<std::uint32_t> _updates;
+
+			std::size_t _updated_count = 0;
+
+			void sort();
+
+			// Drop the nodes marked as removed, preserving the order of the remaining nodes and attaching their children to the nearest remaining ancestor. The arrays must be sorted:
+			void compact();
+
+			bool exists(HandleT handle) const { return handle < _positions.size() && _positions[handle] != NONE; }
+
+		public:
+			TransformHierarchy();
+			virtual ~TransformHierarchy();
+
+			/// Create a node with the given parent, which may be NONE for a root node.
+			HandleT create(HandleT parent = NONE, const Local & local = Local());
+
+			/// Destroy the node and all of its descendants. Destroying a node which was already destroyed, e.g. as the descendant of another node, has no effect.
+			void destroy(HandleT handle);
+
+			/// Destroy only the given node. Its children are attached to its parent, keeping their local transforms. Removing a node which was already destroyed has no effect.
+			void remove(HandleT handle);
+
+			void set_parent(HandleT handle, HandleT parent);
+			HandleT parent(HandleT handle) const;
+
+			void set_local(HandleT handle, const Local & local);
+			const Local & local(HandleT handle) const { return _locals[_positions[handle]]; }
+
+			/// The world matrix as of the last update.
+			const Mat44 & world_matrix(HandleT handle) const { return _world_matrices[_positions[handle]]; }
+
+			/// Recompute the world matrices of all dirty nodes and their descendants.
+			void update();
+
+			std::size_t size() const { return _handles.size() - _removed_count; }
+
+			/// The number of world matrices recomputed by the last update.
+			std::size_t updated_count() const { return _updated_count; }
+
+			/// Compute result = left * right for column major matrices, using SIMD where available. The result may alias either argument.
+			static void multiply(Mat44 & result, const Mat44 & left, const Mat44 & right);
+
+			/// Compute the matrix for a local transform.
+			static void compose(Mat44 & result, const Local & local);
+		};
+
+		/// A node whose transform is stored in a TransformHierarchy.
+		class TransformNode : public INode {
+		protected:
+			Ref<TransformHierarchy> _hierarchy;
+			TransformHierarchy::HandleT _transform;
+
+		public:
+			TransformNode(Ptr<TransformHierarchy> hierarchy, TransformHierarchy::HandleT parent = TransformHierarchy::NONE);
+			virtual ~TransformNode();
+
+			TransformHierarchy::HandleT transform() const { return _transform; }
+
+			void set_local(const TransformHierarchy::Local & local) { _hierarchy->set_local(_transform, local); }
+			const Mat44 & world_matrix() const { return _hierarchy->world_matrix(_transform); }
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,68 @@
+//
+//  Graphics/UniformName.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "UniformName.h"
+
+#include <mutex>
+#include <unordered_map>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		namespace
+		{
+			// Names may be interned from worker threads, e.g. while recording commands:
+			struct NameTable {
+				std::mutex lock;
+				std::unordered_map<StringT, UniformName::IdentifierT> identifiers;
+
+				// Stored by pointer so that references remain valid as the table grows:
+				std::vector<std::unique_ptr<StringT>> names;
+			};
+
+			NameTable & name_table()
+			{
+				static NameTable table;
+
+				return table;
+			}
+		}
+
+		UniformName::IdentifierT UniformName::intern(const StringT & name)
+		{
+			NameTable & table = name_table();
+			std::lock_guard<std::mutex> guard(table.lock);
+
+			auto iterator = table.identifiers.find(name);
+
+			if (iterator != table.identifiers.end())
+				return iterator->second;
+
+			IdentifierT identifier = (IdentifierT)table.names.size();
+
+			table.names.push_back(std::unique_ptr<StringT>(new StringT(name)));
+			table.identifiers[name] = identifier;
+
+			return identifier;
+		}
+
+		const StringT & UniformName::name() const
+		{
+			NameTable & table = name_table();
+			std::lock_guard<std::mutex> guard(table.lock);
+
+			return *table.names[_identifier];
+		}
+
+		std::size_t UniformName::count()
+		{
+			NameTable & table = name_table();
+			std::lock_guard<std::mutex> guard(table.lock);
+
+			return table.names.size();
+		}
+	}
+}
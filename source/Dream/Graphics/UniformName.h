@@ -0,0 +1,60 @@
+//
+//  Graphics/UniformName.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_UNIFORMNAME_H
+#define _DREAM_CLIENT_GRAPHICS_UNIFORMNAME_H
+
+#include <Dream/Framework.h>
+
+#include <cstdint>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		/**
+		 An interned uniform name. Constructing a name looks it up in a global table, after which it is a small integer which can be used to find uniform locations without any string handling. Hot code should construct names once, e.g.:
+
+		 static const UniformName DISPLAY_MATRIX("display_matrix");
+		 binding.set_uniform(DISPLAY_MATRIX, matrix);
+		 */
+		class UniformName {
+		public:
+			typedef std::uint32_t IdentifierT;
+
+		protected:
+			IdentifierT _identifier;
+
+			UniformName() : _identifier(0) {}
+
+			static IdentifierT intern(const StringT & name);
+
+		public:
+			explicit UniformName(const char * name) : _identifier(intern(name)) {}
+			explicit UniformName(const StringT & name) : _identifier(intern(name)) {}
+
+			IdentifierT identifier() const { return _identifier; }
+
+			/// The name with the given identifier, which must have come from an existing name, e.g. one recorded into a command buffer.
+			static UniformName for_identifier(IdentifierT identifier) {
+				UniformName name;
+				name._identifier = identifier;
+
+				return name;
+			}
+
+			/// The original string, for diagnostics.
+			const StringT & name() const;
+
+			bool operator==(const UniformName & other) const { return _identifier == other._identifier; }
+			bool operator!=(const UniformName & other) const { return _identifier != other._identifier; }
+
+			/// The number of distinct names which have been interned.
+			static std::size_t count();
+		};
+	}
+}
+
+#endif
@@ -0,0 +1,208 @@
+//
+//  Graphics/UniformRing.cpp
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#include "UniformRing.h"
+
+#include <cstring>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		static std::size_t align(std::size_t offset, std::size_t alignment)
+		{
+			return (offset + alignment - 1) / alignment * alignment;
+		}
+
+		UniformRing::UniformRing(std::size_t frame_size, std::size_t frame_count) : _frame_count(frame_count), _frame(0), _head(0), _fences(frame_count, nullptr), _mapped(nullptr)
+		{
+			GLint alignment = 0;
+			glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+			_alignment = alignment > 0 ? alignment : 256;
+
+			// Each frame segment must start on an aligned boundary:
+			_frame_size = align(frame_size, _alignment);
+
+			std::size_t size = _frame_size * _frame_count;
+
+			_buffer.bind();
+
+#ifdef GL_MAP_PERSISTENT_BIT
+			if (has_graphics_extension("GL_ARB_buffer_storage")) {
+				// Coherent writes are visible to the GPU without flushing, so pushing a block is only a memcpy:
+				const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+				glBufferStorage(GL_UNIFORM_BUFFER, (GLsizeiptr)size, nullptr, flags);
+				_mapped = (GLubyte *)glMapBufferRange(GL_UNIFORM_BUFFER, 0, (GLsizeiptr)size, flags);
+			} else
+#endif
+			{
+				_buffer.resize(size, GL_STREAM_DRAW);
+			}
+
+			_buffer.unbind();
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+
+			logger()->log(LOG_DEBUG, LogBuffer() << "Allocating " << size << " bytes to uniform ring with alignment " << _alignment << (_mapped ? " (persistently mapped)" : ""));
+		}
+
+		UniformRing::~UniformRing()
+		{
+			for (auto fence : _fences) {
+				if (fence)
+					glDeleteSync(fence);
+			}
+		}
+
+		void UniformRing::begin_frame()
+		{
+			_frame = (_frame + 1) % _frame_count;
+			_head = 0;
+
+			GLsync & fence = _fences[_frame];
+
+			if (fence) {
+				// This only waits if the GPU is more than frame_count frames behind:
+				while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED);
+
+				glDeleteSync(fence);
+				fence = nullptr;
+			}
+		}
+
+		void UniformRing::end_frame()
+		{
+			GLsync & fence = _fences[_frame];
+
+			if (fence)
+				glDeleteSync(fence);
+
+			fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		}
+
+		UniformRing::Block UniformRing::push(const void * data, std::size_t size)
+		{
+			if (_head + size > _frame_size)
+				throw std::length_error("Uniform ring frame segment is full!");
+
+			Block block = {(GLintptr)(_frame * _frame_size + _head), (GLsizeiptr)size};
+
+			if (_mapped) {
+				// The fences guarantee the GPU isn't reading this range, so it doesn't need to be synchronised:
+				std::memcpy(_mapped + block.offset, data, size);
+			} else {
+				_buffer.bind();
+				glBufferSubData(GL_UNIFORM_BUFFER, block.offset, block.size, data);
+				_buffer.unbind();
+
+				DREAM_CHECK_GRAPHICS_ERROR();
+			}
+
+			_head = align(_head + size, _alignment);
+
+			return block;
+		}
+
+		void UniformRing::bind(GLuint binding_index, const Block & block)
+		{
+			glBindBufferRange(GL_UNIFORM_BUFFER, binding_index, _buffer.handle(), block.offset, block.size);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+// MARK: -
+
+		UniformBlockLayout::UniformBlockLayout(Ptr<Program> program, const char * name) : _name(name), _data_size(0)
+		{
+			GLuint handle = program->handle();
+
+			_index = glGetUniformBlockIndex(handle, name);
+
+			if (_index == GL_INVALID_INDEX)
+				return;
+
+			glGetActiveUniformBlockiv(handle, _index, GL_UNIFORM_BLOCK_DATA_SIZE, &_data_size);
+
+			GLint count = 0;
+			glGetActiveUniformBlockiv(handle, _index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORMS, &count);
+
+			if (count == 0)
+				return;
+
+			std::vector<GLint> indices(count);
+			glGetActiveUniformBlockiv(handle, _index, GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES, indices.data());
+
+			std::vector<GLuint> uniform_indices(indices.begin(), indices.end());
+			std::vector<GLint> types(count), sizes(count), offsets(count), array_strides(count), matrix_strides(count);
+
+			glGetActiveUniformsiv(handle, count, uniform_indices.data(), GL_UNIFORM_TYPE, types.data());
+			glGetActiveUniformsiv(handle, count, uniform_indices.data(), GL_UNIFORM_SIZE, sizes.data());
+			glGetActiveUniformsiv(handle, count, uniform_indices.data(), GL_UNIFORM_OFFSET, offsets.data());
+			glGetActiveUniformsiv(handle, count, uniform_indices.data(), GL_UNIFORM_ARRAY_STRIDE, array_strides.data());
+			glGetActiveUniformsiv(handle, count, uniform_indices.data(), GL_UNIFORM_MATRIX_STRIDE, matrix_strides.data());
+
+			GLint max_length = 0;
+			program->property(GL_ACTIVE_UNIFORM_MAX_LENGTH, &max_length);
+			std::vector<GLchar> buffer(max_length + 1);
+
+			for (GLint i = 0; i < count; i += 1) {
+				GLsizei length = 0;
+				glGetActiveUniformName(handle, uniform_indices[i], (GLsizei)buffer.size(), &length, buffer.data());
+
+				_members.push_back({StringT(buffer.data(), length), (GLenum)types[i], sizes[i], offsets[i], array_strides[i], matrix_strides[i]});
+			}
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+		const UniformBlockLayout::Member * UniformBlockLayout::member(const StringT & name) const
+		{
+			for (auto & member : _members) {
+				if (member.name == name)
+					return &member;
+
+				// Members of blocks with an instance name are reported as "Block.member":
+				std::size_t separator = member.name.rfind('.');
+				if (separator != StringT::npos && member.name.compare(separator + 1, StringT::npos, name) == 0)
+					return &member;
+			}
+
+			return nullptr;
+		}
+
+		bool UniformBlockLayout::check_size(std::size_t size) const
+		{
+			if (!valid() || (std::size_t)_data_size != size) {
+				logger()->log(LOG_ERROR, LogBuffer() << "Uniform block " << _name << " has size " << _data_size << " but the structure has size " << size);
+
+				return false;
+			}
+
+			return true;
+		}
+
+		bool UniformBlockLayout::check_offset(const StringT & name, std::size_t offset) const
+		{
+			const Member * reflected = member(name);
+
+			if (!reflected) {
+				logger()->log(LOG_ERROR, LogBuffer() << "Uniform block " << _name << " has no active member " << name);
+
+				return false;
+			}
+
+			if ((std::size_t)reflected->offset != offset) {
+				logger()->log(LOG_ERROR, LogBuffer() << "Uniform block " << _name << " member " << name << " has offset " << reflected->offset << " but the structure has offset " << offset);
+
+				return false;
+			}
+
+			return true;
+		}
+#endif
+	}
+}
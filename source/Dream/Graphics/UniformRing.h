@@ -0,0 +1,133 @@
+//
+//  Graphics/UniformRing.h
+//  This file is part of the "Dream" project, and is released under the MIT license.
+//
+
+#ifndef _DREAM_CLIENT_GRAPHICS_UNIFORMRING_H
+#define _DREAM_CLIENT_GRAPHICS_UNIFORMRING_H
+
+#include "ShaderManager.h"
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		/**
+		 Sub-allocates per-draw uniform blocks from a large streaming uniform buffer. The buffer is split into one segment per frame in flight, and a fence guards each segment so it is only reused once the GPU has finished reading it. This means blocks can be written without synchronisation, so setting per-object uniforms is one memcpy and one range bind:
+
+		 ring->begin_frame();
+		 for (auto & object : objects) {
+		 	auto block = ring->push(object.uniforms);
+		 	ring->bind(OBJECT_BLOCK, block);
+		 	object.draw();
+		 }
+		 ring->end_frame();
+
+		 When GL_ARB_buffer_storage is available the buffer stays mapped for its whole lifetime, as a buffer can't otherwise be read by draws while it is mapped. Without it, each block is uploaded with glBufferSubData.
+		 */
+		class UniformRing : public Object {
+		public:
+			struct Block {
+				GLintptr offset;
+				GLsizeiptr size;
+			};
+
+		protected:
+			UniformBuffer _buffer;
+
+			std::size_t _frame_size, _frame_count;
+
+			// Blocks must be aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:
+			std::size_t _alignment;
+
+			// The current frame segment, and the next free offset within it:
+			std::size_t _frame, _head;
+
+			std::vector<GLsync> _fences;
+
+			// The persistent mapping of the whole buffer, or NULL if buffer storage isn't supported:
+			GLubyte * _mapped;
+
+		public:
+			/// Allocates frame_size * frame_count bytes. The frame size is the maximum amount of uniform data pushed per frame.
+			UniformRing(std::size_t frame_size, std::size_t frame_count = 3);
+			virtual ~UniformRing();
+
+			std::size_t alignment() const { return _alignment; }
+			std::size_t frame_size() const { return _frame_size; }
+
+			/// The number of bytes pushed so far in the current frame, including alignment padding.
+			std::size_t used() const { return _head; }
+
+			/// Advance to the next frame segment, waiting for the GPU if it is still reading from it.
+			void begin_frame();
+
+			/// Mark the end of all draws using the current frame segment.
+			void end_frame();
+
+			/// Copy the data into the current frame segment. Throws std::length_error if the segment is full.
+			Block push(const void * data, std::size_t size);
+
+			template <typename BlockT>
+			Block push(const BlockT & block) {
+				return push(&block, sizeof(BlockT));
+			}
+
+			/// Bind the block to the given uniform buffer binding index.
+			void bind(GLuint binding_index, const Block & block);
+		};
+
+		/**
+		 The layout of a uniform block as reflected from a linked program. This can be used at startup to check that C++ structures used with UniformRing match the std140 layout the driver uses:
+
+		 UniformBlockLayout layout(program, "Object");
+		 layout.check_size(sizeof(ObjectUniforms));
+		 layout.check("model_matrix", &ObjectUniforms::model_matrix);
+		 */
+		class UniformBlockLayout {
+		public:
+			struct Member {
+				StringT name;
+				GLenum type;
+				GLint size;
+				GLint offset;
+				GLint array_stride;
+				GLint matrix_stride;
+			};
+
+		protected:
+			StringT _name;
+			GLuint _index;
+			GLint _data_size;
+
+			std::vector<Member> _members;
+
+		public:
+			UniformBlockLayout(Ptr<Program> program, const char * name);
+
+			/// Whether the program has an active block with the given name.
+			bool valid() const { return _index != GL_INVALID_INDEX; }
+
+			GLuint index() const { return _index; }
+			GLint data_size() const { return _data_size; }
+
+			const std::vector<Member> & members() const { return _members; }
+
+			/// Find a member by name, or NULL if it is not active. Names may omit the block instance prefix.
+			const Member * member(const StringT & name) const;
+
+			/// These log and return false if the structure doesn't match the reflected layout.
+			bool check_size(std::size_t size) const;
+			bool check_offset(const StringT & name, std::size_t offset) const;
+
+			template <class T, typename U>
+			bool check(const StringT & name, U T::* member) const {
+				return check_offset(name, member_offset(member));
+			}
+		};
+#endif
+	}
+}
+
+#endif
@@ -22,13 +22,13 @@ namespace Dream
 		VertexArray::VertexArray() {
 			glGenVertexArrays(1, &_handle);
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		VertexArray::~VertexArray() {
 			glDeleteVertexArrays(1, &_handle);
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void VertexArray::bind() {
@@ -36,7 +36,9 @@ namespace Dream
 
 			glBindVertexArray(_handle);
 
-			check_graphics_error();
+			FrameStats::count(FrameStats::VERTEX_ARRAY_BINDS);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void VertexArray::unbind() {
@@ -44,38 +46,53 @@ namespace Dream
 
 			glBindVertexArray(0);
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void VertexArray::Binding::enable(GLuint index) {
 			glEnableVertexAttribArray(index);
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void VertexArray::Binding::disable(GLuint index) {
 			glDisableVertexAttribArray(index);
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		// These functions facilitate canonical usage where data is stored in vertex buffers.
 		void VertexArray::Binding::draw_elements(GLenum mode, GLsizei count, GLenum type) {
 			glDrawElements(mode, count, type, 0);
 
-			check_graphics_error();
+			FrameStats::count_draw(mode, count);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		void VertexArray::Binding::draw_arrays(GLenum mode, GLint first, GLsizei count) {
 			glDrawArrays(mode, first, count);
 
-			check_graphics_error();
+			FrameStats::count_draw(mode, count);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
+		}
+
+#ifndef DREAM_OPENGLES2
+		void VertexArray::Binding::draw_transform_feedback(GLenum mode, GLuint feedback) {
+			glDrawTransformFeedback(mode, feedback);
+
+			// The number of primitives is only known to the GPU:
+			FrameStats::count(FrameStats::DRAW_CALLS);
+
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
+#endif
 
 		void VertexArray::Binding::set_attribute(GLuint index, GLuint size, GLenum type, GLboolean normalized, GLsizei stride, std::ptrdiff_t offset) {
 			glVertexAttribPointer(index, size, type, normalized, stride, (const GLvoid *)offset);
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 	}
 }
@@ -20,10 +20,17 @@ namespace Dream
 			ElementT element;
 		};
 
+		class RenderQueue;
+		class CommandBuffer;
+
 		class VertexArray : private NonCopyable {
 		protected:
 			GLuint _handle;
 
+			// These keep vertex arrays bound between draws:
+			friend class RenderQueue;
+			friend class CommandBuffer;
+
 			void bind();
 			void unbind();
 
@@ -88,6 +95,11 @@ namespace Dream
 				void draw_elements(GLenum mode, GLsizei count, GLenum type);
 				void draw_arrays(GLenum mode, GLint first, GLsizei count);
 
+#ifndef DREAM_OPENGLES2
+				// Draw the vertices captured by the given transform feedback object, without querying the count back to the CPU.
+				void draw_transform_feedback(GLenum mode, GLuint feedback);
+#endif
+
 				void attach(BufferHandle<GL_ELEMENT_ARRAY_BUFFER> & buffer) {
 					buffer.bind();
 				}
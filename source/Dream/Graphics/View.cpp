@@ -8,6 +8,7 @@
 
 #include "View.h"
 #include "WireframeRenderer.h"
+#include "Trace.h"
 #include <Dream/Display/Scene.h>
 
 #include <Euclid/Numerics/Vector.IO.h>
@@ -224,6 +225,8 @@ namespace Dream
 		}
 
 		bool View::resize(const ResizeInput &input) {
+			DREAM_TRACE_ZONE("View::resize");
+
 			if (is_principal_view()) {
 				// We need to resize the entire box.
 				_bounds.min() = 0;
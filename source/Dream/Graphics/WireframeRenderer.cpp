@@ -21,13 +21,15 @@ namespace Dream
 				attributes[POSITION] = &Vertex::position;
 			}
 
-			check_graphics_error();
+			DREAM_CHECK_GRAPHICS_ERROR();
 		}
 
 		WireframeRenderer::~WireframeRenderer() {
 		}
 
 		void WireframeRenderer::render(const std::vector<Vec3> & line, Layout layout) {
+			DREAM_GPU_SCOPE("WireframeRenderer::render");
+
 			{
 				// Upload data:
 				auto binding = _vertex_buffer.binding<Vec3>();
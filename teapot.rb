@@ -46,6 +46,22 @@ define_target "dream-graphics-tests" do |target|
 	target.provides "Test/Dream/Graphics"
 end
 
+define_target "dream-graphics-replay" do |target|
+	target.build do |environment|
+		build_directory(package.path, 'replay', environment.merge do
+			append linkflags "-lEGL"
+		end)
+	end
+	
+	target.run do |environment|
+		run_executable("bin/dream-graphics-replay", environment)
+	end
+	
+	target.depends "Library/Dream/Graphics"
+	
+	target.provides "Tool/Dream/Graphics/Replay"
+end
+
 define_configuration "dream-graphics" do |configuration|
 	configuration.public!
 	
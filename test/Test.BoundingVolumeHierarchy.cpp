@@ -0,0 +1,158 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/BoundingVolumeHierarchy.h>
+
+#include <chrono>
+#include <cmath>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		// An orthographic projection of the cube from -size to +size on every axis:
+		static Mat44 orthographic(float size, float offset_x = 0) {
+			Mat44 matrix;
+
+			for (std::size_t i = 0; i < 16; i += 1)
+				matrix.data()[i] = 0;
+
+			matrix.data()[0] = matrix.data()[5] = matrix.data()[10] = 1 / size;
+			matrix.data()[12] = -offset_x / size;
+			matrix.data()[15] = 1;
+
+			return matrix;
+		}
+
+		static AlignedBox<3> unit_box(float x, float y, float z) {
+			return AlignedBox<3>(Vec3(x - 0.5f, y - 0.5f, z - 0.5f), Vec3(x + 0.5f, y + 0.5f, z + 0.5f));
+		}
+
+		class CountingRenderer : public IRenderer {
+		public:
+			std::size_t count = 0;
+
+			virtual void render(INode * node) {
+				count += 1;
+			}
+		};
+
+		UnitTest::Suite BoundingVolumeHierarchyTestSuite {
+			"Dream::Graphics::BoundingVolumeHierarchy",
+
+			{"Frustum Classification",
+				[](UnitTest::Examiner & examiner) {
+					Frustum frustum(orthographic(10));
+
+					examiner.check_equal(frustum.classify(unit_box(0, 0, 0)), Frustum::INSIDE);
+					examiner.check_equal(frustum.classify(unit_box(10, 0, 0)), Frustum::INTERSECTS);
+					examiner.check_equal(frustum.classify(unit_box(0, -20, 0)), Frustum::OUTSIDE);
+					examiner.check_equal(frustum.classify(unit_box(0, 0, 11)), Frustum::OUTSIDE);
+				}
+			},
+
+			{"Culling",
+				[](UnitTest::Examiner & examiner) {
+					BoundingVolumeHierarchy hierarchy(0);
+					std::vector<INode> nodes(100 * 100);
+					std::vector<BoundingVolumeHierarchy::ProxyT> proxies;
+
+					// A grid from -50 to 49 on the x and y axes:
+					for (std::size_t i = 0; i < nodes.size(); i += 1)
+						proxies.push_back(hierarchy.insert(&nodes[i], unit_box((float)(i % 100) - 50, (float)(i / 100) - 50, 0)));
+
+					examiner << "The tree is balanced" << std::endl;
+					examiner.check_equal(hierarchy.size(), nodes.size());
+					examiner.check(hierarchy.height() <= 2 * 14);
+
+					Frustum frustum(orthographic(10));
+
+					std::size_t expected = 0;
+					for (std::size_t i = 0; i < nodes.size(); i += 1) {
+						if (frustum.classify(hierarchy.box(proxies[i])) != Frustum::OUTSIDE)
+							expected += 1;
+					}
+
+					std::vector<INode *> visible;
+					hierarchy.query(frustum, visible);
+
+					examiner << "Only nodes within the frustum are visible" << std::endl;
+					examiner.check_equal(visible.size(), expected);
+					examiner.check_equal(visible.size(), 21 * 21);
+
+					CountingRenderer renderer;
+					hierarchy.traverse(&renderer, frustum);
+					examiner.check_equal(renderer.count, expected);
+
+					// Move a node from far away into view:
+					examiner.check(hierarchy.refit(proxies[0], unit_box(0, 0, 5)));
+
+					visible.clear();
+					hierarchy.query(frustum, visible);
+					examiner.check_equal(visible.size(), expected + 1);
+
+					for (std::size_t i = 0; i < nodes.size(); i += 2)
+						hierarchy.remove(proxies[i]);
+
+					examiner.check_equal(hierarchy.size(), nodes.size() / 2);
+
+					visible.clear();
+					hierarchy.query(frustum, visible);
+
+					examiner << "Removed nodes are no longer visible" << std::endl;
+					for (auto node : visible)
+						examiner.check(((node - &nodes[0]) % 2) == 1);
+				}
+			},
+
+			{"Refitting",
+				[](UnitTest::Examiner & examiner) {
+					BoundingVolumeHierarchy hierarchy(0.5);
+					INode node;
+
+					auto proxy = hierarchy.insert(&node, unit_box(0, 0, 0));
+
+					examiner << "Small movements stay within the enlarged box" << std::endl;
+					examiner.check(!hierarchy.refit(proxy, unit_box(0.25, 0, 0)));
+					examiner.check(hierarchy.refit(proxy, unit_box(2, 0, 0)));
+					examiner.check_equal(hierarchy.node(proxy), &node);
+				}
+			},
+
+			{"Culling Performance",
+				[](UnitTest::Examiner & examiner) {
+					const std::size_t SIDE = 500;
+
+					typedef std::chrono::high_resolution_clock ClockT;
+
+					BoundingVolumeHierarchy hierarchy;
+					std::vector<INode> nodes(SIDE * SIDE);
+
+					for (std::size_t i = 0; i < nodes.size(); i += 1)
+						hierarchy.insert(&nodes[i], unit_box((float)(i % SIDE) * 2, (float)(i / SIDE) * 2, 0));
+
+					Frustum frustum(orthographic(20, 500));
+
+					std::vector<INode *> visible;
+					visible.reserve(nodes.size());
+
+					auto start = ClockT::now();
+					hierarchy.query(frustum, visible);
+					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					start = ClockT::now();
+					std::size_t brute_force = 0;
+					for (std::size_t i = 0; i < nodes.size(); i += 1) {
+						if (frustum.classify(unit_box((float)(i % SIDE) * 2, (float)(i / SIDE) * 2, 0)) != Frustum::OUTSIDE)
+							brute_force += 1;
+					}
+					auto brute_force_duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					examiner << "Found " << visible.size() << " of " << nodes.size() << " nodes in " << duration << "us, testing every node took " << brute_force_duration << "us" << std::endl;
+					examiner.check(visible.size() > 0);
+					examiner.check(visible.size() < nodes.size() / 100);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,85 @@
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/Renderer.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		// Each node records one draw per vertex, so the recorded commands identify the node:
+		class CountingNode : public INode {
+		public:
+			GLsizei vertices;
+
+			CountingNode(GLsizei vertices_) : vertices(vertices_) {}
+		};
+
+		class RecordingRenderer : public IRenderer {
+		public:
+			virtual void render(INode * node) {
+				CountingNode * counting_node = static_cast<CountingNode *>(node);
+				CommandBuffer * command_buffer = CommandBuffer::current();
+
+				for (GLsizei i = 0; i < counting_node->vertices; i += 1)
+					command_buffer->draw_arrays(GL_POINTS, i, 1);
+			}
+		};
+
+		UnitTest::Suite CommandBufferTestSuite {
+			"Dream::Graphics::CommandBuffer",
+
+			{"Recording",
+				[](UnitTest::Examiner & examiner) {
+					Ref<CommandBuffer> command_buffer = new CommandBuffer;
+
+					command_buffer->draw_arrays(GL_TRIANGLES, 0, 3);
+					command_buffer->draw_elements(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT);
+
+					examiner << "Commands were recorded" << std::endl;
+					examiner.check_equal(command_buffer->size(), 2);
+
+					command_buffer->clear();
+					examiner.check_equal(command_buffer->size(), 0);
+
+					examiner << "No command buffer is current outside of a recording" << std::endl;
+					examiner.check(CommandBuffer::current() == nullptr);
+
+					{
+						CommandBuffer::Recording recording(command_buffer.get());
+						examiner.check(CommandBuffer::current() == command_buffer.get());
+					}
+
+					examiner.check(CommandBuffer::current() == nullptr);
+				}
+			},
+
+			{"Parallel Traversal",
+				[](UnitTest::Examiner & examiner) {
+					std::vector<CountingNode> nodes;
+					for (GLsizei i = 0; i < 64; i += 1)
+						nodes.push_back(CountingNode(i));
+
+					std::vector<INode *> subtrees;
+					for (auto & node : nodes)
+						subtrees.push_back(&node);
+
+					RecordingRenderer renderer;
+					std::vector<Ref<CommandBuffer>> command_buffers;
+
+					renderer.traverse_parallel(subtrees, command_buffers, 4);
+
+					examiner << "Each subtree was recorded into its own command buffer, in order" << std::endl;
+					examiner.check_equal(command_buffers.size(), subtrees.size());
+
+					bool ordered = true;
+					for (std::size_t i = 0; i < command_buffers.size(); i += 1) {
+						if (command_buffers[i]->size() != i)
+							ordered = false;
+					}
+
+					examiner.check(ordered);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,61 @@
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/FeedbackParticleRenderer.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite FeedbackParticleRendererTestSuite {
+			"Dream::Graphics::FeedbackParticleRenderer",
+
+			{"Schedule",
+				[](UnitTest::Examiner & examiner) {
+					typedef FeedbackParticleRenderer::Schedule Schedule;
+
+					Schedule schedule(2);
+
+					examiner << "Nothing is simulated until a particle is emitted" << std::endl;
+					examiner.check(!schedule.pending());
+					examiner.check(!schedule.captured());
+
+					FeedbackParticleRenderer::Particle particle;
+					particle.lifetime = Vec2(1, 0);
+
+					examiner.check(schedule.emit(particle));
+					examiner.check(schedule.emit(particle));
+
+					examiner << "Particles beyond the capacity are dropped" << std::endl;
+					examiner.check(!schedule.emit(particle));
+					examiner.check_equal(schedule.spawn().size(), 2);
+					examiner.check(schedule.pending());
+
+					Schedule::Pass first = schedule.pass();
+					examiner.check_equal(first.source, 0);
+					examiner.check_equal(first.destination, 1);
+					examiner.check(!first.simulate);
+					examiner.check_equal(first.spawn_count, 2);
+
+					schedule.complete();
+
+					examiner << "The destination becomes current and the spawned particles are consumed" << std::endl;
+					examiner.check_equal(schedule.current(), 1);
+					examiner.check(schedule.captured());
+					examiner.check(schedule.spawn().empty());
+
+					examiner << "Captured particles keep being simulated without new emissions" << std::endl;
+					examiner.check(schedule.pending());
+
+					Schedule::Pass second = schedule.pass();
+					examiner.check_equal(second.source, 1);
+					examiner.check_equal(second.destination, 0);
+					examiner.check(second.simulate);
+					examiner.check_equal(second.spawn_count, 0);
+
+					schedule.complete();
+					examiner.check_equal(schedule.current(), 0);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,51 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/FileWatcher.h>
+
+#include <cstdio>
+#include <fstream>
+
+#include <sys/stat.h>
+#include <utime.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite FileWatcherTestSuite {
+			"Dream::Graphics::FileWatcher",
+
+			{"Polling",
+				[](UnitTest::Examiner & examiner) {
+					StringT path = "file-watcher-test.txt";
+					std::ofstream(path) << "Hello World";
+
+					// Poll on every call, without notifications:
+					FileWatcher watcher(FileWatcher::ClockT::duration::zero(), false);
+					watcher.watch(path);
+
+					examiner.check(!watcher.notifications());
+					examiner.check(watcher.watching(path));
+					examiner.check(watcher.poll().empty());
+
+					// Modification times have a resolution of one second, so move it explicitly:
+					struct stat status;
+					stat(path.c_str(), &status);
+
+					struct utimbuf times = {status.st_atime, status.st_mtime + 10};
+					utime(path.c_str(), &times);
+
+					FileWatcher::PathsT changed = watcher.poll();
+
+					examiner << "The modified file is reported once" << std::endl;
+					examiner.check_equal(changed.size(), 1);
+					examiner.check(changed.count(path) == 1);
+					examiner.check(watcher.poll().empty());
+
+					std::remove(path.c_str());
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,81 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/FrameStats.h>
+
+#include <sstream>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite FrameStatsTestSuite {
+			"Dream::Graphics::FrameStats",
+
+			{"Counting",
+				[](UnitTest::Examiner & examiner) {
+					FrameStats frame_stats(4);
+
+					// Discard anything counted before the test:
+					frame_stats.end_frame();
+
+					FrameStats::count_draw(GL_TRIANGLES, 30);
+					FrameStats::count_draw(GL_TRIANGLE_STRIP, 4);
+					FrameStats::count(FrameStats::BUFFER_BYTES, 1024);
+					FrameStats::count(FrameStats::PROGRAM_BINDS);
+					FrameStats::count(FrameStats::UNIFORM_UPLOADS, 3);
+					FrameStats::count(FrameStats::UNIFORM_SKIPPED);
+
+					examiner.check_equal(FrameStats::counters()[FrameStats::DRAW_CALLS], 2);
+					examiner.check_equal(FrameStats::counters()[FrameStats::PRIMITIVES], 12);
+
+					frame_stats.end_frame();
+
+					examiner << "Counters are reset at the end of each frame" << std::endl;
+					examiner.check_equal(FrameStats::counters()[FrameStats::DRAW_CALLS], 0);
+					examiner.check_equal(frame_stats.last()[FrameStats::DRAW_CALLS], 2);
+					examiner.check_equal(frame_stats.last()[FrameStats::BUFFER_BYTES], 1024);
+
+					examiner.check_equal(frame_stats.overlay(), "draws 2 prims 12 upload 1kB binds 1/0/0 uniforms 3/1 errors 0");
+				}
+			},
+
+			{"History",
+				[](UnitTest::Examiner & examiner) {
+					FrameStats frame_stats(4);
+					frame_stats.end_frame();
+
+					// Only the most recent four frames are kept:
+					for (std::size_t frame = 1; frame <= 6; frame += 1) {
+						for (std::size_t i = 0; i < frame * 10; i += 1)
+							FrameStats::count_draw(GL_POINTS, 1);
+
+						frame_stats.end_frame();
+					}
+
+					FrameStats::Summary summary = frame_stats.summary(FrameStats::DRAW_CALLS);
+
+					examiner.check_equal(frame_stats.frame_count(), 7);
+					examiner.check_equal(summary.minimum, 30);
+					examiner.check_equal(summary.maximum, 60);
+					examiner.check_equal(summary.average, 45);
+
+					FrameStats::Histogram histogram = frame_stats.histogram(FrameStats::DRAW_CALLS, 4);
+
+					std::size_t total = 0;
+					for (auto count : histogram.bins)
+						total += count;
+
+					examiner << "Every frame is in the histogram" << std::endl;
+					examiner.check_equal(total, 4);
+					examiner.check_equal(histogram.bins.back(), 2);
+
+					std::stringstream output;
+					frame_stats.write(output);
+
+					examiner.check(output.str().find("\"draw_calls\":{\"last\":60") != StringT::npos);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,270 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/GLCapture.h>
+
+#include <cstring>
+#include <sstream>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		namespace
+		{
+			// The fake entry points log what they were called with, and create names starting from the given base:
+			std::vector<StringT> _calls;
+			GLuint _base_name = 0;
+			GLfloat _mapped[4];
+
+			template <typename... ArgumentsT>
+			void log_call(const char * name, ArgumentsT... arguments) {
+				StringStreamT buffer;
+				buffer << name;
+
+				for (auto argument : {(double)arguments...})
+					buffer << " " << argument;
+
+				_calls.push_back(buffer.str());
+			}
+
+			void fake_gen_buffers(GLsizei n, GLuint * buffers) {
+				for (GLsizei i = 0; i < n; i += 1)
+					buffers[i] = _base_name + i;
+			}
+
+			void fake_delete_buffers(GLsizei n, const GLuint * buffers) {
+				log_call("DeleteBuffers", buffers[0]);
+			}
+
+			void fake_bind_buffer(GLenum target, GLuint buffer) {
+				log_call("BindBuffer", buffer);
+			}
+
+			void fake_buffer_data(GLenum target, GLsizeiptr size, const void * data, GLenum usage) {
+				log_call("BufferData", size, ((const GLfloat *)data)[1]);
+			}
+
+			void fake_buffer_sub_data(GLenum target, GLintptr offset, GLsizeiptr size, const void * data) {
+				log_call("BufferSubData", offset, size, ((const GLfloat *)data)[0]);
+			}
+
+			void * fake_map_buffer_range(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access) {
+				return _mapped;
+			}
+
+			GLboolean fake_unmap_buffer(GLenum target) {
+				return GL_TRUE;
+			}
+
+			GLuint fake_create_program() {
+				return _base_name + 10;
+			}
+
+			void fake_delete_program(GLuint program) {
+				log_call("DeleteProgram", program);
+			}
+
+			void fake_use_program(GLuint program) {
+				log_call("UseProgram", program);
+			}
+
+			GLint fake_get_uniform_location(GLuint program, const GLchar * name) {
+				return std::strcmp(name, "color") == 0 ? _base_name + 20 : -1;
+			}
+
+			void fake_uniform_4fv(GLint location, GLsizei count, const GLfloat * values) {
+				log_call("Uniform4fv", location, count, values[3]);
+			}
+
+			void fake_uniform_2uiv(GLint location, GLsizei count, const GLuint * values) {
+				log_call("Uniform2uiv", location, count, values[1]);
+			}
+
+			void fake_uniform_matrix_2x3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat * values) {
+				log_call("UniformMatrix2x3fv", location, count, values[5]);
+			}
+
+			void fake_tex_image_3d(GLenum target, GLint level, GLint internal_format, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void * pixels) {
+				log_call("TexImage3D", width, height, depth, ((const GLubyte *)pixels)[width * height * depth * 4 - 1]);
+			}
+
+			void fake_draw_arrays(GLenum mode, GLint first, GLsizei count) {
+				log_call("DrawArrays", first, count);
+			}
+
+			void fake_finish() {
+			}
+
+			GLDispatch fake_dispatch() {
+				GLDispatch dispatch = GLDispatch::system();
+
+				dispatch.GenBuffers = fake_gen_buffers;
+				dispatch.DeleteBuffers = fake_delete_buffers;
+				dispatch.BindBuffer = fake_bind_buffer;
+				dispatch.BufferData = fake_buffer_data;
+				dispatch.BufferSubData = fake_buffer_sub_data;
+				dispatch.MapBufferRange = fake_map_buffer_range;
+				dispatch.UnmapBuffer = fake_unmap_buffer;
+				dispatch.CreateProgram = fake_create_program;
+				dispatch.DeleteProgram = fake_delete_program;
+				dispatch.UseProgram = fake_use_program;
+				dispatch.GetUniformLocation = fake_get_uniform_location;
+				dispatch.Uniform4fv = fake_uniform_4fv;
+				dispatch.Uniform2uiv = fake_uniform_2uiv;
+				dispatch.UniformMatrix2x3fv = fake_uniform_matrix_2x3fv;
+				dispatch.TexImage3D = fake_tex_image_3d;
+				dispatch.DrawArrays = fake_draw_arrays;
+				dispatch.Finish = fake_finish;
+
+				return dispatch;
+			}
+		}
+
+		UnitTest::Suite GLCaptureTestSuite {
+			"Dream::Graphics::GLCapture",
+
+			{"Capture and Replay",
+				[](UnitTest::Examiner & examiner) {
+					GLDispatch previous = gl_dispatch;
+					gl_dispatch = fake_dispatch();
+
+					std::stringstream stream;
+
+					{
+						_base_name = 100;
+						GLCapture capture(stream);
+
+						GLuint buffer;
+						gl_dispatch.GenBuffers(1, &buffer);
+						gl_dispatch.BindBuffer(GL_ARRAY_BUFFER, buffer);
+
+						GLfloat vertices[4] = {1, 2, 3, 4};
+						gl_dispatch.BufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+
+						GLuint program = gl_dispatch.CreateProgram();
+						GLint location = gl_dispatch.GetUniformLocation(program, "color");
+						gl_dispatch.UseProgram(program);
+
+						GLfloat color[4] = {0, 0, 0, 0.5};
+						gl_dispatch.Uniform4fv(location, 1, color);
+						gl_dispatch.DrawArrays(GL_TRIANGLES, 0, 3);
+
+						capture.frame();
+
+						// Data written into a mapped buffer is captured when it's unmapped:
+						GLfloat * mapped = (GLfloat *)gl_dispatch.MapBufferRange(GL_ARRAY_BUFFER, 4, 4, GL_MAP_WRITE_BIT);
+						mapped[0] = 5;
+						gl_dispatch.UnmapBuffer(GL_ARRAY_BUFFER);
+
+						gl_dispatch.DrawArrays(GL_TRIANGLES, 0, 3);
+
+						capture.frame();
+
+						examiner.check_equal(capture.frame_count(), 2);
+					}
+
+					examiner << "The previous entry points are restored" << std::endl;
+					examiner.check(gl_dispatch.DrawArrays == fake_draw_arrays);
+
+					_calls.clear();
+					_base_name = 200;
+
+					GLReplay replay(stream);
+					std::vector<double> durations = replay.replay(fake_dispatch());
+
+					examiner.check_equal(durations.size(), 2);
+
+					std::vector<StringT> expected = {
+						"BindBuffer 200",
+						"BufferData 16 2",
+						"UseProgram 210",
+						"Uniform4fv 220 1 0.5",
+						"DrawArrays 0 3",
+						"BufferSubData 4 4 5",
+						"DrawArrays 0 3",
+						"DeleteBuffers 200",
+						"DeleteProgram 210",
+					};
+
+					examiner << "Names and locations are remapped" << std::endl;
+					examiner.check_equal(_calls.size(), expected.size());
+
+					for (std::size_t i = 0; i < expected.size() && i < _calls.size(); i += 1)
+						examiner.check_equal(_calls[i], expected[i]);
+
+					gl_dispatch = previous;
+				}
+			},
+
+			{"Textures and Uniforms",
+				[](UnitTest::Examiner & examiner) {
+					GLDispatch previous = gl_dispatch;
+					gl_dispatch = fake_dispatch();
+
+					std::stringstream stream;
+
+					{
+						_base_name = 100;
+						GLCapture capture(stream);
+
+						// Each layer is 2x2 RGBA pixels, so rows are never padded:
+						std::vector<GLubyte> pixels(2 * 2 * 3 * 4, 1);
+						pixels.back() = 9;
+						gl_dispatch.TexImage3D(GL_TEXTURE_3D, 0, GL_RGBA8, 2, 2, 3, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+						GLuint program = gl_dispatch.CreateProgram();
+						GLint location = gl_dispatch.GetUniformLocation(program, "color");
+						gl_dispatch.UseProgram(program);
+
+						GLuint values[2] = {3, 7};
+						gl_dispatch.Uniform2uiv(location, 1, values);
+
+						GLfloat matrix[6] = {0, 1, 2, 3, 4, 5};
+						gl_dispatch.UniformMatrix2x3fv(location, 1, GL_FALSE, matrix);
+
+						capture.frame();
+					}
+
+					_calls.clear();
+					_base_name = 200;
+
+					GLReplay replay(stream);
+					replay.replay(fake_dispatch());
+
+					std::vector<StringT> expected = {
+						"TexImage3D 2 2 3 9",
+						"UseProgram 210",
+						"Uniform2uiv 220 1 7",
+						"UniformMatrix2x3fv 220 1 5",
+						"DeleteProgram 210",
+					};
+
+					examiner << "3D textures, unsigned and non-square matrix uniforms are replayed" << std::endl;
+					examiner.check_equal(_calls.size(), expected.size());
+
+					for (std::size_t i = 0; i < expected.size() && i < _calls.size(); i += 1)
+						examiner.check_equal(_calls[i], expected[i]);
+
+					gl_dispatch = previous;
+				}
+			},
+
+			{"Invalid Input",
+				[](UnitTest::Examiner & examiner) {
+					std::stringstream stream("not a capture");
+
+					bool thrown = false;
+
+					try {
+						GLReplay replay(stream);
+					} catch (std::runtime_error & error) {
+						thrown = true;
+					}
+
+					examiner.check(thrown);
+				}
+			},
+		};
+	}
+}
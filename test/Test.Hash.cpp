@@ -0,0 +1,49 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/Hash.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite HashTestSuite {
+			"Dream::Graphics::Hash",
+
+			{"FNV-1a",
+				[](UnitTest::Examiner & examiner) {
+					// Reference values for the 64-bit FNV-1a hash:
+					examiner.check_equal(Hash().value(), 0xcbf29ce484222325ULL);
+
+					Hash a;
+					a.append(StringT("a"));
+					examiner.check_equal(a.value(), 0xaf63dc4c8601ec8cULL);
+
+					Hash foobar;
+					foobar.append(StringT("foobar"));
+					examiner.check_equal(foobar.value(), 0x85944171f73967e8ULL);
+					examiner.check_equal(foobar.to_hex(), "85944171f73967e8");
+
+					examiner << "Appending in pieces gives the same result" << std::endl;
+					Hash pieces;
+					pieces.append(StringT("foo"));
+					pieces.append(StringT("bar"));
+					examiner.check_equal(pieces.value(), foobar.value());
+				}
+			},
+
+			{"Hexadecimal",
+				[](UnitTest::Examiner & examiner) {
+					Hash hash;
+					hash.append(StringT("a"));
+
+					examiner << "The string has a fixed width" << std::endl;
+					examiner.check_equal(hash.to_hex(), "af63dc4c8601ec8c");
+
+					Hash empty;
+					examiner.check_equal(empty.to_hex().size(), 16);
+				}
+			},
+		};
+	}
+}
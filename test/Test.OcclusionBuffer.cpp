@@ -0,0 +1,156 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/OcclusionBuffer.h>
+#include <Dream/Graphics/BoundingVolumeHierarchy.h>
+
+#include <chrono>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		struct OccluderVertex {
+			Vec3 position;
+		};
+
+		struct OccluderMesh {
+			std::vector<std::uint16_t> indices;
+			std::vector<OccluderVertex> vertices;
+
+			// A square facing the viewer, from min to max on the x and y axes:
+			void add_quad(float min, float max, float z) {
+				std::uint16_t base = (std::uint16_t)vertices.size();
+
+				vertices.push_back({Vec3(min, min, z)});
+				vertices.push_back({Vec3(max, min, z)});
+				vertices.push_back({Vec3(max, max, z)});
+				vertices.push_back({Vec3(min, max, z)});
+
+				std::uint16_t quad[] = {0, 1, 2, 0, 2, 3};
+				for (auto index : quad)
+					indices.push_back(base + index);
+			}
+		};
+
+		static Mat44 identity() {
+			Mat44 matrix;
+
+			for (std::size_t i = 0; i < 16; i += 1)
+				matrix.data()[i] = (i % 5 == 0) ? 1 : 0;
+
+			return matrix;
+		}
+
+		// An orthographic projection of the cube from -10 to 10 on every axis, where smaller z is nearer:
+		static Mat44 view_projection() {
+			Mat44 matrix = identity();
+
+			matrix.data()[0] = matrix.data()[5] = matrix.data()[10] = 0.1f;
+
+			return matrix;
+		}
+
+		static AlignedBox<3> box(float min_x, float min_y, float min_z, float max_x, float max_y, float max_z) {
+			return AlignedBox<3>(Vec3(min_x, min_y, min_z), Vec3(max_x, max_y, max_z));
+		}
+
+		UnitTest::Suite OcclusionBufferTestSuite {
+			"Dream::Graphics::OcclusionBuffer",
+
+			{"Rasterization",
+				[](UnitTest::Examiner & examiner) {
+					OcclusionBuffer occlusion_buffer(Vec2u(64, 32));
+
+					OccluderMesh mesh;
+					mesh.add_quad(-5, 5, -5);
+
+					occlusion_buffer.begin(view_projection());
+					occlusion_buffer.add_occluder(mesh, identity());
+					occlusion_buffer.rasterize(4);
+
+					examiner.check_equal(occlusion_buffer.statistics().triangles, 2);
+
+					examiner << "The occluder covers the center of the buffer" << std::endl;
+					examiner.check(std::abs(occlusion_buffer.depth(32, 16) - 0.25f) < 1e-4f);
+					examiner.check_equal(occlusion_buffer.depth(2, 2), 1.0f);
+
+					examiner << "The top of the hierarchy stores the farthest depth" << std::endl;
+					examiner.check_equal(occlusion_buffer.depth(0, 0, occlusion_buffer.level_count() - 1), 1.0f);
+				}
+			},
+
+			{"Visibility",
+				[](UnitTest::Examiner & examiner) {
+					OcclusionBuffer occlusion_buffer(Vec2u(64, 64));
+
+					OccluderMesh mesh;
+					mesh.add_quad(-5, 5, -5);
+
+					occlusion_buffer.begin(view_projection());
+					occlusion_buffer.add_occluder(mesh, identity());
+					occlusion_buffer.rasterize();
+
+					examiner << "Boxes behind the occluder are hidden" << std::endl;
+					examiner.check(!occlusion_buffer.is_visible(box(-2, -2, 0, 2, 2, 1)));
+
+					examiner << "Boxes in front of the occluder are visible" << std::endl;
+					examiner.check(occlusion_buffer.is_visible(box(-2, -2, -8, 2, 2, -7)));
+
+					examiner << "Boxes which extend past the occluder are visible" << std::endl;
+					examiner.check(occlusion_buffer.is_visible(box(3, -2, 0, 7, 2, 1)));
+
+					examiner.check_equal(occlusion_buffer.statistics().tested, 3);
+					examiner.check_equal(occlusion_buffer.statistics().occluded, 1);
+
+					BoundingVolumeHierarchy hierarchy(0);
+					std::vector<INode> nodes(3);
+
+					hierarchy.insert(&nodes[0], box(-2, -2, 0, 2, 2, 1));
+					hierarchy.insert(&nodes[1], box(-1, -1, 2, 1, 1, 3));
+					hierarchy.insert(&nodes[2], box(-2, -2, -8, 2, 2, -7));
+
+					std::vector<INode *> visible;
+					hierarchy.query(Frustum(view_projection()), occlusion_buffer, visible);
+
+					examiner << "Hidden nodes are culled by the hierarchy" << std::endl;
+					examiner.check_equal(visible.size(), 1);
+					examiner.check_equal(visible[0], &nodes[2]);
+				}
+			},
+
+			{"Dense Scene",
+				[](UnitTest::Examiner & examiner) {
+					typedef std::chrono::high_resolution_clock ClockT;
+
+					OcclusionBuffer occlusion_buffer(Vec2u(256, 128));
+
+					// Many overlapping walls near the viewer:
+					OccluderMesh mesh;
+					for (std::size_t i = 0; i < 500; i += 1)
+						mesh.add_quad(-9.0f + (i % 10) * 0.1f, 9.0f - (i % 7) * 0.1f, -6.0f + (i % 13) * 0.1f);
+
+					auto start = ClockT::now();
+
+					occlusion_buffer.begin(view_projection());
+					occlusion_buffer.add_occluder(mesh, identity());
+					occlusion_buffer.rasterize();
+
+					// A grid of objects behind the walls:
+					std::size_t visible = 0;
+					for (std::size_t i = 0; i < 10000; i += 1) {
+						float x = (float)(i % 100) * 0.17f - 8.5f, y = (float)(i / 100) * 0.17f - 8.5f;
+
+						if (occlusion_buffer.is_visible(box(x, y, 0, x + 0.1f, y + 0.1f, 1)))
+							visible += 1;
+					}
+
+					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					examiner << "Rasterised " << occlusion_buffer.statistics().triangles << " triangles and tested " << occlusion_buffer.statistics().tested << " boxes in " << duration << "us, " << visible << " visible" << std::endl;
+					examiner.check_equal(visible, 0);
+				}
+			},
+		};
+	}
+}
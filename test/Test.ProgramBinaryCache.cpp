@@ -0,0 +1,37 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/ProgramBinaryCache.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+#ifndef DREAM_OPENGLES2
+		UnitTest::Suite ProgramBinaryCacheTestSuite {
+			"Dream::Graphics::ProgramBinaryCache",
+
+			{"Key Stability",
+				[](UnitTest::Examiner & examiner) {
+					HashT driver_hash = ProgramBinaryCache::driver_hash("Mesa", "llvmpipe", "3.2 Mesa", "1.50");
+
+					// Keys name files on disk, so changing how they are derived invalidates every existing cache:
+					examiner << "Keys are the same as in previous versions" << std::endl;
+					examiner.check_equal(driver_hash, 0x959732071fc07bedULL);
+					examiner.check_equal(ProgramBinaryCache::key(driver_hash, 0x0123456789abcdefULL), 0xf88405d55c178f1dULL);
+
+					examiner << "A different driver gives a different key" << std::endl;
+					HashT updated_driver_hash = ProgramBinaryCache::driver_hash("Mesa", "llvmpipe", "3.3 Mesa", "1.50");
+					examiner.check(ProgramBinaryCache::key(updated_driver_hash, 0x0123456789abcdefULL) != ProgramBinaryCache::key(driver_hash, 0x0123456789abcdefULL));
+
+					examiner << "Moving characters between driver strings gives a different key" << std::endl;
+					examiner.check(ProgramBinaryCache::driver_hash("ab", "c", "", "") != ProgramBinaryCache::driver_hash("a", "bc", "", ""));
+
+					examiner << "A different source gives a different key" << std::endl;
+					examiner.check(ProgramBinaryCache::key(driver_hash, 1) != ProgramBinaryCache::key(driver_hash, 2));
+				}
+			},
+		};
+#endif
+	}
+}
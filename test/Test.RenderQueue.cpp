@@ -0,0 +1,69 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/RenderQueue.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite RenderQueueTestSuite {
+			"Dream::Graphics::RenderQueue",
+
+			{"Sort Keys",
+				[](UnitTest::Examiner & examiner) {
+					examiner << "Layers are ordered before everything else" << std::endl;
+					examiner.check(RenderQueue::make_key(0, true, 9, 9, 9, 1.0) < RenderQueue::make_key(1, false, 0, 0, 0, 0.0));
+
+					examiner << "Opaque packets are drawn before translucent packets" << std::endl;
+					examiner.check(RenderQueue::make_key(0, false, 9, 9, 9, 1.0) < RenderQueue::make_key(0, true, 0, 0, 0, 0.0));
+
+					examiner << "Opaque packets are grouped by program before depth" << std::endl;
+					examiner.check(RenderQueue::make_key(0, false, 1, 0, 0, 1.0) < RenderQueue::make_key(0, false, 2, 0, 0, 0.0));
+					examiner.check(RenderQueue::make_key(0, false, 1, 0, 0, 0.25) < RenderQueue::make_key(0, false, 1, 0, 0, 0.75));
+
+					examiner << "Translucent packets are ordered back to front" << std::endl;
+					examiner.check(RenderQueue::make_key(0, true, 2, 0, 0, 0.75) < RenderQueue::make_key(0, true, 1, 0, 0, 0.25));
+				}
+			},
+
+			{"Radix Sort",
+				[](UnitTest::Examiner & examiner) {
+					Ref<RenderQueue> queue = new RenderQueue;
+
+					const std::size_t COUNT = 1000;
+
+					for (std::size_t i = 0; i < COUNT; i += 1) {
+						RenderQueue::Packet packet;
+						packet.layer = (i * 7) % 3;
+						packet.translucent = (i % 5) == 0;
+						packet.depth = ((i * 37) % 101) / 100.0f;
+
+						queue->submit(packet);
+					}
+
+					queue->sort();
+
+					std::size_t count = 0;
+					bool ordered = true;
+					RenderQueue::SortKeyT previous = 0;
+
+					queue->each_sorted([&](const RenderQueue::Packet & packet, RenderQueue::SortKeyT key) {
+						if (key < previous)
+							ordered = false;
+
+						previous = key;
+						count += 1;
+					});
+
+					examiner << "All packets are sorted by key" << std::endl;
+					examiner.check_equal(count, COUNT);
+					examiner.check(ordered);
+
+					examiner << "Passes where all keys share the same digit are skipped" << std::endl;
+					examiner.check(queue->statistics().passes_skipped > 0);
+				}
+			},
+		};
+	}
+}
@@ -0,0 +1,97 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/ShaderManifest.h>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite ShaderManifestTestSuite {
+			"Dream::Graphics::ShaderManifest",
+
+			{"Adding Variants",
+				[](UnitTest::Examiner & examiner) {
+					Ref<ShaderManifest> manifest = new ShaderManifest;
+					ShaderManifest::DefinesMapT defines{{"LIGHTING", "1"}}, empty;
+
+					examiner << "Variants are only listed once" << std::endl;
+					examiner.check(manifest->add("Shaders/surface", &defines));
+					examiner.check(!manifest->add("Shaders/surface", &defines));
+
+					examiner << "No defines and empty defines are the same variant" << std::endl;
+					examiner.check(manifest->add("Shaders/surface"));
+					examiner.check(!manifest->add("Shaders/surface", &empty));
+
+					examiner.check_equal(manifest->size(), 2);
+				}
+			},
+
+			{"Round Trip",
+				[](UnitTest::Examiner & examiner) {
+					Ref<ShaderManifest> manifest = new ShaderManifest;
+					ShaderManifest::DefinesMapT defines{{"LIGHTING", "1"}, {"COLOR", "vec3(1.0, 0.5, 0.0)"}};
+
+					manifest->add("Shaders/surface", &defines);
+					manifest->add("Shaders/sky");
+
+					std::stringstream buffer;
+					manifest->write(buffer);
+
+					examiner << "Variants are written one per line" << std::endl;
+					examiner.check_equal(buffer.str(), "Shaders/surface\tCOLOR=vec3(1.0, 0.5, 0.0)\tLIGHTING=1\nShaders/sky\n");
+
+					Ref<ShaderManifest> parsed = new ShaderManifest;
+					std::stringstream input("# Recorded variants\n\n" + buffer.str());
+					parsed->parse(input);
+
+					examiner << "Parsed manifest contains the same variants" << std::endl;
+					examiner.check_equal(parsed->size(), 2);
+					examiner.check(parsed->entries()[0].defines == defines);
+					examiner.check(parsed->entries()[1].defines.empty());
+				}
+			},
+
+			{"Recording",
+				[](UnitTest::Examiner & examiner) {
+					StringT path = "shader-manifest-test.txt";
+					std::remove(path.c_str());
+
+					Ref<ShaderManifest> manifest = new ShaderManifest;
+					manifest->record(path);
+					manifest->add("Shaders/surface");
+
+					examiner << "Loading the recording doesn't append its variants again" << std::endl;
+					manifest->load(path);
+					manifest->add("Shaders/sky");
+
+					std::ifstream input(path);
+					std::stringstream buffer;
+					buffer << input.rdbuf();
+
+					examiner.check_equal(buffer.str(), "Shaders/surface\nShaders/sky\n");
+
+					std::remove(path.c_str());
+				}
+			},
+
+			{"Malformed Defines",
+				[](UnitTest::Examiner & examiner) {
+					Ref<ShaderManifest> manifest = new ShaderManifest;
+					std::stringstream input("Shaders/surface\tLIGHTING\n");
+
+					bool thrown = false;
+
+					try {
+						manifest->parse(input);
+					} catch (std::runtime_error &) {
+						thrown = true;
+					}
+
+					examiner << "A define without a value is rejected" << std::endl;
+					examiner.check(thrown);
+				}
+			},
+		};
+	}
+}
@@ -3,6 +3,8 @@
 
 #include <Dream/Graphics/ShaderParser.h>
 
+#include <chrono>
+
 namespace Dream
 {
 	namespace Graphics
@@ -14,7 +16,87 @@ namespace Dream
 			"void main() { vertex(); }\n"
 			"@fragment\n"
 			"void main() { fragment(); }\n";
+
+		const char * IncludeShader =
+			"@shader\n"
+			"#version 330\n"
+			"@vertex\n"
+			"@include \"lighting.glsl\"\n"
+			"void main() { vertex(); }\n"
+			"@fragment\n"
+			"@include \"lighting.glsl\"\n"
+			"void main() { fragment(); }\n";
+
+		const char * LightingInclude =
+			"@include \"common.glsl\"\n"
+			"vec3 lighting() { return common(); }\n";
+
+		const char * CommonInclude =
+			"vec3 common() { return vec3(1.0); }\n";
+
+		static std::size_t resolved_count = 0;
+
+		static Shared<Buffer> resolve_include(const std::string & path)
+		{
+			resolved_count += 1;
+
+			if (path == "lighting.glsl")
+				return std::make_shared<StaticBuffer>(StaticBuffer::for_cstring(LightingInclude));
+			else if (path == "common.glsl")
+				return std::make_shared<StaticBuffer>(StaticBuffer::for_cstring(CommonInclude));
+			else if (path == "recursive.glsl")
+				return std::make_shared<StaticBuffer>(StaticBuffer::for_cstring("@include \"recursive.glsl\"\n"));
+			else
+				return nullptr;
+		}
 		
+		// A shader with the given number of lines in each stage:
+		static std::string generate_shader(std::size_t line_count)
+		{
+			std::string source = "@shader\n#version 330\n";
+
+			for (auto stage : {"@vertex\n", "@fragment\n"}) {
+				source += stage;
+
+				for (std::size_t i = 0; i < line_count; i += 1)
+					source += "float value" + std::to_string(i) + " = sin(float(" + std::to_string(i) + ") * 0.5) + cos(time);\n";
+			}
+
+			return source;
+		}
+
+		// The previous implementation: each line is copied into a stringstream, the stage is copied again into the full buffer, and once more into a contiguous buffer for the driver:
+		static std::size_t legacy_parse(const std::string & shader)
+		{
+			std::istringstream input_stream(shader);
+			std::map<int, std::stringstream> source_buffers;
+			std::stringstream * current_source = &source_buffers[0];
+
+			std::string line_buffer;
+			std::getline(input_stream, line_buffer);
+
+			while (std::getline(input_stream, line_buffer)) {
+				if (line_buffer.find("@vertex") == 0)
+					current_source = &source_buffers[1];
+				else if (line_buffer.find("@fragment") == 0)
+					current_source = &source_buffers[2];
+				else
+					(*current_source) << line_buffer << std::endl;
+			}
+
+			std::size_t total = 0;
+
+			for (int stage = 1; stage <= 2; stage += 1) {
+				std::stringstream full_buffer;
+				full_buffer << source_buffers[0].str() << source_buffers[stage].str();
+
+				std::string data = full_buffer.str();
+				total += data.size();
+			}
+
+			return total;
+		}
+
 		UnitTest::Suite ShaderParserTestSuite {
 			"Dream::Graphics::ShaderParser",
 
@@ -30,6 +112,146 @@ namespace Dream
 					examiner.check_equal(source_buffers.size(), 3);
 				}
 			},
+
+			{"Line Numbers",
+				[](UnitTest::Examiner & examiner) {
+					StaticBuffer buffer = StaticBuffer::for_cstring(BasicShader);
+
+					ShaderParser parser(buffer);
+
+					std::stringstream fragment;
+					parser.full_buffer(fragment, ShaderParser::SourceType::FRAGMENT);
+
+					examiner << "Fragment source begins on line 6 of the main file" << std::endl;
+					examiner.check(fragment.str().find("#line 6 0\nvoid main() { fragment(); }") != std::string::npos);
+				}
+			},
+
+			{"Includes",
+				[](UnitTest::Examiner & examiner) {
+					StaticBuffer buffer = StaticBuffer::for_cstring(IncludeShader);
+					auto chunk_cache = std::make_shared<ShaderParser::ChunkCache>();
+
+					resolved_count = 0;
+					ShaderParser parser(buffer, resolve_include, chunk_cache);
+
+					examiner << "Each included file was only loaded once" << std::endl;
+					examiner.check_equal(resolved_count, 2);
+					examiner.check_equal(chunk_cache->size(), 2);
+
+					examiner << "Transitive includes are dependencies" << std::endl;
+					examiner.check_equal(parser.dependencies().size(), 2);
+					examiner.check_equal(parser.files().size(), 3);
+
+					std::stringstream vertex;
+					parser.full_buffer(vertex, ShaderParser::SourceType::VERTEX);
+
+					examiner << "Included source is expanded with line directives" << std::endl;
+					examiner.check(vertex.str().find("#line 1 2\nvec3 common()") != std::string::npos);
+					examiner.check(vertex.str().find("#line 2 1\nvec3 lighting()") != std::string::npos);
+					examiner.check(vertex.str().find("#line 5 0\nvoid main() { vertex(); }") != std::string::npos);
+
+					examiner << "A second parser reuses the cached chunks" << std::endl;
+					ShaderParser second_parser(buffer, resolve_include, chunk_cache);
+					examiner.check_equal(resolved_count, 2);
+
+					examiner << "Invalidating an include also invalidates files which include it" << std::endl;
+					examiner.check_equal(chunk_cache->invalidate("common.glsl").size(), 2);
+					examiner.check_equal(chunk_cache->size(), 0);
+				}
+			},
+
+			{"Recursive Includes",
+				[](UnitTest::Examiner & examiner) {
+					StaticBuffer buffer = StaticBuffer::for_cstring("@shader\n@vertex\n@include \"recursive.glsl\"\n");
+
+					bool thrown = false;
+
+					try {
+						ShaderParser parser(buffer, resolve_include);
+					} catch (ShaderParser::ParseError &) {
+						thrown = true;
+					}
+
+					examiner << "Recursive include was detected" << std::endl;
+					examiner.check(thrown);
+				}
+			},
+
+			{"Hashing",
+				[](UnitTest::Examiner & examiner) {
+					StaticBuffer buffer = StaticBuffer::for_cstring(BasicShader);
+
+					ShaderParser parser(buffer);
+					ShaderParser::DefinesMapT defines{{"LIGHTING", "1"}};
+
+					examiner << "Stages and defines produce distinct hashes" << std::endl;
+					examiner.check(parser.hash(ShaderParser::SourceType::VERTEX) != parser.hash(ShaderParser::SourceType::FRAGMENT));
+					examiner.check(parser.hash(ShaderParser::SourceType::VERTEX) != parser.hash(ShaderParser::SourceType::VERTEX, &defines));
+
+					examiner << "Hashes are stable" << std::endl;
+					examiner.check_equal(parser.hash(ShaderParser::SourceType::VERTEX), ShaderParser(buffer).hash(ShaderParser::SourceType::VERTEX));
+				}
+			},
+
+			{"Assembly",
+				[](UnitTest::Examiner & examiner) {
+					StaticBuffer buffer = StaticBuffer::for_cstring(BasicShader);
+
+					ShaderParser parser(buffer);
+					ShaderParser::DefinesMapT defines{{"LIGHTING", "1"}};
+
+					ShaderParser::Source source;
+					parser.assemble(source, ShaderParser::SourceType::VERTEX, &defines);
+
+					std::stringstream assembled, full_buffer;
+					source.write(assembled);
+					parser.full_buffer(full_buffer, ShaderParser::SourceType::VERTEX, &defines);
+
+					examiner << "Assembled strings match the full buffer" << std::endl;
+					examiner.check_equal(assembled.str(), "#version 330\n#define LIGHTING 1\n#line 4 0\nvoid main() { vertex(); }\n");
+					examiner.check_equal(assembled.str(), full_buffer.str());
+					examiner.check_equal(source.size(), assembled.str().size());
+				}
+			},
+
+			{"Parsing Performance",
+				[](UnitTest::Examiner & examiner) {
+					const std::size_t ITERATIONS = 20;
+					std::string shader = generate_shader(20000);
+
+					typedef std::chrono::high_resolution_clock ClockT;
+
+					std::size_t legacy_total = 0, total = 0;
+
+					auto start = ClockT::now();
+					for (std::size_t i = 0; i < ITERATIONS; i += 1)
+						legacy_total += legacy_parse(shader);
+					auto legacy_duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					ShaderParser::Source source;
+					std::size_t string_count = 0;
+
+					start = ClockT::now();
+					for (std::size_t i = 0; i < ITERATIONS; i += 1) {
+						ShaderParser parser(StaticBuffer((const ByteT *)shader.data(), shader.size()));
+
+						for (auto type : {ShaderParser::SourceType::VERTEX, ShaderParser::SourceType::FRAGMENT}) {
+							parser.assemble(source, type);
+
+							total += source.size();
+							string_count = source.count();
+						}
+					}
+					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					examiner << "Parsed " << shader.size() << " bytes " << ITERATIONS << " times: stringstream " << legacy_duration << "us, slices " << duration << "us" << std::endl;
+
+					examiner << "Each stage is passed to the driver as a few large strings" << std::endl;
+					examiner.check(string_count <= 3);
+					examiner.check(total > 0 && legacy_total > 0);
+				}
+			},
 		};
 	}
 }
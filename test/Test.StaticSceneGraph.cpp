@@ -0,0 +1,158 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/StaticSceneGraph.h>
+#include <Dream/Graphics/Renderer.h>
+
+#include <chrono>
+#include <cmath>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		struct PointNode {
+			float position[3];
+		};
+
+		struct WeightedNode {
+			float position[3];
+			float weight;
+		};
+
+		class SummingRenderer : public StaticRenderer<SummingRenderer> {
+		public:
+			double total = 0;
+
+			void render(PointNode & node) {
+				total += node.position[0] + node.position[1] + node.position[2];
+			}
+
+			void render(WeightedNode & node) {
+				total += (node.position[0] + node.position[1] + node.position[2]) * node.weight;
+			}
+		};
+
+		// The same scene, using the existing virtual interfaces. IRenderer::render only receives an INode, so the renderer must recover the node type itself:
+		class VirtualPointNode : public INode {
+		public:
+			PointNode point;
+
+			VirtualPointNode(const PointNode & point_) : point(point_) {}
+		};
+
+		class VirtualWeightedNode : public INode {
+		public:
+			WeightedNode weighted;
+
+			VirtualWeightedNode(const WeightedNode & weighted_) : weighted(weighted_) {}
+		};
+
+		class VirtualGroupNode : public INode {
+		public:
+			std::vector<INode *> children;
+
+			virtual void traverse(IRenderer * renderer) {
+				for (auto child : children)
+					child->accept(renderer);
+			}
+		};
+
+		class VirtualSummingRenderer : public IRenderer {
+		public:
+			double total = 0;
+
+			virtual void render(INode * node) {
+				if (auto point_node = dynamic_cast<VirtualPointNode *>(node)) {
+					PointNode & point = point_node->point;
+					total += point.position[0] + point.position[1] + point.position[2];
+				} else if (auto weighted_node = dynamic_cast<VirtualWeightedNode *>(node)) {
+					WeightedNode & weighted = weighted_node->weighted;
+					total += (weighted.position[0] + weighted.position[1] + weighted.position[2]) * weighted.weight;
+				}
+
+				node->traverse(this);
+			}
+		};
+
+		UnitTest::Suite StaticSceneGraphTestSuite {
+			"Dream::Graphics::StaticSceneGraph",
+
+			{"Storage",
+				[](UnitTest::Examiner & examiner) {
+					StaticSceneGraph<PointNode, WeightedNode> graph;
+
+					auto point = graph.add(PointNode{{1, 2, 3}});
+					graph.add(WeightedNode{{1, 1, 1}, 2});
+					graph.add(PointNode{{4, 5, 6}});
+
+					examiner << "Nodes are stored per type" << std::endl;
+					examiner.check_equal(graph.size(), 3);
+					examiner.check_equal(graph.nodes<PointNode>().size(), 2);
+					examiner.check_equal(graph.nodes<WeightedNode>().size(), 1);
+					examiner.check_equal(graph[point].position[2], 3);
+
+					SummingRenderer renderer;
+					renderer.traverse(graph);
+
+					examiner << "Every node was rendered" << std::endl;
+					examiner.check_equal(renderer.total, 27);
+
+					graph.clear();
+					examiner.check_equal(graph.size(), 0);
+				}
+			},
+
+			{"Dispatch Performance",
+				[](UnitTest::Examiner & examiner) {
+					const std::size_t COUNT = 1000000;
+
+					typedef std::chrono::high_resolution_clock ClockT;
+
+					StaticSceneGraph<PointNode, WeightedNode> graph;
+					graph.reserve<PointNode>(COUNT / 2);
+					graph.reserve<WeightedNode>(COUNT / 2);
+
+					std::vector<VirtualPointNode> point_nodes;
+					std::vector<VirtualWeightedNode> weighted_nodes;
+					point_nodes.reserve(COUNT / 2);
+					weighted_nodes.reserve(COUNT / 2);
+
+					for (std::size_t i = 0; i < COUNT / 2; i += 1) {
+						float value = (i % 100) / 100.0f;
+
+						graph.add(PointNode{{value, value, value}});
+						graph.add(WeightedNode{{value, value, value}, 0.5f});
+
+						point_nodes.push_back(VirtualPointNode(PointNode{{value, value, value}}));
+						weighted_nodes.push_back(VirtualWeightedNode(WeightedNode{{value, value, value}, 0.5f}));
+					}
+
+					// Interleave the virtual nodes, as they would typically be in a scene:
+					VirtualGroupNode root;
+					root.children.reserve(COUNT);
+					for (std::size_t i = 0; i < COUNT / 2; i += 1) {
+						root.children.push_back(&point_nodes[i]);
+						root.children.push_back(&weighted_nodes[i]);
+					}
+
+					VirtualSummingRenderer virtual_renderer;
+					auto start = ClockT::now();
+					virtual_renderer.traverse(&root);
+					auto virtual_duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					SummingRenderer renderer;
+					start = ClockT::now();
+					renderer.traverse(graph);
+					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					examiner << "Visited " << COUNT << " nodes: virtual " << virtual_duration << "us, static " << duration << "us" << std::endl;
+
+					examiner << "Both paths rendered the same scene" << std::endl;
+					examiner.check_equal(graph.size(), COUNT);
+					examiner.check(std::abs(renderer.total - virtual_renderer.total) < 1e-3 * renderer.total);
+				}
+			},
+		};
+	}
+}
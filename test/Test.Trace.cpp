@@ -0,0 +1,118 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/Trace.h>
+
+#include <sstream>
+#include <thread>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		UnitTest::Suite TraceTestSuite {
+			"Dream::Graphics::Trace",
+
+			{"Ring",
+				[](UnitTest::Examiner & examiner) {
+					Trace::Ring ring(3, 1);
+
+					examiner << "The capacity is rounded up to a power of two" << std::endl;
+					for (std::size_t i = 0; i < 4; i += 1)
+						examiner.check(ring.push(Trace::Event{"event", i, i + 1}));
+
+					examiner << "Events are dropped when the ring is full" << std::endl;
+					examiner.check(!ring.push(Trace::Event{"event", 4, 5}));
+					examiner.check_equal(ring.dropped(), 1);
+
+					std::vector<Trace::Event> events;
+					examiner.check_equal(ring.drain(events), 4);
+					examiner.check_equal(events[3].begin, 3);
+
+					examiner.check(ring.push(Trace::Event{"event", 5, 6}));
+					examiner.check_equal(ring.drain(events), 1);
+				}
+			},
+
+			{"Zones",
+				[](UnitTest::Examiner & examiner) {
+					Trace::set_enabled(true);
+
+					auto work = [](std::size_t count) {
+						for (std::size_t i = 0; i < count; i += 1) {
+							Trace::Zone zone("Test::work");
+						}
+					};
+
+					std::thread thread(work, 100);
+					work(50);
+					thread.join();
+
+					{
+						Trace::set_enabled(false);
+						Trace::Zone zone("Test::disabled");
+					}
+
+					std::stringstream output;
+					Trace::write(output);
+
+					StringT trace = output.str();
+
+					std::size_t count = 0;
+					for (std::size_t offset = trace.find("Test::work"); offset != StringT::npos; offset = trace.find("Test::work", offset + 1))
+						count += 1;
+
+					examiner << "Zones from every thread were written" << std::endl;
+					examiner.check_equal(count, 150);
+					examiner.check(trace.find("Test::disabled") == StringT::npos);
+					examiner.check(trace.find("\"ph\":\"X\"") != StringT::npos);
+
+					std::stringstream empty;
+					Trace::write(empty);
+
+					examiner << "Writing drains the rings" << std::endl;
+					examiner.check(empty.str().find("Test::work") == StringT::npos);
+				}
+			},
+
+			{"Short Lived Threads",
+				[](UnitTest::Examiner & examiner) {
+					Trace::set_enabled(true);
+
+					// Make sure the calling thread has a ring, so that only worker rings are counted below:
+					Trace::ring();
+
+					std::size_t ring_count = 0;
+
+					for (std::size_t frame = 0; frame < 10; frame += 1) {
+						std::thread thread([]{
+							Trace::Zone zone("Test::frame");
+						});
+
+						thread.join();
+
+						if (frame == 0)
+							ring_count = Trace::ring_count();
+					}
+
+					Trace::set_enabled(false);
+
+					examiner << "Rings of exited threads are reused" << std::endl;
+					examiner.check_equal(Trace::ring_count(), ring_count);
+
+					std::stringstream output;
+					Trace::write(output);
+
+					StringT trace = output.str();
+
+					std::size_t count = 0;
+					for (std::size_t offset = trace.find("Test::frame"); offset != StringT::npos; offset = trace.find("Test::frame", offset + 1))
+						count += 1;
+
+					examiner << "Events recorded before a ring was reused are kept" << std::endl;
+					examiner.check_equal(count, 10);
+				}
+			},
+		};
+	}
+}
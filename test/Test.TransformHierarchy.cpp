@@ -0,0 +1,260 @@
+
+#include <UnitTest/UnitTest.h>
+
+#include <Dream/Graphics/TransformHierarchy.h>
+
+#include <chrono>
+#include <cmath>
+
+namespace Dream
+{
+	namespace Graphics
+	{
+		static bool close(float a, float b) {
+			return std::abs(a - b) < 1e-4f;
+		}
+
+		static TransformHierarchy::Local translation(float x, float y, float z) {
+			return TransformHierarchy::Local(Vec3(x, y, z), Vec4(0, 0, 0, 1), Vec3(1, 1, 1));
+		}
+
+		UnitTest::Suite TransformHierarchyTestSuite {
+			"Dream::Graphics::TransformHierarchy",
+
+			{"Composition",
+				[](UnitTest::Examiner & examiner) {
+					TransformHierarchy hierarchy;
+
+					// Rotate a quarter turn about the z axis and double the size:
+					float s = std::sqrt(0.5f);
+					auto root = hierarchy.create(TransformHierarchy::NONE, TransformHierarchy::Local(Vec3(10, 0, 0), Vec4(0, 0, s, s), Vec3(2, 2, 2)));
+					auto child = hierarchy.create(root, translation(1, 0, 0));
+
+					hierarchy.update();
+
+					const float * world = hierarchy.world_matrix(child).data();
+
+					examiner << "The child is offset along the rotated and scaled x axis" << std::endl;
+					examiner.check(close(world[12], 10));
+					examiner.check(close(world[13], 2));
+					examiner.check(close(world[14], 0));
+					examiner.check_equal(hierarchy.updated_count(), 2);
+				}
+			},
+
+			{"Dirty Subtrees",
+				[](UnitTest::Examiner & examiner) {
+					TransformHierarchy hierarchy;
+
+					auto root = hierarchy.create(TransformHierarchy::NONE, translation(1, 0, 0));
+					auto middle = hierarchy.create(root, translation(0, 1, 0));
+					auto leaf = hierarchy.create(middle, translation(0, 0, 1));
+					hierarchy.create(root, translation(0, 0, 0));
+
+					hierarchy.update();
+					examiner.check_equal(hierarchy.updated_count(), 4);
+
+					hierarchy.update();
+					examiner << "Nothing is recomputed when nothing changed" << std::endl;
+					examiner.check_equal(hierarchy.updated_count(), 0);
+
+					hierarchy.set_local(middle, translation(0, 5, 0));
+					hierarchy.update();
+
+					examiner << "Only the changed node and its descendants are recomputed" << std::endl;
+					examiner.check_equal(hierarchy.updated_count(), 2);
+					examiner.check(close(hierarchy.world_matrix(leaf).data()[13], 5));
+					examiner.check(close(hierarchy.world_matrix(leaf).data()[14], 1));
+				}
+			},
+
+			{"Reparenting",
+				[](UnitTest::Examiner & examiner) {
+					TransformHierarchy hierarchy;
+
+					auto child = hierarchy.create(TransformHierarchy::NONE, translation(1, 0, 0));
+					auto grandchild = hierarchy.create(child, translation(1, 0, 0));
+					auto parent = hierarchy.create(TransformHierarchy::NONE, translation(0, 3, 0));
+
+					// The new parent comes after the child, so the arrays must be reordered:
+					hierarchy.set_parent(child, parent);
+					hierarchy.update();
+
+					examiner.check_equal(hierarchy.parent(child), parent);
+					examiner.check(close(hierarchy.world_matrix(grandchild).data()[12], 2));
+					examiner.check(close(hierarchy.world_matrix(grandchild).data()[13], 3));
+
+					hierarchy.destroy(child);
+
+					examiner << "Destroying a node removes its descendants" << std::endl;
+					examiner.check_equal(hierarchy.size(), 1);
+					examiner.check(close(hierarchy.world_matrix(parent).data()[13], 3));
+
+					// Handles are reused:
+					auto other = hierarchy.create(parent, translation(0, 0, 2));
+					hierarchy.update();
+					examiner.check(close(hierarchy.world_matrix(other).data()[14], 2));
+				}
+			},
+
+			{"Node Lifetime",
+				[](UnitTest::Examiner & examiner) {
+					Ref<TransformHierarchy> hierarchy = new TransformHierarchy;
+
+					TransformNode * parent = new TransformNode(hierarchy);
+					parent->set_local(translation(0, 3, 0));
+
+					TransformNode * child = new TransformNode(hierarchy, parent->transform());
+					child->set_local(translation(1, 0, 0));
+
+					// Destroying the parent first leaves the child attached to the root:
+					delete parent;
+					hierarchy->update();
+
+					examiner.check_equal(hierarchy->size(), 1);
+					examiner.check_equal(hierarchy->parent(child->transform()), TransformHierarchy::NONE);
+					examiner.check(close(child->world_matrix().data()[12], 1));
+					examiner.check(close(child->world_matrix().data()[13], 0));
+
+					// A node created after a destroyed subtree may reuse its handles:
+					auto root = hierarchy->create();
+					auto descendant = hierarchy->create(root);
+					hierarchy->destroy(root);
+					hierarchy->destroy(descendant);
+
+					examiner << "Destroying a handle twice has no effect" << std::endl;
+					examiner.check_equal(hierarchy->size(), 1);
+
+					delete child;
+					examiner.check_equal(hierarchy->size(), 0);
+				}
+			},
+
+			{"Deferred Removal",
+				[](UnitTest::Examiner & examiner) {
+					TransformHierarchy hierarchy;
+
+					auto root = hierarchy.create(TransformHierarchy::NONE, translation(0, 3, 0));
+					auto a = hierarchy.create(root, translation(1, 0, 0));
+					auto b = hierarchy.create(a, translation(1, 0, 0));
+					auto leaf = hierarchy.create(b, translation(0, 0, 1));
+					hierarchy.update();
+
+					hierarchy.remove(a);
+					hierarchy.remove(b);
+
+					examiner << "Removed nodes are skipped before the arrays are compacted" << std::endl;
+					examiner.check_equal(hierarchy.size(), 2);
+					examiner.check_equal(hierarchy.parent(leaf), root);
+
+					hierarchy.update();
+
+					examiner.check_equal(hierarchy.parent(leaf), root);
+					examiner.check(close(hierarchy.world_matrix(leaf).data()[12], 0));
+					examiner.check(close(hierarchy.world_matrix(leaf).data()[13], 3));
+					examiner.check(close(hierarchy.world_matrix(leaf).data()[14], 1));
+
+					examiner << "Destroying a subtree also drops nodes which were already removed" << std::endl;
+					hierarchy.create(leaf);
+					hierarchy.remove(leaf);
+					hierarchy.destroy(root);
+					examiner.check_equal(hierarchy.size(), 0);
+
+					hierarchy.update();
+					examiner.check_equal(hierarchy.size(), 0);
+				}
+			},
+
+			{"Teardown Performance",
+				[](UnitTest::Examiner & examiner) {
+					const std::size_t COUNT = 50000;
+
+					typedef std::chrono::high_resolution_clock ClockT;
+
+					TransformHierarchy hierarchy;
+					std::vector<TransformHierarchy::HandleT> handles;
+					handles.reserve(COUNT);
+
+					for (std::size_t i = 0; i < COUNT; i += 1) {
+						auto parent = (i % 10 == 0) ? TransformHierarchy::NONE : handles.back();
+						handles.push_back(hierarchy.create(parent, translation(0.1f, 0, 0)));
+					}
+
+					hierarchy.update();
+
+					// Removing nodes one at a time, as TransformNode does when a scene is destroyed:
+					auto start = ClockT::now();
+					for (auto handle : handles)
+						hierarchy.remove(handle);
+
+					hierarchy.update();
+					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					examiner << "Removed " << COUNT << " nodes in " << duration << "us" << std::endl;
+					examiner.check_equal(hierarchy.size(), 0);
+				}
+			},
+
+			{"Multiplication",
+				[](UnitTest::Examiner & examiner) {
+					Mat44 a, b, result;
+
+					for (std::size_t i = 0; i < 16; i += 1) {
+						a.data()[i] = (float)(i + 1);
+						b.data()[i] = (float)(16 - i) * 0.5f;
+					}
+
+					TransformHierarchy::multiply(result, a, b);
+
+					bool matches = true;
+					for (std::size_t j = 0; j < 4; j += 1) {
+						for (std::size_t i = 0; i < 4; i += 1) {
+							float value = 0;
+
+							for (std::size_t k = 0; k < 4; k += 1)
+								value += a.data()[k * 4 + i] * b.data()[j * 4 + k];
+
+							if (!close(result.data()[j * 4 + i], value))
+								matches = false;
+						}
+					}
+
+					examiner << "The batched multiply matches the scalar reference" << std::endl;
+					examiner.check(matches);
+				}
+			},
+
+			{"Update Performance",
+				[](UnitTest::Examiner & examiner) {
+					const std::size_t COUNT = 50000;
+
+					typedef std::chrono::high_resolution_clock ClockT;
+
+					TransformHierarchy hierarchy;
+					std::vector<TransformHierarchy::HandleT> handles;
+					handles.reserve(COUNT);
+
+					// A forest of short chains, similar to skeletons:
+					for (std::size_t i = 0; i < COUNT; i += 1) {
+						auto parent = (i % 10 == 0) ? TransformHierarchy::NONE : handles.back();
+						handles.push_back(hierarchy.create(parent, translation(0.1f, 0, 0)));
+					}
+
+					hierarchy.update();
+
+					// Animate every node:
+					auto start = ClockT::now();
+					for (std::size_t i = 0; i < COUNT; i += 1)
+						hierarchy.set_local(handles[i], translation(0.1f, (float)(i % 7), 0));
+
+					hierarchy.update();
+					auto duration = std::chrono::duration_cast<std::chrono::microseconds>(ClockT::now() - start).count();
+
+					examiner << "Updated " << hierarchy.updated_count() << " animated nodes in " << duration << "us" << std::endl;
+					examiner.check_equal(hierarchy.updated_count(), COUNT);
+					examiner.check(close(hierarchy.world_matrix(handles[9]).data()[12], 1.0f));
+				}
+			},
+		};
+	}
+}